@@ -0,0 +1,108 @@
+#include "tp_qt_maps_widget/EditMaterialWidget.h"
+
+#include <QApplication>
+#include <QPushButton>
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+
+// Times creating an EditMaterialWidget with its sections built lazily, against expanding every
+// section straight away which builds all of the rows as the editor did before sections were lazy.
+//
+// Show includes processing the events that lay out and polish the widget.
+//
+// Usage: tp_qt_maps_widget_edit_material_widget_startup [repeats]
+
+namespace
+{
+
+//##################################################################################################
+//! Expand every collapsed section, which builds its rows.
+void expandAll_lt(tp_qt_maps_widget::EditMaterialWidget& widget)
+{
+  for(auto button : widget.findChildren<QPushButton*>())
+    if(button->isCheckable() && !button->isChecked())
+      button->setChecked(true);
+}
+
+//##################################################################################################
+template<typename F>
+void time_lt(const char* name, size_t repeats, const F& f)
+{
+  double best = std::numeric_limits<double>::max();
+  double total = 0.0;
+  for(size_t r=0; r<repeats; r++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    best = std::min(best, ms);
+    total += ms;
+  }
+
+  std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(12) << best
+            << std::setw(12) << (total/double(repeats)) << '\n';
+}
+}
+
+//##################################################################################################
+int main(int argc, char* argv[])
+{
+  QApplication app(argc, argv);
+
+  size_t repeats = 20;
+  if(argc>1)
+    repeats = size_t(std::max(1, std::atoi(argv[1])));
+
+  tp_math_utils::Material material;
+  material.findOrAddOpenGL();
+  material.findOrAddLegacy();
+
+  using namespace tp_qt_maps_widget;
+
+  std::cout << std::left << std::setw(28) << "" << std::right
+            << std::setw(12) << "best ms" << std::setw(12) << "mean ms" << '\n';
+
+  // The first widget loads icons and styles that are cached, so make one before timing.
+  {
+    EditMaterialWidget widget;
+    expandAll_lt(widget);
+  }
+
+  time_lt("lazy construct", repeats, [&]
+  {
+    EditMaterialWidget widget;
+    widget.setMaterial(material);
+  });
+
+  time_lt("lazy construct + show", repeats, [&]
+  {
+    EditMaterialWidget widget;
+    widget.setMaterial(material);
+    widget.show();
+    QCoreApplication::processEvents();
+  });
+
+  time_lt("eager construct", repeats, [&]
+  {
+    EditMaterialWidget widget;
+    expandAll_lt(widget);
+    widget.setMaterial(material);
+  });
+
+  time_lt("eager construct + show", repeats, [&]
+  {
+    EditMaterialWidget widget;
+    expandAll_lt(widget);
+    widget.setMaterial(material);
+    widget.show();
+    QCoreApplication::processEvents();
+  });
+
+  return 0;
+}
@@ -0,0 +1,4 @@
+TARGET = tp_qt_maps_widget_edit_material_widget_startup
+TEMPLATE = app
+
+SOURCES += src/main.cpp
@@ -0,0 +1,2 @@
+QT += core gui widgets
+DEPENDENCIES += tp_qt_maps_widget
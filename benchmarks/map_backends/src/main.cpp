@@ -0,0 +1,103 @@
+#include "tp_qt_maps_widget/MapWidget.h"
+#include "tp_qt_maps_widget/MapWindow.h"
+
+#include <QApplication>
+#include <QMouseEvent>
+#include <QTimer>
+#include <QEventLoop>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+
+// Draws the same empty map through MapWidget and MapWindow and compares their frame timings.
+//
+// Each frame a synthetic mouse move is sent to the backend and a repaint requested, so
+// inputLatencyMS measures the time from the map handling input until that frame is presented.
+//
+// Usage: tp_qt_maps_widget_map_backends [frames]
+
+namespace
+{
+
+//##################################################################################################
+void printSummary_lt(const char* name, const tp_qt_maps_widget::FrameTimingSummary& s)
+{
+  std::cout << "  " << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(3)
+            << " n=" << std::setw(5) << s.count
+            << " min=" << std::setw(8) << s.min
+            << " avg=" << std::setw(8) << s.avg
+            << " p95=" << std::setw(8) << s.p95
+            << " p99=" << std::setw(8) << s.p99 << '\n';
+}
+
+//##################################################################################################
+void printStats_lt(const char* backend, const tp_qt_maps_widget::FrameTimingStats& stats)
+{
+  std::cout << backend << " (ms)\n";
+  printSummary_lt("cpu animate",   stats.cpuAnimate);
+  printSummary_lt("cpu paint",     stats.cpuPaint);
+  printSummary_lt("gpu paint",     stats.gpuPaint);
+  printSummary_lt("present",       stats.present);
+  printSummary_lt("input latency", stats.inputLatency);
+}
+
+//##################################################################################################
+template<typename T, typename Target>
+tp_qt_maps_widget::FrameTimingStats run_lt(T* backend, Target* target, size_t frames)
+{
+  backend->setFrameTimingEnabled(true);
+  backend->frameTimings().setCapacity(frames);
+  backend->resize(1280, 720);
+
+  size_t timed=0;
+  QEventLoop loop;
+  QObject::connect(backend, &T::frameTimed, &loop, [&]
+  {
+    timed++;
+    if(timed>=frames)
+      loop.quit();
+  });
+
+  QTimer driver;
+  driver.setInterval(0);
+  QObject::connect(&driver, &QTimer::timeout, &loop, [&]
+  {
+    QPointF pos(double(timed%1280), 360.0);
+    QMouseEvent event(QEvent::MouseMove, pos, pos, Qt::NoButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(target, &event);
+    backend->map()->update();
+  });
+
+  backend->show();
+  driver.start();
+  loop.exec();
+  driver.stop();
+  backend->hide();
+
+  return backend->frameTimingStats(frames);
+}
+}
+
+//##################################################################################################
+int main(int argc, char* argv[])
+{
+  QApplication app(argc, argv);
+
+  size_t frames = 600;
+  if(argc>1)
+    frames = size_t(std::max(1, std::atoi(argv[1])));
+
+  {
+    tp_qt_maps_widget::MapWidget widget;
+    printStats_lt("MapWidget", run_lt(&widget, &widget, frames));
+  }
+
+  {
+    tp_qt_maps_widget::MapWindow window;
+    printStats_lt("MapWindow", run_lt(&window, &window, frames));
+  }
+
+  return 0;
+}
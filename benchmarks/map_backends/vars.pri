@@ -0,0 +1,4 @@
+TARGET = tp_qt_maps_widget_map_backends
+TEMPLATE = app
+
+SOURCES += src/main.cpp
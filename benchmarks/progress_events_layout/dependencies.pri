@@ -0,0 +1 @@
+DEPENDENCIES += tp_qt_maps_widget
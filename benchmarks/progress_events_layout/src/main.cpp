@@ -0,0 +1,100 @@
+#include "tp_qt_maps_widget/ProgressEventsLayout.h"
+
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+
+// Times layoutProgressEvents on generated trees of 10k, 100k, and 1M events in both layout modes.
+//
+// The layout is O(n) so the time per event should stay roughly flat as the count grows.
+//
+// Usage: tp_qt_maps_widget_progress_events_layout [repeats]
+
+namespace
+{
+
+//##################################################################################################
+//! A tree where each event is a child of one of the recent events, with children inside parents.
+std::vector<tp_utils::ProgressEvent> makeEvents_lt(size_t count)
+{
+  std::mt19937_64 rng(count);
+  std::vector<tp_utils::ProgressEvent> events;
+  events.resize(count);
+
+  for(size_t i=0; i<count; i++)
+  {
+    auto& event = events.at(i);
+    event.id = int64_t(i+1);
+    event.name = "event " + std::to_string(i%100);
+
+    if(i==0)
+    {
+      event.parentId = 0;
+      event.start = 0;
+      event.end = int64_t(count)*100;
+      continue;
+    }
+
+    size_t window = std::min<size_t>(i, 64);
+    const auto& parent = events.at(i - 1 - (rng()%window));
+    event.parentId = parent.id;
+
+    int64_t length = parent.end - parent.start;
+    event.start = parent.start + int64_t(rng()%uint64_t(std::max<int64_t>(1, length/2)));
+    event.end = event.start + int64_t(rng()%uint64_t(std::max<int64_t>(1, parent.end-event.start)));
+  }
+
+  return events;
+}
+
+//##################################################################################################
+double time_lt(const std::vector<tp_utils::ProgressEvent>& events,
+               tp_qt_maps_widget::ProgressEventsLayoutMode mode,
+               size_t repeats,
+               size_t& rowCount)
+{
+  double best = std::numeric_limits<double>::max();
+  for(size_t r=0; r<repeats; r++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    auto layout = tp_qt_maps_widget::layoutProgressEvents(events, 0, mode);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    best = std::min(best, ms);
+    rowCount = layout.rowCount;
+  }
+  return best;
+}
+}
+
+//##################################################################################################
+int main(int argc, char* argv[])
+{
+  size_t repeats = 5;
+  if(argc>1)
+    repeats = size_t(std::max(1, std::atoi(argv[1])));
+
+  std::cout << std::setw(9) << "events" << std::setw(8) << "mode" << std::setw(12) << "ms"
+            << std::setw(12) << "ns/event" << std::setw(10) << "rows" << '\n';
+
+  for(size_t count : {size_t(10000), size_t(100000), size_t(1000000)})
+  {
+    auto events = makeEvents_lt(count);
+
+    for(auto mode : {tp_qt_maps_widget::ProgressEventsLayoutMode::Tree, tp_qt_maps_widget::ProgressEventsLayoutMode::Packed})
+    {
+      size_t rowCount=0;
+      double ms = time_lt(events, mode, repeats, rowCount);
+      std::cout << std::setw(9) << count
+                << std::setw(8) << ((mode==tp_qt_maps_widget::ProgressEventsLayoutMode::Tree)?"tree":"packed")
+                << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                << std::setw(12) << std::setprecision(1) << (ms*1.0e6/double(count))
+                << std::setw(10) << rowCount << '\n';
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,4 @@
+TARGET = tp_qt_maps_widget_progress_events_layout
+TEMPLATE = app
+
+SOURCES += src/main.cpp
@@ -0,0 +1,149 @@
+#include "tp_qt_maps_widget/ProgressEventsTraceFile.h"
+#include "tp_qt_maps_widget/ProgressEventsChromeTrace.h"
+
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+
+// Compares the binary trace file against Chrome trace JSON for file size, write time, and load
+// time, on generated traces of 100k and 1M events. Load is the time to get a vector of events,
+// open is the time for ProgressEventsTraceFile to map and index the file without converting it.
+//
+// Usage: tp_qt_maps_widget_progress_events_trace_file [repeats]
+
+namespace
+{
+
+//##################################################################################################
+std::vector<tp_utils::ProgressEvent> makeEvents_lt(size_t count)
+{
+  std::mt19937_64 rng(count);
+  std::vector<tp_utils::ProgressEvent> events;
+  events.resize(count);
+
+  for(size_t i=0; i<count; i++)
+  {
+    auto& event = events.at(i);
+    event.id = int64_t(i+1);
+    event.name = "event " + std::to_string(i%100);
+    event.color.r = uint8_t(rng());
+    event.color.g = uint8_t(rng());
+    event.color.b = uint8_t(rng());
+    event.color.a = 255;
+
+    if(i==0)
+    {
+      event.parentId = 0;
+      event.start = 0;
+      event.end = int64_t(count)*100;
+      continue;
+    }
+
+    size_t window = std::min<size_t>(i, 64);
+    const auto& parent = events.at(i - 1 - (rng()%window));
+    event.parentId = parent.id;
+
+    int64_t length = parent.end - parent.start;
+    event.start = parent.start + int64_t(rng()%uint64_t(std::max<int64_t>(1, length/2)));
+    event.end = event.start + int64_t(rng()%uint64_t(std::max<int64_t>(1, parent.end-event.start)));
+  }
+
+  return events;
+}
+
+//##################################################################################################
+template<typename F>
+double bestMS_lt(size_t repeats, const F& f)
+{
+  double best = std::numeric_limits<double>::max();
+  for(size_t r=0; r<repeats; r++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+//##################################################################################################
+void printRow_lt(size_t count, const char* format, uintmax_t bytes, double writeMS, double openMS, double loadMS)
+{
+  std::cout << std::setw(9) << count
+            << std::setw(8) << format
+            << std::setw(12) << std::fixed << std::setprecision(2) << (double(bytes)/(1024.0*1024.0))
+            << std::setw(12) << writeMS;
+
+  if(openMS<0.0)
+    std::cout << std::setw(12) << "-";
+  else
+    std::cout << std::setw(12) << openMS;
+
+  std::cout << std::setw(12) << loadMS << '\n';
+}
+}
+
+//##################################################################################################
+int main(int argc, char* argv[])
+{
+  size_t repeats = 3;
+  if(argc>1)
+    repeats = size_t(std::max(1, std::atoi(argv[1])));
+
+  auto directory = std::filesystem::temp_directory_path();
+  auto binaryPath = (directory / "tp_qt_maps_widget_benchmark.tpe").string();
+  auto jsonPath = (directory / "tp_qt_maps_widget_benchmark.json").string();
+
+  std::cout << std::setw(9) << "events" << std::setw(8) << "format" << std::setw(12) << "MiB"
+            << std::setw(12) << "write ms" << std::setw(12) << "open ms" << std::setw(12) << "load ms" << '\n';
+
+  int result=0;
+  for(size_t count : {size_t(100000), size_t(1000000)})
+  {
+    auto events = makeEvents_lt(count);
+    std::vector<tp_utils::ProgressEvent> loaded;
+
+    {
+      bool ok=true;
+      double writeMS = bestMS_lt(repeats, [&]{ok = tp_qt_maps_widget::writeProgressEventsTrace(binaryPath, events) && ok;});
+
+      double openMS = bestMS_lt(repeats, [&]
+      {
+        tp_qt_maps_widget::ProgressEventsTraceFile file;
+        ok = file.open(binaryPath) && ok;
+      });
+
+      double loadMS = bestMS_lt(repeats, [&]{ok = tp_qt_maps_widget::readProgressEventsTrace(binaryPath, loaded) && ok;});
+
+      if(!ok || loaded.size()!=events.size())
+      {
+        std::cerr << "Binary trace round trip failed for " << count << " events\n";
+        result = 1;
+      }
+
+      printRow_lt(count, "binary", std::filesystem::file_size(binaryPath), writeMS, openMS, loadMS);
+    }
+
+    {
+      bool ok=true;
+      double writeMS = bestMS_lt(repeats, [&]{ok = tp_qt_maps_widget::writeChromeTrace(jsonPath, events) && ok;});
+      double loadMS = bestMS_lt(repeats, [&]{ok = tp_qt_maps_widget::readChromeTrace(jsonPath, loaded) && ok;});
+
+      if(!ok)
+      {
+        std::cerr << "JSON trace round trip failed for " << count << " events\n";
+        result = 1;
+      }
+
+      printRow_lt(count, "json", std::filesystem::file_size(jsonPath), writeMS, -1.0, loadMS);
+    }
+  }
+
+  std::filesystem::remove(binaryPath);
+  std::filesystem::remove(jsonPath);
+  return result;
+}
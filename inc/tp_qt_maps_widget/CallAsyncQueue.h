@@ -0,0 +1,73 @@
+#ifndef tp_qt_maps_widget_CallAsyncQueue_h
+#define tp_qt_maps_widget_CallAsyncQueue_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Counters describing the work that has passed through a CallAsyncQueue.
+struct CallAsyncStats
+{
+  size_t queueDepth{0};     //!< Callbacks posted but not yet processed.
+  size_t maxQueueDepth{0};  //!< The deepest the queue has been seen at the start of a drain.
+  size_t posted{0};         //!< Total number of callbacks posted.
+  size_t processed{0};      //!< Total number of callbacks processed.
+  size_t drains{0};         //!< Number of times the queue has been drained.
+  size_t limitedDrains{0};  //!< Drains that hit the time limit and rescheduled the rest.
+  double lastDrainMS{0.0};  //!< Time spent processing callbacks in the last drain.
+  double maxDrainMS{0.0};   //!< Longest time spent in a single drain.
+  double lastLatencyMS{0.0};//!< Age of the oldest callback at the start of the last drain.
+  double maxLatencyMS{0.0}; //!< Largest latency seen at the start of a drain.
+};
+
+//##################################################################################################
+//! A multi producer single consumer queue of callbacks, processed on the thread that created it.
+/*!
+Callbacks can be posted from any thread without taking a lock. The queue is drained in batches on
+the owning thread, one batch per CrossThreadCallback wakeup. Each batch is limited by time, if the
+limit is reached the remaining callbacks are left for the next wakeup so that the event loop gets a
+chance to render frames and process input.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT CallAsyncQueue
+{
+  TP_NONCOPYABLE(CallAsyncQueue);
+  TP_DQ;
+public:
+  //################################################################################################
+  CallAsyncQueue();
+
+  //################################################################################################
+  ~CallAsyncQueue();
+
+  //################################################################################################
+  //! Post a callback to be called on the owning thread, this is thread safe.
+  void post(const std::function<void()>& callback);
+
+  //################################################################################################
+  //! Process queued callbacks now, returns true if callbacks remain after hitting a limit.
+  /*!
+  This must only be called from the owning thread, it is called automatically after post().
+
+  \param maxCallbacks limits the number of callbacks processed by this drain, 0 for no limit.
+  */
+  bool drain(size_t maxCallbacks=0);
+
+  //################################################################################################
+  //! Set the maximum time that a single drain will spend calling callbacks, <=0 for no limit.
+  void setMaxDrainTimeMS(double maxDrainTimeMS);
+
+  //################################################################################################
+  double maxDrainTimeMS() const;
+
+  //################################################################################################
+  CallAsyncStats stats() const;
+
+  //################################################################################################
+  void resetStats();
+};
+
+}
+
+#endif
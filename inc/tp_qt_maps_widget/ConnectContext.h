@@ -10,7 +10,7 @@ namespace tp_qt_maps_widget
 
 //##################################################################################################
 //! This is done like this to hide Qt and GLEW from each other.
-QMetaObject::Connection connectContext(QOpenGLContext* context, QWidget* parent, const std::function<void()>& aboutToBeDestroyed);
+QMetaObject::Connection connectContext(QOpenGLContext* context, QObject* parent, const std::function<void()>& aboutToBeDestroyed);
 
 }
 
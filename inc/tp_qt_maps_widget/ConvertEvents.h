@@ -0,0 +1,39 @@
+#ifndef tp_qt_maps_widget_ConvertEvents_h
+#define tp_qt_maps_widget_ConvertEvents_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+#include "tp_maps/MouseEvent.h"
+#include "tp_maps/KeyEvent.h"
+
+#include <Qt>
+
+class QMouseEvent;
+class QWheelEvent;
+class QKeyEvent;
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+tp_maps::KeyboardModifier convertKeyboardModifiers(Qt::KeyboardModifiers modifiers);
+
+//##################################################################################################
+int32_t toScancode(int key);
+
+//##################################################################################################
+tp_maps::Button convertMouseButton(Qt::MouseButton button);
+
+//##################################################################################################
+//! Convert a press, move, release, or double click event, pixelScale maps Qt to map pixels.
+tp_maps::MouseEvent convertMouseEvent(tp_maps::MouseEventType type, QMouseEvent* event, double pixelScale);
+
+//##################################################################################################
+tp_maps::MouseEvent convertWheelEvent(QWheelEvent* event, double pixelScale);
+
+//##################################################################################################
+tp_maps::KeyEvent convertKeyEvent(tp_maps::KeyEventType type, QKeyEvent* event);
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef tp_qt_maps_widget_EditCoalescer_h
+#define tp_qt_maps_widget_EditCoalescer_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+class QWidget;
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+enum class EditCoalescing
+{
+  Immediate, //!< Emit every edit as it happens.
+  Frame,     //!< Emit at most once per display refresh.
+  Interval   //!< Emit at most once every intervalMS.
+};
+
+//##################################################################################################
+//! How often editor widgets pass continuous edits such as slider drags on to listeners.
+struct EditCoalescingPolicy
+{
+  EditCoalescing mode{EditCoalescing::Frame};
+  double intervalMS{33.0}; //!< Used by Interval.
+};
+
+//##################################################################################################
+//! Counters describing the edits that have passed through one or more EditCoalescer.
+struct EditCoalescerStats
+{
+  size_t edits{0};   //!< Raw edits passed to edit().
+  size_t emitted{0}; //!< Number of times the edit was passed on to listeners.
+  size_t folded{0};  //!< Raw edits merged into an emission that was already pending.
+  size_t flushes{0}; //!< Pending emissions sent early by flush(), for example on slider release.
+};
+
+//##################################################################################################
+//! Limit the rate that an editor widget emits edits while the user drags a slider.
+/*!
+The first edit after a quiet period is emitted straight away, further edits within the interval
+are folded into a single emission at the end of it. Edits carry no value, the emit callback should
+read the current state of the widget or merge the edits itself, so nothing is lost by folding.
+
+Call flush() when the user releases a slider or makes a discrete edit so that the final value is
+delivered without waiting for the interval. Anything still pending when the coalescer is destroyed
+is emitted, so the emit callback must still be safe to call then. Owners should flush() at the
+start of their own destructor, while everything the callback reads is still valid.
+
+If an owner is given, edits are ignored while the owner's signals are blocked. This suits widgets
+that emit a Qt signal and block their signals while values are set from code. Widgets that report
+edits through a callback collection should not pass an owner, blockSignals() does not silence
+those.
+
+This must only be used from the GUI thread.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT EditCoalescer
+{
+  TP_NONCOPYABLE(EditCoalescer);
+  TP_DQ;
+public:
+  //################################################################################################
+  EditCoalescer(const std::function<void()>& emitEdit, QWidget* owner=nullptr);
+
+  //################################################################################################
+  ~EditCoalescer();
+
+  //################################################################################################
+  //! Record a raw edit, this emits now or schedules an emission depending on the policy.
+  //! Ignored while the owner's signals are blocked.
+  void edit();
+
+  //################################################################################################
+  //! Emit any pending edit now.
+  void flush();
+
+  //################################################################################################
+  bool pending() const;
+
+  //################################################################################################
+  //! Flush when the user releases any slider in widget, including those inside compound widgets.
+  void flushOnSliderRelease(QWidget* widget);
+
+  //################################################################################################
+  //! Flush when the user finishes editing any spin box in widget, by pressing enter or leaving it.
+  void flushOnEditingFinished(QWidget* widget);
+
+  //################################################################################################
+  //! Override the default policy for this coalescer.
+  void setPolicy(const EditCoalescingPolicy& policy);
+
+  //################################################################################################
+  //! The policy set with setPolicy() or the default policy.
+  EditCoalescingPolicy policy() const;
+
+  //################################################################################################
+  EditCoalescerStats stats() const;
+
+  //################################################################################################
+  void resetStats();
+};
+
+//##################################################################################################
+//! Set the policy used by every editor widget that has not been given its own.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT void setDefaultEditCoalescingPolicy(const EditCoalescingPolicy& policy);
+
+//##################################################################################################
+TP_QT_MAPS_WIDGET_SHARED_EXPORT EditCoalescingPolicy defaultEditCoalescingPolicy();
+
+//##################################################################################################
+//! The total of the stats of every EditCoalescer since the last reset.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT EditCoalescerStats globalEditCoalescerStats();
+
+//##################################################################################################
+TP_QT_MAPS_WIDGET_SHARED_EXPORT void resetGlobalEditCoalescerStats();
+
+}
+
+#endif
@@ -1,7 +1,7 @@
 #ifndef tp_qt_maps_widget_EditMaterialWidget_h
 #define tp_qt_maps_widget_EditMaterialWidget_h
 
-#include "tp_qt_maps_widget/Globals.h"
+#include "tp_qt_maps_widget/MaterialDelta.h"
 
 #include <QWidget>
 
@@ -41,8 +41,33 @@ public:
   void setMaterial(const tp_math_utils::Material& material);
 
   //################################################################################################
+  //! The material, or when editing several materials the first with the edits applied.
   tp_math_utils::Material material() const;
 
+  //################################################################################################
+  //! Edit several materials at once.
+  /*!
+  The first material is shown and values that differ between the materials are marked as mixed.
+  Only the values that the user edits are changed, use applyEdits() to write them to the whole set
+  or apply each materialDeltaEdited() delta to every material. Each edit is a single notification
+  however many materials there are.
+
+  Fields are applied whole, for example setting the scale of a color also sets the color.
+  */
+  void setMaterials(const std::vector<tp_math_utils::Material>& materials);
+
+  //################################################################################################
+  //! The number of materials being edited, 1 after setMaterial().
+  size_t materialCount() const;
+
+  //################################################################################################
+  //! Everything edited since setMaterial() or setMaterials().
+  const MaterialDelta& edits() const;
+
+  //################################################################################################
+  //! Write edits() to each of materials, values that have not been edited are left as they are.
+  void applyEdits(std::vector<tp_math_utils::Material>& materials) const;
+
   //################################################################################################
   void setGetExistingTextures(const TPGetExistingTexturesCallback& getExistingTextures);
 
@@ -61,11 +86,31 @@ public:
                                  const TPLoadTextureCallback& loadTexture = TPLoadTextureCallback(),
                                  const TPLoadMaterialBlendCallback& loadMaterialBlend = TPLoadMaterialBlendCallback());
 
+  //################################################################################################
+  //! Shows a dialog to edit several materials and applies the edits if accepted.
+  static bool editMaterialsDialog(QWidget* parent,
+                                  std::vector<tp_math_utils::Material>& materials,
+                                  TextureSupported textureSupported = TextureSupported::Yes,
+                                  const TPGetExistingTexturesCallback& getExistingTextures = TPGetExistingTexturesCallback(),
+                                  const TPLoadTextureCallback& loadTexture = TPLoadTextureCallback(),
+                                  const TPLoadMaterialBlendCallback& loadMaterialBlend = TPLoadMaterialBlendCallback());
+
 Q_SIGNALS:
   //################################################################################################
-  //! Emitted when a material is edited by the user.
+  //! Emitted when a material is edited by the user, after materialDeltaEdited().
   void materialEdited();
 
+  //################################################################################################
+  //! Emitted when a material is edited by the user with just the fields that changed.
+  /*!
+  Listeners that only need to update what changed should use this rather than copying the whole
+  material with material(). Apply the delta to a copy of the material to keep it in sync.
+
+  Slider drags are coalesced by an EditCoalescer, a delta may hold several raw edits. A delta is
+  never empty, and MaterialDelta is registered so this can be used with queued connections.
+  */
+  void materialDeltaEdited(const tp_qt_maps_widget::MaterialDelta& delta);
+
 protected:
   //################################################################################################
   bool eventFilter(QObject* watched, QEvent* event) override;
@@ -0,0 +1,105 @@
+#ifndef tp_qt_maps_widget_FrameCapture_h
+#define tp_qt_maps_widget_FrameCapture_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Counters describing the frames that have passed through a FrameCapture.
+struct FrameCaptureStats
+{
+  size_t captured{0}; //!< Frames read into a pixel buffer.
+  size_t written{0};  //!< Frames handed to the encoder threads.
+  size_t dropped{0};  //!< Frames skipped because the GPU or the encoders were not keeping up.
+};
+
+//##################################################################################################
+//! Asynchronous capture of rendered frames to numbered image files.
+/*!
+Frames are read back into a ring of pixel buffer objects and mapped a couple of frames later, once
+the GPU has finished with them, so capture never waits on the GPU. The pixels are then encoded and
+written by a pool of background threads.
+
+capture() and the GL methods must be called with the context current.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT FrameCapture
+{
+  TP_NONCOPYABLE(FrameCapture);
+  TP_DQ;
+public:
+  //################################################################################################
+  FrameCapture();
+
+  //################################################################################################
+  ~FrameCapture();
+
+  //################################################################################################
+  //! Start capturing to directory, the directory is created if required.
+  void start(const std::string& directory);
+
+  //################################################################################################
+  //! Stop capturing, frames already read back are written as they become ready.
+  /*!
+  Frames still being read back are written by the next capture(), so if no more frames will be
+  drawn call finish() to write them.
+  */
+  void stop();
+
+  //################################################################################################
+  bool isCapturing() const;
+
+  //################################################################################################
+  const std::string& directory() const;
+
+  //################################################################################################
+  //! The image format passed to QImage::save, defaults to "png".
+  void setFormat(const std::string& format);
+
+  //################################################################################################
+  //! The number of encoder threads, defaults to 2.
+  void setEncoderThreads(int encoderThreads);
+
+  //################################################################################################
+  //! Start reading back sourceFBO and hand older frames that are ready to the encoders.
+  /*!
+  The source may be multisampled, it is resolved into an internal framebuffer before being read.
+  On return sourceFBO is bound as the framebuffer.
+  */
+  void capture(uint32_t sourceFBO, int width, int height);
+
+  //################################################################################################
+  //! Returns the number that the next captured frame will be written as.
+  size_t frameNumber() const;
+
+  //################################################################################################
+  //! Returns the path that a frame is written to, with the given extension.
+  std::string framePath(size_t frame, const std::string& extension) const;
+
+  //################################################################################################
+  FrameCaptureStats stats() const;
+
+  //################################################################################################
+  //! Wait for the encoder threads to finish writing queued frames.
+  void waitForEncoders();
+
+  //################################################################################################
+  //! Stop capturing, wait for the frames still being read back, and wait for them to be written.
+  void finish();
+
+  //################################################################################################
+  //! Write any frames still being read back then delete the pixel buffers.
+  /*!
+  Call this before the context is destroyed.
+  */
+  void deleteBuffers();
+
+  //################################################################################################
+  //! Forget the pixel buffers without deleting them, for when the context has already gone.
+  void invalidateBuffers();
+};
+
+}
+
+#endif
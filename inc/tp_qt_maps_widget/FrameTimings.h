@@ -0,0 +1,176 @@
+#ifndef tp_qt_maps_widget_FrameTimings_h
+#define tp_qt_maps_widget_FrameTimings_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! The timings recorded for a single frame.
+struct FrameTiming
+{
+  size_t frame{0};           //!< Incrementing frame counter.
+  double cpuAnimateMS{0.0};  //!< Time spent in Map::animate since the previous frame.
+  double cpuPaintMS{0.0};    //!< Time spent on the CPU in paintGL.
+  double gpuPaintMS{-1.0};   //!< GPU time for paintGL, -1 if it is not available for this frame.
+  float renderScale{1.0f};   //!< The adaptive render scale that the frame was drawn at.
+  double presentMS{-1.0};    //!< Time from the end of paintGL until the frame was presented.
+  double inputLatencyMS{-1.0};//!< Time from the first input handled in the frame until it was presented.
+};
+
+//##################################################################################################
+//! Summary statistics for one of the timings over a window of frames.
+struct FrameTimingSummary
+{
+  size_t count{0};
+  double min{0.0};
+  double avg{0.0};
+  double p95{0.0};
+  double p99{0.0};
+};
+
+//##################################################################################################
+struct FrameTimingStats
+{
+  FrameTimingSummary cpuAnimate;
+  FrameTimingSummary cpuPaint;
+  FrameTimingSummary gpuPaint;
+  FrameTimingSummary present;
+  FrameTimingSummary inputLatency;
+};
+
+//##################################################################################################
+//! A ring buffer of frame timings.
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT FrameTimings
+{
+  TP_NONCOPYABLE(FrameTimings);
+  TP_DQ;
+public:
+  //################################################################################################
+  FrameTimings(size_t capacity=600);
+
+  //################################################################################################
+  ~FrameTimings();
+
+  //################################################################################################
+  void setCapacity(size_t capacity);
+
+  //################################################################################################
+  size_t capacity() const;
+
+  //################################################################################################
+  void clear();
+
+  //################################################################################################
+  void addFrame(const FrameTiming& frameTiming);
+
+  //################################################################################################
+  //! Returns up to the last window frames, oldest first.
+  std::vector<FrameTiming> timings(size_t window) const;
+
+  //################################################################################################
+  //! Returns min/avg/p95/p99 over the last window frames.
+  FrameTimingStats stats(size_t window) const;
+};
+
+//##################################################################################################
+//! Times GPU work using GL_TIME_ELAPSED queries without ever waiting for a result.
+/*!
+A small ring of query objects is used. If the query for a slot has not completed by the time it is
+needed again, timing is skipped for that frame rather than blocking. All methods must be called with
+the context current.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT GPUFrameTimer
+{
+  TP_NONCOPYABLE(GPUFrameTimer);
+  TP_DQ;
+public:
+  //################################################################################################
+  GPUFrameTimer();
+
+  //################################################################################################
+  ~GPUFrameTimer();
+
+  //################################################################################################
+  //! Returns true if this build has timer query support.
+  static bool supported();
+
+  //################################################################################################
+  //! Start timing for frame, returns false if no query slot was free.
+  bool begin(size_t frame);
+
+  //################################################################################################
+  void end();
+
+  //################################################################################################
+  //! Poll completed queries without waiting, calls resolved for each in frame order.
+  void collect(const std::function<void(size_t frame, double gpuMS)>& resolved);
+
+  //################################################################################################
+  //! Delete the query objects, call this before the context is destroyed.
+  void deleteQueries();
+
+  //################################################################################################
+  //! Forget the query objects without deleting them, for when the context has already gone.
+  void invalidateQueries();
+};
+
+//##################################################################################################
+//! Collects the CPU, GPU, present, and input latency timings of each frame drawn by a host.
+/*!
+GPU and present times arrive after the frame has been drawn, so completed timings are passed to the
+callback in frame order once they are known. Frames that are never presented, for example while
+hidden, are given up on after a few frames.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT FrameTimingRecorder
+{
+  TP_NONCOPYABLE(FrameTimingRecorder);
+  TP_DQ;
+public:
+  //################################################################################################
+  FrameTimingRecorder();
+
+  //################################################################################################
+  ~FrameTimingRecorder();
+
+  //################################################################################################
+  //! Called in frame order as each frame's timings become complete.
+  void setFrameCompletedCallback(const std::function<void(const FrameTiming&)>& frameCompleted);
+
+  //################################################################################################
+  //! Add time spent in Map::animate, this is attributed to the next frame.
+  void addAnimateMS(double animateMS);
+
+  //################################################################################################
+  //! Input latency is measured from the first input received since the previous frame began.
+  void inputReceived();
+
+  //################################################################################################
+  //! Call at the start of paintGL, with the context current.
+  void beginFrame();
+
+  //################################################################################################
+  //! Call at the end of paintGL, with the context current.
+  void endFrame(float renderScale=1.0f);
+
+  //################################################################################################
+  //! Call when frames have been presented, for example from frameSwapped.
+  void framePresented();
+
+  //################################################################################################
+  //! Stop waiting for results that will not arrive and pass on what is known.
+  void abandonPending();
+
+  //################################################################################################
+  //! Delete the GPU queries, call this before the context is destroyed.
+  void deleteQueries();
+
+  //################################################################################################
+  //! Forget the GPU queries without deleting them, for when the context has already gone.
+  void invalidateQueries();
+};
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef tp_qt_maps_widget_HostedMap_h
+#define tp_qt_maps_widget_HostedMap_h
+
+#include "tp_qt_maps_widget/Globals.h"
+#include "tp_qt_maps_widget/CallAsyncQueue.h"
+
+#include "tp_maps/Map.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! A map that is drawn by a Qt host, a widget, a window, or an offscreen surface.
+/*!
+The host provides the context and decides when to repaint through the callbacks, everything else is
+shared between hosts.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT HostedMap final : public tp_maps::Map
+{
+  TP_NONCOPYABLE(HostedMap);
+public:
+  //################################################################################################
+  HostedMap();
+
+  //################################################################################################
+  ~HostedMap() override;
+
+  //################################################################################################
+  using tp_maps::Map::setVisible;
+
+  //################################################################################################
+  using tp_maps::Map::invalidateBuffers;
+
+  // GL functions
+  //################################################################################################
+  void makeCurrent() override;
+
+  //################################################################################################
+  void update(const tp_maps::RenderFromStage& renderFromStage, const std::vector<tp_utils::StringID>& subviews) override;
+
+  //################################################################################################
+  //! This can be called from any thread, the callback will be called from the host thread.
+  void callAsync(const std::function<void()>& callback) override;
+
+  //################################################################################################
+  CallAsyncQueue callAsyncQueue;
+
+  //################################################################################################
+  //! Makes the host context current, called when not already in paintGL.
+  std::function<void()> makeCurrentCallback;
+
+  //################################################################################################
+  //! Asks the host to repaint, called when the default subview needs to be redrawn.
+  std::function<void()> repaintCallback;
+
+  //################################################################################################
+  //! Called when something outside of paintGL requests an update.
+  std::function<void()> updateCallback;
+
+  //! Set while the host does work from its paint ahead of drawing, the frame is already being drawn.
+  bool suppressHostUpdate{false};
+
+  //! Set each time update() is called, hosts clear this to detect idle frames.
+  bool updateRequested{false};
+};
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef tp_qt_maps_widget_IdleTicks_h
+#define tp_qt_maps_widget_IdleTicks_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Decides when a map backend should stop delivering animation ticks.
+/*!
+Ticking stops once nothing has requested an update for maxIdleTicks ticks in a row, so that an idle
+map costs nothing. The backend starts ticking again when a layer or controller calls update() on
+the map. Layers that animate without ever calling update() need stopWhenIdle turned off.
+*/
+struct TP_QT_MAPS_WIDGET_SHARED_EXPORT IdleTicks
+{
+  //! The number of consecutive ticks without an update before the animation ticks are stopped.
+  static constexpr size_t maxIdleTicks{30};
+
+  bool stopWhenIdle{true}; //!< Stop ticking when idle, on by default.
+  size_t idleTicks{0};     //!< Consecutive ticks that have not requested an update.
+
+  //################################################################################################
+  //! Call when ticking starts or an update is requested.
+  void reset();
+
+  //################################################################################################
+  //! Call after each tick has animated the map, returns true if the ticks should stop.
+  bool tick(bool updateRequested);
+};
+
+}
+
+#endif
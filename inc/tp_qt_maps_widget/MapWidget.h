@@ -2,6 +2,10 @@
 #define tp_qt_maps_widget_MapWidget_h
 
 #include "tp_qt_maps_widget/Globals.h"
+#include "tp_qt_maps_widget/CallAsyncQueue.h"
+#include "tp_qt_maps_widget/FrameTimings.h"
+#include "tp_qt_maps_widget/FrameCapture.h"
+#include "tp_qt_maps_widget/RenderScaleController.h"
 #include "tp_maps/Map.h"
 
 #define GL_DO_NOT_WARN_IF_MULTI_GL_VERSION_HEADERS_INCLUDED
@@ -10,6 +14,26 @@
 
 namespace tp_qt_maps_widget
 {
+//##################################################################################################
+//! Counts of raw Qt input events versus the events dispatched to the map.
+struct InputCoalescingStats
+{
+  size_t rawMouseMoveEvents{0};
+  size_t dispatchedMouseMoveEvents{0};
+  size_t rawWheelEvents{0};
+  size_t dispatchedWheelEvents{0};
+};
+
+//##################################################################################################
+//! How MapWidget schedules calls to Map::animate.
+enum class FramePacing
+{
+  OnDemand,  //!< No animation ticks, animate once before each frame that is drawn for another reason.
+  FixedRate, //!< Animate on a timer at the interval passed to setAnimationInterval().
+  VSync      //!< Animate once per presented frame, driven by QOpenGLWidget::frameSwapped.
+};
+
+//##################################################################################################
 class TP_QT_MAPS_WIDGET_SHARED_EXPORT MapWidget : public QOpenGLWidget
 {
   Q_OBJECT
@@ -25,6 +49,12 @@ public:
   tp_maps::Map* map();
 
   //################################################################################################
+  //! Set the mime type of drag drop payloads.
+  /*!
+  The payload is either a QDataStream serialized QString of JSON under dragDropMimeType, or CBOR
+  encoded JSON under dragDropMimeType + "+cbor". If both are present the CBOR form is used. The
+  payload is parsed once when the drag enters and reused until it leaves or is dropped.
+  */
   void setDragDropMimeType(const QString& dragDropMimeType);
 
   //################################################################################################
@@ -34,12 +64,113 @@ public:
   QSize sizeHint() const override;
 
   //################################################################################################
+  //! Set the interval used by FramePacing::FixedRate in milliseconds.
   void setAnimationInterval(int64_t interval);
 
+  //################################################################################################
+  void setFramePacing(FramePacing framePacing);
+
+  //################################################################################################
+  FramePacing framePacing() const;
+
+  //################################################################################################
+  //! Stop animation ticks when nothing has requested an update for a few ticks, on by default.
+  /*!
+  Ticking resumes as soon as a layer or controller calls update() on the map, or the widget is
+  shown again. Layers that animate without ever calling update() should turn this off.
+  */
+  void setStopAnimationWhenIdle(bool stopAnimationWhenIdle);
+
+  //################################################################################################
+  bool stopAnimationWhenIdle() const;
+
+  //################################################################################################
+  //! Returns true if animation ticks are currently being delivered to the map.
+  bool isAnimating() const;
+
+  //################################################################################################
+  //! Returns the queue depth and drain timings of the work posted through Map::callAsync.
+  CallAsyncStats callAsyncStats() const;
+
+  //################################################################################################
+  //! Limit the time spent processing callAsync callbacks per event loop wakeup, <=0 for no limit.
+  void setCallAsyncMaxDrainTimeMS(double maxDrainTimeMS);
+
+  //################################################################################################
+  //! Merge mouse move and wheel events and dispatch them once per frame, just before painting.
+  /*!
+  Press, release, double click, key, and drag drop events flush any pending moves first so the
+  order that the map sees events in is preserved. This is off by default.
+
+  Events are only queued while the map is handling them. After the map ignores an event the next
+  one is dispatched straight away, so events the map does not want still reach parent widgets.
+  */
+  void setCoalesceInputEvents(bool coalesceInputEvents);
+
+  //################################################################################################
+  bool coalesceInputEvents() const;
+
+  //################################################################################################
+  InputCoalescingStats inputCoalescingStats() const;
+
+  //################################################################################################
+  void resetInputCoalescingStats();
+
+  //################################################################################################
+  //! Record CPU and GPU timings for each frame, off by default.
+  void setFrameTimingEnabled(bool frameTimingEnabled);
+
+  //################################################################################################
+  bool frameTimingEnabled() const;
+
+  //################################################################################################
+  //! The ring buffer of recorded frame timings.
+  FrameTimings& frameTimings();
+
+  //################################################################################################
+  //! Returns min/avg/p95/p99 of the recorded timings over the last window frames.
+  FrameTimingStats frameTimingStats(size_t window=120) const;
+
+  //################################################################################################
+  //! Capture rendered frames to numbered images, call frameCapture().start(directory) to begin.
+  FrameCapture& frameCapture();
+
+  //################################################################################################
+  //! Lower the render resolution while the user interacts if frames miss the target time.
+  /*!
+  The map is drawn into a scaled buffer which is stretched over the widget, so layers see a smaller
+  map. Full resolution is restored once interaction stops. The target frame time, minimum scale, and
+  idle delay are set on renderScaleController(). Off by default.
+  */
+  void setAdaptiveRenderScale(bool adaptiveRenderScale);
+
+  //################################################################################################
+  bool adaptiveRenderScale() const;
+
+  //################################################################################################
+  //! Settings and decision counters for adaptive render scale.
+  RenderScaleController& renderScaleController();
+
+  //################################################################################################
+  //! The current render scale, 1 is full resolution.
+  float renderScale() const;
+
 Q_SIGNALS:
   //################################################################################################
   void initialized();
 
+  //################################################################################################
+  //! Emitted once per frame while frame timing is enabled.
+  /*!
+  GPU timings are read back without stalling, so this is emitted a few frames after the frame was
+  drawn, once its GPU time is known and it has been presented.
+  */
+  void frameTimed(const tp_qt_maps_widget::FrameTiming& frameTiming);
+
+  //################################################################################################
+  //! Emitted when adaptive render scale changes the resolution, see renderScaleController().stats().
+  void renderScaleChanged(float renderScale);
+
 protected:
   //################################################################################################
   void initializeGL() override;
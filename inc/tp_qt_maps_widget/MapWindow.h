@@ -0,0 +1,126 @@
+#ifndef tp_qt_maps_widget_MapWindow_h
+#define tp_qt_maps_widget_MapWindow_h
+
+#include "tp_qt_maps_widget/Globals.h"
+#include "tp_qt_maps_widget/CallAsyncQueue.h"
+#include "tp_qt_maps_widget/FrameTimings.h"
+
+#include "tp_maps/Map.h"
+
+#define GL_DO_NOT_WARN_IF_MULTI_GL_VERSION_HEADERS_INCLUDED
+#include <QOpenGLWindow>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! A window that draws a map straight to its own surface.
+/*!
+MapWidget draws into an FBO that the widget stack then composites into the window, this avoids that
+copy and the latency that comes with it. Embed it in a widget layout with
+QWidget::createWindowContainer(). It shares its map and input handling with MapWidget but does not
+support drag and drop, which Qt does not deliver to a QWindow.
+
+Frame timing works as it does for MapWidget, FrameTiming::presentMS and inputLatencyMS can be used
+to compare the two.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT MapWindow : public QOpenGLWindow
+{
+  Q_OBJECT
+  TP_DQ;
+public:
+  //################################################################################################
+  MapWindow(QWindow* parent = nullptr);
+
+  //################################################################################################
+  ~MapWindow() override;
+
+  //################################################################################################
+  tp_maps::Map* map();
+
+  //################################################################################################
+  //! Set the animation interval in milliseconds, ticks stop while nothing is requesting updates.
+  void setAnimationInterval(int64_t interval);
+
+  //################################################################################################
+  //! Stop animation ticks when nothing has requested an update for a few ticks, on by default.
+  /*!
+  Ticking resumes as soon as a layer or controller calls update() on the map, or the window is
+  shown again. Layers that animate without ever calling update() should turn this off.
+  */
+  void setStopAnimationWhenIdle(bool stopAnimationWhenIdle);
+
+  //################################################################################################
+  bool stopAnimationWhenIdle() const;
+
+  //################################################################################################
+  //! Returns the queue depth and drain timings of the work posted through Map::callAsync.
+  CallAsyncStats callAsyncStats() const;
+
+  //################################################################################################
+  //! Record CPU, GPU, and present timings for each frame, off by default.
+  void setFrameTimingEnabled(bool frameTimingEnabled);
+
+  //################################################################################################
+  bool frameTimingEnabled() const;
+
+  //################################################################################################
+  //! The ring buffer of recorded frame timings.
+  FrameTimings& frameTimings();
+
+  //################################################################################################
+  //! Returns min/avg/p95/p99 of the recorded timings over the last window frames.
+  FrameTimingStats frameTimingStats(size_t window=120) const;
+
+Q_SIGNALS:
+  //################################################################################################
+  void initialized();
+
+  //################################################################################################
+  //! Emitted once per frame while frame timing is enabled, once the frame has been presented.
+  void frameTimed(const tp_qt_maps_widget::FrameTiming& frameTiming);
+
+protected:
+  //################################################################################################
+  void initializeGL() override;
+
+  //################################################################################################
+  void resizeGL(int width, int height) override;
+
+  //################################################################################################
+  void paintGL() override;
+
+  //################################################################################################
+  void mousePressEvent(QMouseEvent* event) override;
+
+  //################################################################################################
+  void mouseMoveEvent(QMouseEvent* event) override;
+
+  //################################################################################################
+  void mouseReleaseEvent(QMouseEvent* event) override;
+
+  //################################################################################################
+  void wheelEvent(QWheelEvent* event) override;
+
+  //################################################################################################
+  void mouseDoubleClickEvent(QMouseEvent* event) override;
+
+  //################################################################################################
+  void keyPressEvent(QKeyEvent *event) override;
+
+  //################################################################################################
+  void keyReleaseEvent(QKeyEvent *event) override;
+
+  //################################################################################################
+  void timerEvent(QTimerEvent *event) override;
+
+  //################################################################################################
+  void hideEvent(QHideEvent* event) override;
+
+  //################################################################################################
+  void showEvent(QShowEvent* event) override;
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef tp_qt_maps_widget_MaterialDelta_h
+#define tp_qt_maps_widget_MaterialDelta_h
+
+#include "tp_qt_maps_widget/MaterialFields.h"
+
+#include <QMetaType>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! The new value of one entry in materialFields().
+struct MaterialFieldChange
+{
+  size_t field{0};
+  MaterialFieldValue value;
+};
+
+//##################################################################################################
+//! The new name of a typed texture, see materialTexture().
+struct MaterialTextureChange
+{
+  std::string type;
+  std::string name;
+};
+
+//##################################################################################################
+//! The fields of a material changed by an edit, and their new values.
+/*!
+A delta only describes what changed, so a listener can update just the affected parameters rather
+than copying and re-uploading the whole material. Each field appears at most once, setting a field
+that is already in the delta replaces its value.
+*/
+struct TP_QT_MAPS_WIDGET_SHARED_EXPORT MaterialDelta
+{
+  std::vector<MaterialFieldChange> fields;
+  std::vector<MaterialTextureChange> textures;
+
+  bool nameChanged{false};
+  std::string name;
+
+  bool blendFileChanged{false};
+  std::string blendFile;
+
+  //################################################################################################
+  bool empty() const;
+
+  //################################################################################################
+  void setField(size_t field, const MaterialFieldValue& value);
+
+  //################################################################################################
+  void setTexture(const std::string& type, const std::string& name);
+
+  //################################################################################################
+  void setName(const std::string& name);
+
+  //################################################################################################
+  void setBlendFile(const std::string& blendFile);
+
+  //################################################################################################
+  //! Add the changes in other, where both change something the value from other wins.
+  void merge(const MaterialDelta& other);
+
+  //################################################################################################
+  //! Write the changed values into material, everything else is left as it is.
+  void apply(tp_math_utils::Material& material) const;
+};
+
+//##################################################################################################
+//! The delta that would turn from into to.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT MaterialDelta diffMaterials(const tp_math_utils::Material& from, const tp_math_utils::Material& to);
+
+}
+
+Q_DECLARE_METATYPE(tp_qt_maps_widget::MaterialDelta)
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef tp_qt_maps_widget_MaterialFields_h
+#define tp_qt_maps_widget_MaterialFields_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+enum class MaterialFieldType
+{
+  Float,  //!< A spin box and slider.
+  Color,  //!< A color button with a float scale slider.
+  Bool,   //!< A check box.
+  Vec3,   //!< Three spin boxes.
+  Choice  //!< A combo box of named values.
+};
+
+//##################################################################################################
+//! How slider position maps to value, quadratic gives finer control near min.
+enum class MaterialFieldMapping
+{
+  Linear,
+  Quadratic
+};
+
+//##################################################################################################
+//! Describes one editable field of a material.
+/*!
+The field accessors find or add the OpenGL and legacy sub-materials that hold the field, so they
+take a non-const material. The value accessors read a const material without adding anything, a
+missing sub-material reads as its defaults.
+*/
+struct MaterialField
+{
+  const char* section;
+  const char* name;
+  MaterialFieldType type;
+  float min{0.0f};
+  float max{1.0f};
+  MaterialFieldMapping mapping{MaterialFieldMapping::Linear};
+
+  float*     (*floatField)(tp_math_utils::Material&){nullptr}; //!< Float, and the scale of Color.
+  glm::vec3* (*vec3Field)(tp_math_utils::Material&){nullptr};  //!< Color and Vec3.
+  bool*      (*boolField)(tp_math_utils::Material&){nullptr};  //!< Bool.
+
+  float     (*floatValue)(const tp_math_utils::Material&){nullptr}; //!< Reads floatField.
+  glm::vec3 (*vec3Value)(const tp_math_utils::Material&){nullptr};  //!< Reads vec3Field.
+  bool      (*boolValue)(const tp_math_utils::Material&){nullptr};  //!< Reads boolField.
+
+  std::string (*getChoice)(const tp_math_utils::Material&){nullptr};        //!< Choice.
+  void (*setChoice)(tp_math_utils::Material&, const std::string&){nullptr}; //!< Choice.
+  std::array<const char*, 4> choices{};                                      //!< Choice, unused are nullptr.
+
+  //################################################################################################
+  //! Map a slider position in 0 to 1 to a value.
+  float fromSlider(float s) const
+  {
+    return min + (max-min)*((mapping==MaterialFieldMapping::Linear)?s:s*s);
+  }
+
+  //################################################################################################
+  //! Map a value to a slider position in 0 to 1.
+  float toSlider(float v) const
+  {
+    float s = (max>min)?std::clamp((v-min)/(max-min), 0.0f, 1.0f):0.0f;
+    return (mapping==MaterialFieldMapping::Linear)?s:std::sqrt(s);
+  }
+};
+
+//##################################################################################################
+//! The value of a field, only the members used by the field's type are set.
+struct MaterialFieldValue
+{
+  float f{0.0f};
+  glm::vec3 v{0.0f};
+  bool b{false};
+  std::string s;
+
+  //################################################################################################
+  bool operator==(const MaterialFieldValue& other) const
+  {
+    return f==other.f && v==other.v && b==other.b && s==other.s;
+  }
+
+  //################################################################################################
+  bool operator!=(const MaterialFieldValue& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+//##################################################################################################
+//! The number of entries in materialFields().
+constexpr size_t materialFieldCount{52};
+
+//##################################################################################################
+using MaterialFields = std::array<MaterialField, materialFieldCount>;
+
+//##################################################################################################
+//! The table of fields edited by EditMaterialWidget, in display order, built at compile time.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT const MaterialFields& materialFields();
+
+//##################################################################################################
+TP_QT_MAPS_WIDGET_SHARED_EXPORT MaterialFieldValue materialFieldValue(const tp_math_utils::Material& material, size_t field);
+
+//##################################################################################################
+TP_QT_MAPS_WIDGET_SHARED_EXPORT void setMaterialFieldValue(tp_math_utils::Material& material, size_t field, const MaterialFieldValue& value);
+
+//##################################################################################################
+//! The name of a typed texture of the OpenGL or legacy sub-material.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT std::string materialTexture(const tp_math_utils::Material& material, const std::string& type);
+
+//##################################################################################################
+TP_QT_MAPS_WIDGET_SHARED_EXPORT void setMaterialTexture(tp_math_utils::Material& material, const std::string& type, const std::string& name);
+
+//##################################################################################################
+//! Calls closure with the type of each typed texture of the OpenGL and legacy sub-materials.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT void viewMaterialTextureTypes(const tp_math_utils::Material& material,
+                                                              const std::function<void(const std::string& type, const std::string& pretty)>& closure);
+
+//##################################################################################################
+//! The sub path of the "blend" external material, empty if there isn't one.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT std::string materialBlendFile(const tp_math_utils::Material& material);
+
+//##################################################################################################
+//! Set the sub path of the "blend" external material, an empty path removes it.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT void setMaterialBlendFile(tp_math_utils::Material& material, const std::string& subPath);
+
+}
+
+#endif
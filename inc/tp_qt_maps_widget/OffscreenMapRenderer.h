@@ -0,0 +1,170 @@
+#ifndef tp_qt_maps_widget_OffscreenMapRenderer_h
+#define tp_qt_maps_widget_OffscreenMapRenderer_h
+
+#include "tp_qt_maps_widget/Globals.h"
+#include "tp_qt_maps_widget/CallAsyncQueue.h"
+
+#include "tp_maps/Map.h"
+#include "tp_maps/MouseEvent.h"
+#include "tp_maps/KeyEvent.h"
+
+#include <QObject>
+#include <QImage>
+
+class QOpenGLContext;
+class QMouseEvent;
+class QWheelEvent;
+class QKeyEvent;
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Renders a map into an offscreen framebuffer without a window.
+/*!
+This uses the same map and input conversion code as MapWidget, but draws into an FBO on a
+QOffscreenSurface. Time is driven explicitly with setTime() and stepFrame() so that rendering is
+repeatable, which makes it suitable for thumbnails, batch jobs, and regression images. It works
+under QT_QPA_PLATFORM=offscreen with a software GL implementation.
+
+The offscreen surface is created in the constructor which must be called from the GUI thread,
+initialize() and everything after it must be called from the thread that will do the rendering.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT OffscreenMapRenderer : public QObject
+{
+  Q_OBJECT
+  TP_DQ;
+public:
+  //################################################################################################
+  //! shareContext is optional, pass it to share textures with another context.
+  OffscreenMapRenderer(int width, int height, QOpenGLContext* shareContext=nullptr, QObject* parent=nullptr);
+
+  //################################################################################################
+  ~OffscreenMapRenderer() override;
+
+  //################################################################################################
+  //! Set the context to share textures with, this must be called before initialize().
+  void setShareContext(QOpenGLContext* shareContext);
+
+  //################################################################################################
+  //! Create the context and initialize the map, returns false if a context could not be created.
+  bool initialize();
+
+  //################################################################################################
+  //! Delete the map and the context, call from the rendering thread.
+  /*!
+  This is called by the destructor. Call it first if the renderer is to be deleted on a different
+  thread to the one that it rendered on, the offscreen surface is then deleted by the destructor.
+  */
+  void release();
+
+  //################################################################################################
+  bool isValid() const;
+
+  //################################################################################################
+  tp_maps::Map* map();
+
+  //################################################################################################
+  QOpenGLContext* context() const;
+
+  //################################################################################################
+  void makeCurrent();
+
+  //################################################################################################
+  void doneCurrent();
+
+  //################################################################################################
+  //! The map is visible by default, hidden maps skip work that only matters for display.
+  void setVisible(bool visible);
+
+  //################################################################################################
+  void resize(int width, int height);
+
+  //################################################################################################
+  int width() const;
+
+  //################################################################################################
+  int height() const;
+
+  //################################################################################################
+  //! Set the time passed to Map::animate in milliseconds, this starts at zero.
+  void setTime(double timeMS);
+
+  //################################################################################################
+  double time() const;
+
+  //################################################################################################
+  //! Advance the clock, process posted callAsync callbacks, and animate the map.
+  void stepFrame(double deltaMS);
+
+  //################################################################################################
+  //! Process callbacks posted with Map::callAsync now rather than waiting for the event loop.
+  void processCallAsync();
+
+  //################################################################################################
+  //! Returns true if the map has requested an update since the last render.
+  bool needsRender() const;
+
+  //################################################################################################
+  //! Render a frame into the framebuffer.
+  void render();
+
+  //################################################################################################
+  //! Render a frame and read it back.
+  QImage renderToImage();
+
+  //################################################################################################
+  //! The number of framebuffers to render into, defaults to 1.
+  /*!
+  With more than one buffer the caller chooses which one each frame is rendered into with
+  setCurrentBuffer(), so that a frame can be displayed from another context while the next is drawn.
+  Changing the count or size recreates all of the buffers.
+  */
+  void setBufferCount(size_t bufferCount);
+
+  //################################################################################################
+  size_t bufferCount() const;
+
+  //################################################################################################
+  //! Select the framebuffer that render() draws into.
+  void setCurrentBuffer(size_t currentBuffer);
+
+  //################################################################################################
+  size_t currentBuffer() const;
+
+  //################################################################################################
+  //! The texture of the current buffer, this holds the most recently rendered frame.
+  uint32_t texture() const;
+
+  //################################################################################################
+  //! The texture of a specific buffer.
+  uint32_t texture(size_t buffer) const;
+
+  //################################################################################################
+  bool mouseEvent(const tp_maps::MouseEvent& event);
+
+  //################################################################################################
+  bool keyEvent(const tp_maps::KeyEvent& event);
+
+  //################################################################################################
+  //! Inject a Qt mouse event, the type is taken from the event, positions are in map pixels.
+  bool injectMouseEvent(QMouseEvent* event);
+
+  //################################################################################################
+  bool injectWheelEvent(QWheelEvent* event);
+
+  //################################################################################################
+  bool injectKeyEvent(QKeyEvent* event);
+
+  //################################################################################################
+  CallAsyncStats callAsyncStats() const;
+
+Q_SIGNALS:
+  //################################################################################################
+  //! Emitted when the map requests an update of the default subview.
+  void updateRequested();
+};
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef tp_qt_maps_widget_ProgressEventsChromeTrace_h
+#define tp_qt_maps_widget_ProgressEventsChromeTrace_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+#include "tp_utils/Progress.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Convert Chrome trace event JSON into progress events.
+/*!
+Both the array form and the object form with a "traceEvents" member are accepted. Complete (X) and
+begin/end (B/E) events are read, other phases are skipped. The JSON is parsed as a stream so no
+document is built in memory.
+
+The result is a tree rooted at a single event covering the whole trace, with an event for each
+process and thread below it. Events on a thread are nested by time. Process and thread names are
+taken from metadata (M) events where present.
+
+Times in the trace are in microseconds, they are divided by microsecondsPerUnit, the default gives
+milliseconds to match tp_utils::currentTimeMS().
+
+Returns false if the JSON is malformed. A trace in array form may end without the closing ], as
+the Trace Event Format allows, the events read up to the end of the input are kept.
+*/
+TP_QT_MAPS_WIDGET_SHARED_EXPORT bool parseChromeTrace(const char* begin,
+                                                      const char* end,
+                                                      std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                                      double microsecondsPerUnit=1000.0);
+
+//##################################################################################################
+//! Memory map a Chrome trace file and parse it, see parseChromeTrace().
+TP_QT_MAPS_WIDGET_SHARED_EXPORT bool readChromeTrace(const std::string& path,
+                                                     std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                                     double microsecondsPerUnit=1000.0);
+
+//##################################################################################################
+//! Write progress events as Chrome trace event JSON.
+/*!
+Finished events are written as complete (X) events and active events as begin (B) events with no
+end. Children stay on their parent's thread unless they overlap an earlier sibling, in which case
+they are moved to a new thread so that viewers nest them correctly.
+*/
+TP_QT_MAPS_WIDGET_SHARED_EXPORT bool writeChromeTrace(const std::string& path,
+                                                      const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                                      double microsecondsPerUnit=1000.0);
+
+}
+
+#endif
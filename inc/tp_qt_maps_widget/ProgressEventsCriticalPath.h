@@ -0,0 +1,25 @@
+#ifndef tp_qt_maps_widget_ProgressEventsCriticalPath_h
+#define tp_qt_maps_widget_ProgressEventsCriticalPath_h
+
+#include "tp_qt_maps_widget/ProgressEventsLayout.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Find the chain of events that determined when the bar at position finished.
+/*!
+Starting from the end of the bar, the child that finished last is on the path, then the child that
+finished last before that one started, and so on back to the start of the bar. The same is then done
+inside each child on the path. Children running in parallel that finished earlier are left off.
+
+Returns event indices in start order, starting with the event at position. This is O(n log n) in the
+size of the subtree.
+*/
+TP_QT_MAPS_WIDGET_SHARED_EXPORT std::vector<size_t> progressEventsCriticalPath(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                                                              const ProgressEventsLayout& layout,
+                                                                              size_t position=0);
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef tp_qt_maps_widget_ProgressEventsDiff_h
+#define tp_qt_maps_widget_ProgressEventsDiff_h
+
+#include "tp_qt_maps_widget/ProgressEventsLayout.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! An event from a baseline run paired with the same event from a candidate run.
+struct ProgressEventsMatch
+{
+  size_t baseline{ProgressEventsLayout::none};  //!< Index of the baseline event, or none if it is new.
+  size_t candidate{ProgressEventsLayout::none}; //!< Index of the candidate event, or none if it was removed.
+  int64_t baselineDuration{0};
+  int64_t candidateDuration{0};
+
+  //################################################################################################
+  //! Relative slowdown, 0.5 means 50% slower and -0.5 means 50% faster.
+  double slowdown() const
+  {
+    if(baselineDuration<=0)
+      return (candidateDuration>0)?1.0:0.0;
+    return double(candidateDuration-baselineDuration) / double(baselineDuration);
+  }
+
+  //################################################################################################
+  bool matched() const
+  {
+    return baseline!=ProgressEventsLayout::none && candidate!=ProgressEventsLayout::none;
+  }
+};
+
+//##################################################################################################
+struct ProgressEventsDiff
+{
+  //! One match per candidate bar in layout order, followed by the removed baseline bars.
+  std::vector<ProgressEventsMatch> matches;
+
+  //! Index into matches of each candidate bar, by position in the candidate layout.
+  std::vector<size_t> candidateMatches;
+
+  //! Index into matches of each baseline bar, by position in the baseline layout.
+  std::vector<size_t> baselineMatches;
+};
+
+//##################################################################################################
+//! Pair the events of two runs by their name path from the root.
+/*!
+Roots are paired by name, and the first roots are paired with each other even if their names
+differ. Below that children of paired events are paired by name. Where more than one root or child
+has the same name they are paired in order. This is O(n) using a hash map keyed on the paired
+parent and name.
+*/
+TP_QT_MAPS_WIDGET_SHARED_EXPORT ProgressEventsDiff diffProgressEvents(const std::vector<tp_utils::ProgressEvent>& baseline,
+                                                                     const ProgressEventsLayout& baselineLayout,
+                                                                     const std::vector<tp_utils::ProgressEvent>& candidate,
+                                                                     const ProgressEventsLayout& candidateLayout);
+
+//##################################################################################################
+//! The paired events that gained the most time, largest first.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT std::vector<ProgressEventsMatch> largestRegressions(const ProgressEventsDiff& diff, size_t count);
+
+//##################################################################################################
+//! The names from the root down to the bar at position, separated by '/'.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT std::string progressEventsNamePath(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                                                  const ProgressEventsLayout& layout,
+                                                                  size_t position);
+
+}
+
+#endif
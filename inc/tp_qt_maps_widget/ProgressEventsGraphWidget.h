@@ -1,9 +1,8 @@
 #ifndef tp_qt_maps_widget_ProgressEventsGraphWidget_h
 #define tp_qt_maps_widget_ProgressEventsGraphWidget_h
 
-#include "tp_qt_maps_widget/Globals.h"
-
-#include "tp_utils/Progress.h"
+#include "tp_qt_maps_widget/ProgressEventsStats.h"
+#include "tp_qt_maps_widget/ProgressEventsDiff.h"
 
 #include <QWidget>
 
@@ -22,7 +21,116 @@ public:
   ~ProgressEventsGraphWidget() override;
 
   //################################################################################################
+  //! Replace all events and rebuild the display.
   void setProgressEvents(const std::vector<tp_utils::ProgressEvent>& progressEvents);
+
+  //################################################################################################
+  //! Compare a baseline run against a candidate run.
+  /*!
+  Events are paired by name path, see diffProgressEvents(). Each candidate row is followed by a row
+  with the matching baseline bars, candidate bars are colored red if they got slower and green if
+  they got faster, new events are blue and removed ones dark grey at the bottom. The baseline is
+  shifted so that both runs start together. Rows follow layoutMode().
+
+  Statistics and the critical path are calculated from the candidate alone.
+
+  Appending and active updates are ignored while comparing, setProgressEvents() returns to showing
+  a single run.
+  */
+  void setComparison(const std::vector<tp_utils::ProgressEvent>& baseline,
+                     const std::vector<tp_utils::ProgressEvent>& candidate);
+
+  //################################################################################################
+  bool isComparison() const;
+
+  //################################################################################################
+  //! The pairing of the last comparison, indices refer to the vectors passed to setComparison().
+  const ProgressEventsDiff& comparison() const;
+
+  //################################################################################################
+  //! One line for each of the count events that gained the most time.
+  std::string comparisonSummary(size_t count=10) const;
+
+  //################################################################################################
+  //! The events being displayed, for example to pass to writeChromeTrace().
+  const std::vector<tp_utils::ProgressEvent>& progressEvents() const;
+
+  //################################################################################################
+  //! Add new events, only the bars from the first row that moved onwards are regenerated.
+  void appendProgressEvents(const std::vector<tp_utils::ProgressEvent>& progressEvents);
+
+  //################################################################################################
+  //! Update the end time and active state of events that are still active, matched by id.
+  void updateActiveEvents(const std::vector<tp_utils::ProgressEvent>& progressEvents);
+
+  //################################################################################################
+  //! Choose between one row per event and one row per depth, defaults to Tree.
+  /*!
+  Large traces are drawn from a level of detail pyramid, events that are closer together than a
+  couple of pixels at the current zoom are merged into blocks. Packed mode puts many events in each
+  row so it benefits most from this.
+  */
+  void setLayoutMode(ProgressEventsLayoutMode layoutMode);
+
+  //################################################################################################
+  ProgressEventsLayoutMode layoutMode() const;
+
+  //################################################################################################
+  //! Show a sortable table of per name statistics beside the graph, hidden by default.
+  /*!
+  The statistics are calculated on a worker thread whenever the events change while the table is
+  visible. Selecting a row highlights every bar with that name.
+  */
+  void setStatisticsVisible(bool statisticsVisible);
+
+  //################################################################################################
+  bool statisticsVisible() const;
+
+  //################################################################################################
+  //! The most recent statistics, see statisticsChanged().
+  const std::vector<ProgressEventsNameStats>& statistics() const;
+
+  //################################################################################################
+  //! Outline every bar with this name, an empty name clears the highlight.
+  void setHighlightedName(const std::string& highlightedName);
+
+  //################################################################################################
+  const std::string& highlightedName() const;
+
+  //################################################################################################
+  //! Outline the critical path of the whole trace, see progressEventsCriticalPath().
+  void setCriticalPathVisible(bool criticalPathVisible);
+
+  //################################################################################################
+  bool criticalPathVisible() const;
+
+  //################################################################################################
+  //! Indices into progressEvents() of the events on the critical path, in start order.
+  /*!
+  This is calculated when the events change if the path is visible, otherwise the first time it is
+  asked for after a change.
+  */
+  const std::vector<size_t>& criticalPath() const;
+
+  //################################################################################################
+  //! Extend active events to the current time every interval milliseconds, 0 to stop.
+  /*!
+  liveUpdate() is emitted on each tick before the display is updated, connect to it to poll for new
+  events. Only the chunks of bars that contain active events are regenerated each tick.
+  */
+  void setLiveUpdateInterval(int interval);
+
+  //################################################################################################
+  int liveUpdateInterval() const;
+
+Q_SIGNALS:
+  //################################################################################################
+  //! Emitted on each live update tick.
+  void liveUpdate();
+
+  //################################################################################################
+  //! Emitted on the GUI thread when new statistics have been calculated.
+  void statisticsChanged();
 };
 }
 #endif
@@ -0,0 +1,57 @@
+#ifndef tp_qt_maps_widget_ProgressEventsIndex_h
+#define tp_qt_maps_widget_ProgressEventsIndex_h
+
+#include "tp_qt_maps_widget/ProgressEventsLayout.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Finds the bar at a row and time in O(log n) without touching GL.
+/*!
+Bars are grouped by row and sorted by start time. End times are read from the events when queried,
+so active events that grow do not require the index to be rebuilt, only adding events or changing
+the layout does.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT ProgressEventsIndex
+{
+  TP_NONCOPYABLE(ProgressEventsIndex);
+  TP_DQ;
+public:
+  //################################################################################################
+  ProgressEventsIndex();
+
+  //################################################################################################
+  ~ProgressEventsIndex();
+
+  //################################################################################################
+  void build(const std::vector<tp_utils::ProgressEvent>& progressEvents, const ProgressEventsLayout& layout);
+
+  //################################################################################################
+  void clear();
+
+  //################################################################################################
+  //! Returns the index of the event at time in row, or ProgressEventsLayout::none.
+  /*!
+  tolerance widens each bar by that much time either side, so that thin bars can still be hit. If
+  more than one bar is in range the one nearest to time is returned.
+  */
+  size_t eventAt(size_t row,
+                 int64_t time,
+                 int64_t tolerance,
+                 const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                 const ProgressEventsLayout& layout) const;
+
+  //################################################################################################
+  //! Calls closure for each event in row that overlaps [t1, t2].
+  void eventsInRange(size_t row,
+                     int64_t t1,
+                     int64_t t2,
+                     const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                     const ProgressEventsLayout& layout,
+                     const std::function<void(size_t)>& closure) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef tp_qt_maps_widget_ProgressEventsLOD_h
+#define tp_qt_maps_widget_ProgressEventsLOD_h
+
+#include "tp_qt_maps_widget/ProgressEventsLayout.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! A run of events that are drawn as a single block when zoomed out.
+struct ProgressEventsBlock
+{
+  int64_t start{0};   //!< Earliest start.
+  int64_t end{0};     //!< Latest end of the events that have finished.
+  int64_t longest{0}; //!< Duration of the longest event.
+  size_t count{0};    //!< The number of events in the block.
+  size_t event{0};    //!< Index of the longest event, this gives the block its color.
+  bool active{false}; //!< True if any of the events are active, the block then ends at now.
+
+  //################################################################################################
+  int64_t endAt(int64_t now) const
+  {
+    return active?std::max(end, now):end;
+  }
+};
+
+//##################################################################################################
+//! Sweep blocks sorted by start, merging any that are separated by less than width.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT void mergeProgressEventsBlocks(const std::vector<ProgressEventsBlock>& blocks,
+                                                               int64_t width,
+                                                               int64_t now,
+                                                               std::vector<ProgressEventsBlock>& merged);
+
+//##################################################################################################
+//! A multi-resolution summary of the events in each row, for drawing zoomed out timelines.
+/*!
+Each row holds a pyramid of levels. Level 0 is the events themselves and each level above it
+merges runs of blocks separated by less than 4 times the gap of the level below. A level is only
+kept if it at least halves the number of blocks, so the pyramid never holds more than twice as many
+blocks as there are events.
+
+Queries pick the coarsest level that is still finer than the requested width and merge it the
+rest of the way, so the number of blocks returned is bounded by the span of the query divided by
+the width rather than by the number of events.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT ProgressEventsLOD
+{
+  TP_NONCOPYABLE(ProgressEventsLOD);
+  TP_DQ;
+public:
+  //################################################################################################
+  ProgressEventsLOD();
+
+  //################################################################################################
+  ~ProgressEventsLOD();
+
+  //################################################################################################
+  //! Build the pyramid for every row.
+  void build(const std::vector<tp_utils::ProgressEvent>& progressEvents, const ProgressEventsLayout& layout);
+
+  //################################################################################################
+  //! Rebuild the rows flagged in dirtyRows, rows past the end of dirtyRows are always rebuilt.
+  /*!
+  If sourceRows is not empty it gives, for each row that is not dirty, the row that held the same
+  events before the update. Those rows are moved rather than rebuilt, so inserting events only
+  costs the rows that actually changed even when the rows after them shift.
+  */
+  void update(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+              const ProgressEventsLayout& layout,
+              const std::vector<bool>& dirtyRows,
+              const std::vector<size_t>& sourceRows={});
+
+  //################################################################################################
+  void clear();
+
+  //################################################################################################
+  //! The total number of blocks held across all rows and levels.
+  size_t blockCount() const;
+
+  //################################################################################################
+  //! Calls closure with the blocks that overlap [t1, t2] in rows [firstRow, lastRow).
+  /*!
+  Rows are merged in groups of rowStride, starting from row 0, and closure is passed the first row
+  of each group. Blocks separated by less than width are merged. Blocks are passed in start order
+  within each group.
+  */
+  void blocks(size_t firstRow,
+              size_t lastRow,
+              size_t rowStride,
+              int64_t t1,
+              int64_t t2,
+              int64_t width,
+              const ProgressEventsLayout& layout,
+              const std::function<void(size_t, const ProgressEventsBlock&)>& closure) const;
+};
+
+}
+
+#endif
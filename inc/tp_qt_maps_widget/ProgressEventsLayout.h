@@ -0,0 +1,61 @@
+#ifndef tp_qt_maps_widget_ProgressEventsLayout_h
+#define tp_qt_maps_widget_ProgressEventsLayout_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+#include "tp_utils/Progress.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+enum class ProgressEventsLayoutMode
+{
+  Tree,  //!< One row per event in depth first order.
+  Packed //!< One row per depth, siblings share a row like a flame chart.
+};
+
+//##################################################################################################
+//! The order, rows, and time range of a set of progress events, built without copying the events.
+struct ProgressEventsLayout
+{
+  static constexpr size_t none = size_t(-1);
+
+  std::vector<size_t> order;     //!< Event index of each bar, depth first with children after parents.
+  std::vector<size_t> depths;    //!< Depth in the tree of each bar, the root is 0.
+  std::vector<size_t> parents;   //!< Position in order of the parent of each bar, none for the root.
+  std::vector<size_t> rows;      //!< Row of each bar.
+  std::vector<size_t> positions; //!< Position in order of each event, or none if it is left out.
+  size_t rowCount{0};            //!< The number of rows used.
+  int64_t minTime{0};            //!< Earliest start.
+  int64_t maxTime{0};            //!< Latest end.
+  int64_t now{0};                //!< The end time used for active events.
+
+  //################################################################################################
+  //! The end of an event, active events end now.
+  int64_t end(const tp_utils::ProgressEvent& event) const
+  {
+    return event.active?now:event.end;
+  }
+
+  //################################################################################################
+  //! Map a time to 0 at minTime and 1 at maxTime.
+  float toFraction(int64_t time) const
+  {
+    return (maxTime>minTime)?(float(time-minTime) / float(maxTime-minTime)):0.0f;
+  }
+};
+
+//##################################################################################################
+//! Lay out the tree rooted at the first event in O(n).
+/*!
+Parents are found through an id to index map built in one pass. Events that are not descendants of
+the first event are left out.
+*/
+TP_QT_MAPS_WIDGET_SHARED_EXPORT ProgressEventsLayout layoutProgressEvents(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                                                         int64_t now,
+                                                                         ProgressEventsLayoutMode mode=ProgressEventsLayoutMode::Tree);
+
+}
+
+#endif
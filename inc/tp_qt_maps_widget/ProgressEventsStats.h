@@ -0,0 +1,33 @@
+#ifndef tp_qt_maps_widget_ProgressEventsStats_h
+#define tp_qt_maps_widget_ProgressEventsStats_h
+
+#include "tp_qt_maps_widget/ProgressEventsLayout.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Timings for all of the events that share a name.
+struct ProgressEventsNameStats
+{
+  std::string name;
+  size_t count{0};  //!< Number of events.
+  int64_t total{0}; //!< Summed duration, events nested inside one with the same name are not added again.
+  int64_t self{0};  //!< Summed duration not covered by children.
+  int64_t min{0};   //!< Shortest event.
+  int64_t max{0};   //!< Longest event.
+  int64_t p95{0};   //!< 95th percentile duration.
+};
+
+//##################################################################################################
+//! Calculate per name statistics over the laid out events, sorted by total descending.
+/*!
+Children that run in parallel are merged before being taken off their parent's duration, so self
+time is never negative. This is O(n log n) and does not touch the events that are not laid out.
+*/
+TP_QT_MAPS_WIDGET_SHARED_EXPORT std::vector<ProgressEventsNameStats> progressEventsStats(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                                                                        const ProgressEventsLayout& layout);
+
+}
+
+#endif
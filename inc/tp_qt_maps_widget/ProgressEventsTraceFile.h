@@ -0,0 +1,134 @@
+#ifndef tp_qt_maps_widget_ProgressEventsTraceFile_h
+#define tp_qt_maps_widget_ProgressEventsTraceFile_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+#include "tp_utils/Progress.h"
+
+#include <string_view>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! The columns of one block of records in a trace file, pointing into the mapped file.
+/*!
+Each record is the state of an event when it was written, an event that was active may be written
+again when it ends. Name indices refer to ProgressEventsTraceFile::names(). Colors are packed RGBA
+with red in the low byte.
+*/
+struct ProgressEventsTraceBlock
+{
+  size_t count{0};
+  const int64_t* ids{nullptr};
+  const int64_t* parentIds{nullptr};
+  const int64_t* starts{nullptr};
+  const int64_t* ends{nullptr};
+  const uint32_t* colors{nullptr};
+  const uint32_t* names{nullptr};
+  const uint8_t* active{nullptr};
+};
+
+//##################################################################################################
+//! Write progress events to a compact columnar binary file as a job runs.
+/*!
+The file is a header followed by blocks. Each block holds the names first used by its records
+followed by one column per field, so a block is only complete once it has been written in full.
+If the writer stops part way, for example because the job crashed, everything up to the last
+complete block can still be read.
+
+Values are written in the native byte order, little endian on every platform we build for.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT ProgressEventsTraceWriter
+{
+  TP_NONCOPYABLE(ProgressEventsTraceWriter);
+  TP_DQ;
+public:
+  //################################################################################################
+  //! Records are buffered and written as a block once blockSize have been collected.
+  ProgressEventsTraceWriter(size_t blockSize=65536);
+
+  //################################################################################################
+  //! Closes the file if it is still open.
+  ~ProgressEventsTraceWriter();
+
+  //################################################################################################
+  //! Create or truncate path and write the header, returns false if it can't be opened.
+  bool open(const std::string& path);
+
+  //################################################################################################
+  bool isOpen() const;
+
+  //################################################################################################
+  //! Add records for events, call this with new events and again as events are updated.
+  /*!
+  Returns false if the file is not open or a block could not be written, once a write has failed
+  further records are dropped until the file is opened again.
+  */
+  bool write(const std::vector<tp_utils::ProgressEvent>& progressEvents);
+
+  //################################################################################################
+  //! Write any buffered records as a block, returns false if the write failed.
+  bool flush();
+
+  //################################################################################################
+  //! Flush and close the file, returns false if the final write failed.
+  bool close();
+};
+
+//##################################################################################################
+//! A memory mapped trace file written by ProgressEventsTraceWriter.
+/*!
+Opening only walks the block headers and the name table, the columns are read in place from the
+mapping. The blocks and names are valid until the file is closed.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT ProgressEventsTraceFile
+{
+  TP_NONCOPYABLE(ProgressEventsTraceFile);
+  TP_DQ;
+public:
+  //################################################################################################
+  ProgressEventsTraceFile();
+
+  //################################################################################################
+  ~ProgressEventsTraceFile();
+
+  //################################################################################################
+  //! Map path and index its blocks, returns false if it is not a trace file.
+  /*!
+  A truncated final block is ignored with a warning, the blocks before it are still available.
+  */
+  bool open(const std::string& path);
+
+  //################################################################################################
+  void close();
+
+  //################################################################################################
+  const std::vector<ProgressEventsTraceBlock>& blocks() const;
+
+  //################################################################################################
+  //! The interned names, indexed by the names column of each block.
+  const std::vector<std::string_view>& names() const;
+
+  //################################################################################################
+  //! The total number of records in all blocks.
+  size_t recordCount() const;
+
+  //################################################################################################
+  //! Convert the records to events, where an id was written more than once the last record wins.
+  void progressEvents(std::vector<tp_utils::ProgressEvent>& progressEvents) const;
+};
+
+//##################################################################################################
+//! Write events to path in a single pass, see ProgressEventsTraceWriter.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT bool writeProgressEventsTrace(const std::string& path,
+                                                              const std::vector<tp_utils::ProgressEvent>& progressEvents);
+
+//##################################################################################################
+//! Read the events from a trace file, see ProgressEventsTraceFile.
+TP_QT_MAPS_WIDGET_SHARED_EXPORT bool readProgressEventsTrace(const std::string& path,
+                                                             std::vector<tp_utils::ProgressEvent>& progressEvents);
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef tp_qt_maps_widget_RenderScaleController_h
+#define tp_qt_maps_widget_RenderScaleController_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Why the render scale was changed.
+enum class RenderScaleReason
+{
+  OverBudget,  //!< Frames were taking longer than the target frame time.
+  UnderBudget, //!< Frames were comfortably inside the target so resolution was raised a step.
+  Idle,        //!< Interaction stopped so full resolution was restored.
+  Reset        //!< Adaptive scaling was turned off or its settings changed.
+};
+
+//##################################################################################################
+//! Counters describing the decisions made by a RenderScaleController.
+struct RenderScaleStats
+{
+  float scale{1.0f};            //!< The current render scale.
+  size_t decreases{0};          //!< Changes made because frames were over budget.
+  size_t increases{0};          //!< Changes made because frames were under budget.
+  size_t restores{0};           //!< Returns to full resolution after interaction stopped.
+  double frameCostMS{0.0};      //!< Smoothed cost of recent frames.
+  RenderScaleReason lastReason{RenderScaleReason::Reset};
+};
+
+//##################################################################################################
+//! Picks a render scale that keeps frames inside a target frame time while the user interacts.
+/*!
+This only makes decisions, the host renders at the returned scale and upscales on present. Frame
+cost is roughly proportional to the number of pixels so the scale is reduced by the square root of
+the overrun. Scale changes are quantized and spaced a few frames apart to avoid resizing buffers
+every frame. Once there has been no interaction for the idle delay the scale returns to 1.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT RenderScaleController
+{
+  TP_NONCOPYABLE(RenderScaleController);
+  TP_DQ;
+public:
+  //################################################################################################
+  RenderScaleController();
+
+  //################################################################################################
+  ~RenderScaleController();
+
+  //################################################################################################
+  //! The frame time to aim for while interacting, defaults to 16.6ms.
+  void setTargetFrameTimeMS(double targetFrameTimeMS);
+
+  //################################################################################################
+  double targetFrameTimeMS() const;
+
+  //################################################################################################
+  //! The lowest scale that will be used, defaults to 0.5.
+  void setMinScale(float minScale);
+
+  //################################################################################################
+  float minScale() const;
+
+  //################################################################################################
+  //! How long after the last interaction before full resolution is restored, defaults to 250ms.
+  void setIdleDelayMS(double idleDelayMS);
+
+  //################################################################################################
+  double idleDelayMS() const;
+
+  //################################################################################################
+  //! Record user interaction, camera movement or a resize.
+  void interaction(double nowMS);
+
+  //################################################################################################
+  //! Returns true if interaction has happened within the idle delay.
+  bool interacting(double nowMS) const;
+
+  //################################################################################################
+  //! Returns the time until interaction counts as stopped, 0 if it already has.
+  double idleRemainingMS(double nowMS) const;
+
+  //################################################################################################
+  //! Add the cost of a completed frame, returns true if the scale changed.
+  bool addFrameCost(double frameCostMS, double nowMS);
+
+  //################################################################################################
+  //! Returns true if the scale was restored to 1 because interaction has stopped.
+  bool checkIdle(double nowMS);
+
+  //################################################################################################
+  //! Return to full resolution and forget the frame history.
+  void reset();
+
+  //################################################################################################
+  float scale() const;
+
+  //################################################################################################
+  RenderScaleStats stats() const;
+};
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef tp_qt_maps_widget_ThreadedMapWidget_h
+#define tp_qt_maps_widget_ThreadedMapWidget_h
+
+#include "tp_qt_maps_widget/Globals.h"
+
+#include "tp_maps/Map.h"
+
+#define GL_DO_NOT_WARN_IF_MULTI_GL_VERSION_HEADERS_INCLUDED
+#include <QOpenGLWidget>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+//! Counters describing the frames passed from the render thread to the widget.
+struct ThreadedRenderStats
+{
+  size_t rendered{0};   //!< Frames rendered on the render thread.
+  size_t displayed{0};  //!< Frames composited by the widget.
+  size_t skipped{0};    //!< Frames replaced by a newer frame before the widget displayed them.
+};
+
+//##################################################################################################
+//! A map widget that animates and renders the map on its own thread.
+/*!
+The map is owned by an OffscreenMapRenderer that lives on a dedicated thread with a context shared
+with the widget. It renders into a ring of three framebuffers and the widget only composites the
+newest finished frame, so a slow scene does not block the GUI thread.
+
+The map must only be touched from the render thread. Use callInRenderThread() to set up layers and
+controllers, and Map::callAsync() from inside the render thread to post further work. Qt input
+events are converted on the GUI thread and queued to the render thread in order.
+
+The render context shares with QOpenGLContext::globalShareContext() if there is one, set
+Qt::AA_ShareOpenGLContexts if the widget may be moved to another window. Resizing waits for the
+frame in progress on the render thread to finish.
+*/
+class TP_QT_MAPS_WIDGET_SHARED_EXPORT ThreadedMapWidget : public QOpenGLWidget
+{
+  Q_OBJECT
+  TP_DQ;
+public:
+  //################################################################################################
+  ThreadedMapWidget(QWidget* parent = nullptr);
+
+  //################################################################################################
+  ~ThreadedMapWidget() override;
+
+  //################################################################################################
+  //! Call from any thread, the callback is called on the render thread once the map exists.
+  void callInRenderThread(const std::function<void(tp_maps::Map*)>& callback);
+
+  //################################################################################################
+  //! The map, only valid to use from the render thread and after initialized() is emitted.
+  tp_maps::Map* map();
+
+  //################################################################################################
+  //! The interval between animation ticks on the render thread, defaults to 16ms.
+  void setAnimationInterval(int64_t interval);
+
+  //################################################################################################
+  //! Stop animation ticks when nothing has requested an update for a few ticks, on by default.
+  /*!
+  Ticking resumes as soon as a layer or controller calls update() on the map, or the widget is
+  shown again. Layers that animate without ever calling update() should turn this off.
+  */
+  void setStopAnimationWhenIdle(bool stopAnimationWhenIdle);
+
+  //################################################################################################
+  bool stopAnimationWhenIdle() const;
+
+  //################################################################################################
+  ThreadedRenderStats renderStats() const;
+
+  //################################################################################################
+  QSize minimumSizeHint() const override;
+
+  //################################################################################################
+  QSize sizeHint() const override;
+
+Q_SIGNALS:
+  //################################################################################################
+  //! Emitted on the GUI thread once the map has been created on the render thread.
+  void initialized();
+
+protected:
+  //################################################################################################
+  void initializeGL() override;
+
+  //################################################################################################
+  void resizeGL(int width, int height) override;
+
+  //################################################################################################
+  void paintGL() override;
+
+  //################################################################################################
+  void mousePressEvent(QMouseEvent* event) override;
+
+  //################################################################################################
+  void mouseMoveEvent(QMouseEvent* event) override;
+
+  //################################################################################################
+  void mouseReleaseEvent(QMouseEvent* event) override;
+
+  //################################################################################################
+  void wheelEvent(QWheelEvent* event) override;
+
+  //################################################################################################
+  void mouseDoubleClickEvent(QMouseEvent* event) override;
+
+  //################################################################################################
+  void keyPressEvent(QKeyEvent *event) override;
+
+  //################################################################################################
+  void keyReleaseEvent(QKeyEvent *event) override;
+
+  //################################################################################################
+  void hideEvent(QHideEvent* event) override;
+
+  //################################################################################################
+  void showEvent(QShowEvent* event) override;
+};
+
+}
+
+#endif
@@ -0,0 +1,240 @@
+#include "tp_qt_maps_widget/CallAsyncQueue.h"
+
+#include "tp_qt_utils/CrossThreadCallback.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace tp_qt_maps_widget
+{
+
+namespace
+{
+using Clock_lt = std::chrono::steady_clock;
+
+//##################################################################################################
+double elapsedMS(const Clock_lt::time_point& from, const Clock_lt::time_point& to)
+{
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+//##################################################################################################
+struct Node_lt
+{
+  std::atomic<Node_lt*> next{nullptr};
+  std::function<void()> callback;
+  Clock_lt::time_point posted;
+};
+}
+
+//##################################################################################################
+struct CallAsyncQueue::Private
+{
+  TP_REF_COUNT_OBJECTS("tp_qt_maps_widget::CallAsyncQueue::Private");
+  TP_NONCOPYABLE(Private);
+
+  CallAsyncQueue* q;
+
+  // This is an intrusive MPSC queue, producers exchange head, the consumer walks from tail.
+  Node_lt stub;
+  std::atomic<Node_lt*> head{&stub};
+  Node_lt* tail{&stub};
+
+  std::atomic<size_t> depth{0};
+  std::atomic<size_t> posted{0};
+  std::atomic<bool> wakeupPending{false};
+
+  double maxDrainTimeMS{4.0};
+
+  // Only touched by the consumer thread.
+  CallAsyncStats stats;
+
+  tp_qt_utils::CrossThreadCallback wakeup;
+
+  //################################################################################################
+  Private(CallAsyncQueue* q_):
+    q(q_),
+    wakeup([&]{q->drain();})
+  {
+
+  }
+
+  //################################################################################################
+  ~Private()
+  {
+    while(Node_lt* node = pop())
+      delete node;
+  }
+
+  //################################################################################################
+  void push(Node_lt* node)
+  {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node_lt* prev = head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  //################################################################################################
+  //! Returns nullptr if the queue is empty or a producer is part way through a push.
+  Node_lt* pop()
+  {
+    Node_lt* t = tail;
+    Node_lt* next = t->next.load(std::memory_order_acquire);
+
+    if(t == &stub)
+    {
+      if(!next)
+        return nullptr;
+
+      tail = next;
+      t = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+
+    if(next)
+    {
+      tail = next;
+      return t;
+    }
+
+    if(t != head.load(std::memory_order_acquire))
+      return nullptr;
+
+    push(&stub);
+
+    next = t->next.load(std::memory_order_acquire);
+    if(next)
+    {
+      tail = next;
+      return t;
+    }
+
+    return nullptr;
+  }
+
+  //################################################################################################
+  //! Peek at the oldest node without removing it.
+  Node_lt* front()
+  {
+    Node_lt* t = tail;
+    if(t == &stub)
+      t = t->next.load(std::memory_order_acquire);
+    return t;
+  }
+
+  //################################################################################################
+  void scheduleWakeup()
+  {
+    if(!wakeupPending.exchange(true, std::memory_order_acq_rel))
+      wakeup.call();
+  }
+};
+
+//##################################################################################################
+CallAsyncQueue::CallAsyncQueue():
+  d(new Private(this))
+{
+
+}
+
+//##################################################################################################
+CallAsyncQueue::~CallAsyncQueue()
+{
+  delete d;
+}
+
+//##################################################################################################
+void CallAsyncQueue::post(const std::function<void()>& callback)
+{
+  auto node = new Node_lt();
+  node->callback = callback;
+  node->posted = Clock_lt::now();
+
+  d->depth.fetch_add(1, std::memory_order_relaxed);
+  d->posted.fetch_add(1, std::memory_order_relaxed);
+  d->push(node);
+  d->scheduleWakeup();
+}
+
+//##################################################################################################
+bool CallAsyncQueue::drain(size_t maxCallbacks)
+{
+  // Clear this first so that anything posted while we are draining schedules a new wakeup.
+  d->wakeupPending.store(false, std::memory_order_release);
+
+  auto start = Clock_lt::now();
+
+  d->stats.drains++;
+  d->stats.maxQueueDepth = std::max(d->stats.maxQueueDepth, d->depth.load(std::memory_order_relaxed));
+
+  if(auto node = d->front(); node)
+  {
+    d->stats.lastLatencyMS = elapsedMS(node->posted, start);
+    d->stats.maxLatencyMS = std::max(d->stats.maxLatencyMS, d->stats.lastLatencyMS);
+  }
+
+  bool limited=false;
+  auto now = start;
+  size_t count=0;
+  while(Node_lt* node = d->pop())
+  {
+    d->depth.fetch_sub(1, std::memory_order_relaxed);
+    d->stats.processed++;
+    count++;
+
+    // Take the callback so that the node can be freed before we call it, callbacks can be slow.
+    std::function<void()> callback;
+    callback.swap(node->callback);
+    delete node;
+    callback();
+
+    now = Clock_lt::now();
+    if((d->maxDrainTimeMS>0.0 && elapsedMS(start, now)>=d->maxDrainTimeMS) || count==maxCallbacks)
+    {
+      limited = d->depth.load(std::memory_order_relaxed)>0;
+      break;
+    }
+  }
+
+  d->stats.lastDrainMS = elapsedMS(start, now);
+  d->stats.maxDrainMS = std::max(d->stats.maxDrainMS, d->stats.lastDrainMS);
+
+  if(limited)
+  {
+    d->stats.limitedDrains++;
+    d->scheduleWakeup();
+  }
+
+  return limited;
+}
+
+//##################################################################################################
+void CallAsyncQueue::setMaxDrainTimeMS(double maxDrainTimeMS)
+{
+  d->maxDrainTimeMS = maxDrainTimeMS;
+}
+
+//##################################################################################################
+double CallAsyncQueue::maxDrainTimeMS() const
+{
+  return d->maxDrainTimeMS;
+}
+
+//##################################################################################################
+CallAsyncStats CallAsyncQueue::stats() const
+{
+  CallAsyncStats stats = d->stats;
+  stats.queueDepth = d->depth.load(std::memory_order_relaxed);
+  stats.posted = d->posted.load(std::memory_order_relaxed);
+  return stats;
+}
+
+//##################################################################################################
+void CallAsyncQueue::resetStats()
+{
+  d->stats = CallAsyncStats();
+  d->posted.store(0, std::memory_order_relaxed);
+}
+
+}
@@ -4,13 +4,13 @@
 #include "tp_qt_maps_widget/ConnectContext.h"
 
 #include <QOpenGLContext>
-#include <QWidget>
+#include <QObject>
 
 namespace tp_qt_maps_widget
 {
 
 //##################################################################################################
-QMetaObject::Connection connectContext(QOpenGLContext* context, QWidget* parent, const std::function<void()>& aboutToBeDestroyed)
+QMetaObject::Connection connectContext(QOpenGLContext* context, QObject* parent, const std::function<void()>& aboutToBeDestroyed)
 {
   return QObject::connect(context, &QOpenGLContext::aboutToBeDestroyed, parent, [=]
   {
@@ -0,0 +1,94 @@
+#include "tp_qt_maps_widget/ConvertEvents.h"
+
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QKeyEvent>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+tp_maps::KeyboardModifier convertKeyboardModifiers(Qt::KeyboardModifiers modifiers)
+{
+  tp_maps::KeyboardModifier m{tp_maps::KeyboardModifier::None};
+  if(modifiers & Qt::ShiftModifier  ) m = m | tp_maps::KeyboardModifier::Shift;
+  if(modifiers & Qt::ControlModifier) m = m | tp_maps::KeyboardModifier::Control;
+  if(modifiers & Qt::AltModifier    ) m = m | tp_maps::KeyboardModifier::Alt;
+  return m;
+}
+
+//##################################################################################################
+int32_t toScancode(int key)
+{
+  switch(key)
+  {
+  case Qt::Key_PageUp:   return TP_PAGE_UP_KEY;
+  case Qt::Key_PageDown: return TP_PAGE_DOWN_KEY;
+  case Qt::Key_Up:       return TP_UP_KEY;
+  case Qt::Key_Down:     return TP_DOWN_KEY;
+  case Qt::Key_Left:     return TP_LEFT_KEY;
+  case Qt::Key_Right:    return TP_RIGHT_KEY;
+  case Qt::Key_Space:    return TP_SPACE_KEY;
+  case Qt::Key_Shift:    return TP_L_SHIFT_KEY;
+  case Qt::Key_Control:  return TP_L_CTRL_KEY;
+  }
+
+  return int32_t(key - Qt::Key_A) + TP_A_KEY;
+}
+
+//##################################################################################################
+tp_maps::Button convertMouseButton(Qt::MouseButton button)
+{
+  switch(button)
+  {
+  case Qt::RightButton:  return tp_maps::Button::RightButton;
+  case Qt::LeftButton:   return tp_maps::Button::LeftButton;
+  case Qt::MiddleButton: return tp_maps::Button::MiddleButton;
+  default:               return tp_maps::Button::NoButton;
+  }
+}
+
+//##################################################################################################
+tp_maps::MouseEvent convertMouseEvent(tp_maps::MouseEventType type, QMouseEvent* event, double pixelScale)
+{
+  tp_maps::MouseEvent e(type);
+
+  e.button = convertMouseButton(event->button());
+  e.pos.x = event->pos().x()*pixelScale;
+  e.pos.y = event->pos().y()*pixelScale;
+
+  e.modifiers = convertKeyboardModifiers(event->modifiers());
+
+  return e;
+}
+
+//##################################################################################################
+tp_maps::MouseEvent convertWheelEvent(QWheelEvent* event, double pixelScale)
+{
+  tp_maps::MouseEvent e(tp_maps::MouseEventType::Wheel);
+
+#if QT_VERSION < 0x060000
+  e.pos.x = event->pos().x()*pixelScale;
+  e.pos.y = event->pos().y()*pixelScale;
+  e.delta = event->delta();
+#else
+  e.pos.x = event->position().x()*pixelScale;
+  e.pos.y = event->position().y()*pixelScale;
+  e.delta = event->angleDelta().y();
+#endif
+
+  e.modifiers = convertKeyboardModifiers(event->modifiers());
+
+  return e;
+}
+
+//##################################################################################################
+tp_maps::KeyEvent convertKeyEvent(tp_maps::KeyEventType type, QKeyEvent* event)
+{
+  tp_maps::KeyEvent e(type);
+  e.scancode = toScancode(event->key());
+  e.modifiers = convertKeyboardModifiers(event->modifiers());
+  return e;
+}
+
+}
@@ -0,0 +1,242 @@
+#include "tp_qt_maps_widget/EditCoalescer.h"
+
+#include <QTimer>
+#include <QWidget>
+#include <QAbstractSlider>
+#include <QAbstractSpinBox>
+#include <QGuiApplication>
+#include <QScreen>
+
+#include <chrono>
+#include <cmath>
+
+namespace tp_qt_maps_widget
+{
+
+namespace
+{
+using Clock_lt = std::chrono::steady_clock;
+
+//##################################################################################################
+EditCoalescingPolicy& defaultPolicy_lt()
+{
+  static EditCoalescingPolicy policy;
+  return policy;
+}
+
+//##################################################################################################
+EditCoalescerStats& globalStats_lt()
+{
+  static EditCoalescerStats stats;
+  return stats;
+}
+}
+
+//##################################################################################################
+struct EditCoalescer::Private
+{
+  TP_REF_COUNT_OBJECTS("tp_qt_maps_widget::EditCoalescer::Private");
+  TP_NONCOPYABLE(Private);
+
+  std::function<void()> emitEdit;
+  QWidget* owner;
+
+  bool hasPolicy{false};
+  EditCoalescingPolicy policy;
+
+  QTimer timer;
+  bool pending{false};
+  bool emittedBefore{false};
+  Clock_lt::time_point lastEmit;
+
+  EditCoalescerStats stats;
+
+  //################################################################################################
+  Private(const std::function<void()>& emitEdit_, QWidget* owner_):
+    emitEdit(emitEdit_),
+    owner(owner_)
+  {
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, &timer, [&]{emitNow();});
+  }
+
+  //################################################################################################
+  double intervalMS() const
+  {
+    auto p = hasPolicy?policy:defaultPolicy_lt();
+    switch(p.mode)
+    {
+      case EditCoalescing::Immediate:
+      return 0.0;
+
+      case EditCoalescing::Frame:
+      {
+        QScreen* screen = QGuiApplication::primaryScreen();
+        double refreshRate = screen?screen->refreshRate():60.0;
+        return 1000.0 / ((refreshRate>1.0)?refreshRate:60.0);
+      }
+
+      case EditCoalescing::Interval:
+      return p.intervalMS;
+    }
+
+    return 0.0;
+  }
+
+  //################################################################################################
+  void emitNow()
+  {
+    timer.stop();
+    pending = false;
+    emittedBefore = true;
+    lastEmit = Clock_lt::now();
+
+    stats.emitted++;
+    globalStats_lt().emitted++;
+
+    // This may call back into the widget that owns us, so don't touch members after it.
+    emitEdit();
+  }
+};
+
+//##################################################################################################
+EditCoalescer::EditCoalescer(const std::function<void()>& emitEdit, QWidget* owner):
+  d(new Private(emitEdit, owner))
+{
+
+}
+
+//##################################################################################################
+EditCoalescer::~EditCoalescer()
+{
+  // Deliver the final value of an edit that was still waiting for its interval.
+  flush();
+  delete d;
+}
+
+//##################################################################################################
+void EditCoalescer::edit()
+{
+  if(d->owner && d->owner->signalsBlocked())
+    return;
+
+  d->stats.edits++;
+  globalStats_lt().edits++;
+
+  if(d->pending)
+  {
+    d->stats.folded++;
+    globalStats_lt().folded++;
+    return;
+  }
+
+  double intervalMS = d->intervalMS();
+  double elapsedMS = std::chrono::duration<double, std::milli>(Clock_lt::now() - d->lastEmit).count();
+
+  if(intervalMS<=0.0 || !d->emittedBefore || elapsedMS>=intervalMS)
+  {
+    d->emitNow();
+    return;
+  }
+
+  d->pending = true;
+  d->timer.start(int(std::ceil(intervalMS - elapsedMS)));
+}
+
+//##################################################################################################
+void EditCoalescer::flush()
+{
+  if(!d->pending)
+    return;
+
+  d->stats.flushes++;
+  globalStats_lt().flushes++;
+  d->emitNow();
+}
+
+//##################################################################################################
+bool EditCoalescer::pending() const
+{
+  return d->pending;
+}
+
+//##################################################################################################
+void EditCoalescer::flushOnSliderRelease(QWidget* widget)
+{
+  auto connectSlider = [&](QAbstractSlider* slider)
+  {
+    QObject::connect(slider, &QAbstractSlider::sliderReleased, &d->timer, [&]{flush();});
+  };
+
+  if(auto slider = qobject_cast<QAbstractSlider*>(widget); slider)
+    connectSlider(slider);
+
+  for(auto slider : widget->findChildren<QAbstractSlider*>())
+    connectSlider(slider);
+}
+
+//##################################################################################################
+void EditCoalescer::flushOnEditingFinished(QWidget* widget)
+{
+  auto connectSpinBox = [&](QAbstractSpinBox* spinBox)
+  {
+    QObject::connect(spinBox, &QAbstractSpinBox::editingFinished, &d->timer, [&]{flush();});
+  };
+
+  if(auto spinBox = qobject_cast<QAbstractSpinBox*>(widget); spinBox)
+    connectSpinBox(spinBox);
+
+  for(auto spinBox : widget->findChildren<QAbstractSpinBox*>())
+    connectSpinBox(spinBox);
+}
+
+//##################################################################################################
+void EditCoalescer::setPolicy(const EditCoalescingPolicy& policy)
+{
+  d->hasPolicy = true;
+  d->policy = policy;
+}
+
+//##################################################################################################
+EditCoalescingPolicy EditCoalescer::policy() const
+{
+  return d->hasPolicy?d->policy:defaultPolicy_lt();
+}
+
+//##################################################################################################
+EditCoalescerStats EditCoalescer::stats() const
+{
+  return d->stats;
+}
+
+//##################################################################################################
+void EditCoalescer::resetStats()
+{
+  d->stats = EditCoalescerStats();
+}
+
+//##################################################################################################
+void setDefaultEditCoalescingPolicy(const EditCoalescingPolicy& policy)
+{
+  defaultPolicy_lt() = policy;
+}
+
+//##################################################################################################
+EditCoalescingPolicy defaultEditCoalescingPolicy()
+{
+  return defaultPolicy_lt();
+}
+
+//##################################################################################################
+EditCoalescerStats globalEditCoalescerStats()
+{
+  return globalStats_lt();
+}
+
+//##################################################################################################
+void resetGlobalEditCoalescerStats()
+{
+  globalStats_lt() = EditCoalescerStats();
+}
+
+}
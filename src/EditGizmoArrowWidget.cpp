@@ -1,4 +1,5 @@
 #include "tp_qt_maps_widget/EditGizmoArrowWidget.h"
+#include "tp_qt_maps_widget/EditCoalescer.h"
 
 #include "tp_qt_widgets/ColorButton.h"
 
@@ -20,9 +21,12 @@ struct EditGizmoArrowWidget::Private
   tp_utils::CallbackCollection<void()> toUI;
   tp_utils::CallbackCollection<void(tp_maps::GizmoArrowParameters& gizmoArrowParameters)> fromUI;
 
+  EditCoalescer coalescer;
+
   //################################################################################################
   Private(Q* q_):
-    q(q_)
+    q(q_),
+    coalescer([q_]{q_->edited();})
   {
 
   }
@@ -127,7 +131,7 @@ EditGizmoArrowWidget::EditGizmoArrowWidget(bool optionalFields, QWidget* parent)
     r.l->addWidget(new QLabel("Stem start"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 1.0);
     spin->setSingleStep(0.01);
@@ -151,7 +155,7 @@ EditGizmoArrowWidget::EditGizmoArrowWidget(bool optionalFields, QWidget* parent)
     r.l->addWidget(new QLabel("Stem length"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 2.0);
     spin->setSingleStep(0.01);
@@ -175,7 +179,7 @@ EditGizmoArrowWidget::EditGizmoArrowWidget(bool optionalFields, QWidget* parent)
     r.l->addWidget(new QLabel("Stem radius"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 1.0);
     spin->setSingleStep(0.01);
@@ -199,7 +203,7 @@ EditGizmoArrowWidget::EditGizmoArrowWidget(bool optionalFields, QWidget* parent)
     r.l->addWidget(new QLabel("Cone radius"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 1.0);
     spin->setSingleStep(0.01);
@@ -223,7 +227,7 @@ EditGizmoArrowWidget::EditGizmoArrowWidget(bool optionalFields, QWidget* parent)
     r.l->addWidget(new QLabel("Cone length"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 1.0);
     spin->setSingleStep(0.01);
@@ -287,11 +291,15 @@ EditGizmoArrowWidget::EditGizmoArrowWidget(bool optionalFields, QWidget* parent)
   }
 
   d->toUI();
+  // Anything set while building the widget goes out now, before listeners are connected.
+  d->coalescer.flush();
+  d->coalescer.flushOnEditingFinished(this);
 }
 
 //##################################################################################################
 EditGizmoArrowWidget::~EditGizmoArrowWidget()
 {
+  d->coalescer.flush();
   delete d;
 }
 
@@ -303,6 +311,7 @@ void EditGizmoArrowWidget::setGizmoArrowParameters(const tp_maps::GizmoArrowPara
 
   d->gizmoArrowParameters = gizmoArrowParameters;
   d->toUI();
+  d->coalescer.flush();
 }
 
 //##################################################################################################
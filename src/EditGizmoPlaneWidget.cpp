@@ -1,4 +1,5 @@
 #include "tp_qt_maps_widget/EditGizmoPlaneWidget.h"
+#include "tp_qt_maps_widget/EditCoalescer.h"
 
 #include "tp_qt_widgets/ColorButton.h"
 
@@ -19,9 +20,12 @@ struct EditGizmoPlaneWidget::Private
   tp_utils::CallbackCollection<void()> toUI;
   tp_utils::CallbackCollection<void(tp_maps::GizmoPlaneParameters& gizmoPlaneParameters)> fromUI;
 
+  EditCoalescer coalescer;
+
   //################################################################################################
   Private(Q* q_):
-    q(q_)
+    q(q_),
+    coalescer([q_]{q_->edited();})
   {
 
   }
@@ -126,7 +130,7 @@ EditGizmoPlaneWidget::EditGizmoPlaneWidget(bool optionalFields, QWidget* parent)
     r.l->addWidget(new QLabel("Size"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 1.0);
     spin->setSingleStep(0.01);
@@ -150,7 +154,7 @@ EditGizmoPlaneWidget::EditGizmoPlaneWidget(bool optionalFields, QWidget* parent)
     r.l->addWidget(new QLabel("Radius"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 1.0);
     spin->setSingleStep(0.01);
@@ -174,7 +178,7 @@ EditGizmoPlaneWidget::EditGizmoPlaneWidget(bool optionalFields, QWidget* parent)
     r.l->addWidget(new QLabel("Padding"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 1.0);
     spin->setSingleStep(0.01);
@@ -212,11 +216,15 @@ EditGizmoPlaneWidget::EditGizmoPlaneWidget(bool optionalFields, QWidget* parent)
   }
 
   d->toUI();
+  // Anything set while building the widget goes out now, before listeners are connected.
+  d->coalescer.flush();
+  d->coalescer.flushOnEditingFinished(this);
 }
 
 //##################################################################################################
 EditGizmoPlaneWidget::~EditGizmoPlaneWidget()
 {
+  d->coalescer.flush();
   delete d;
 }
 
@@ -228,6 +236,7 @@ void EditGizmoPlaneWidget::setGizmoPlaneParameters(const tp_maps::GizmoPlanePara
 
   d->gizmoPlaneParameters = gizmoPlaneParameters;
   d->toUI();
+  d->coalescer.flush();
 }
 
 //##################################################################################################
@@ -1,4 +1,5 @@
 #include "tp_qt_maps_widget/EditGizmoRingWidget.h"
+#include "tp_qt_maps_widget/EditCoalescer.h"
 
 #include "tp_qt_widgets/ColorButton.h"
 
@@ -22,9 +23,12 @@ struct EditGizmoRingWidget::Private
   tp_utils::CallbackCollection<void()> toUI;
   tp_utils::CallbackCollection<void(tp_maps::GizmoRingParameters& gizmoRingParameters)> fromUI;
 
+  EditCoalescer coalescer;
+
   //################################################################################################
   Private(Q* q_):
-    q(q_)
+    q(q_),
+    coalescer([q_]{q_->edited();})
   {
 
   }
@@ -152,7 +156,7 @@ EditGizmoRingWidget::EditGizmoRingWidget(bool optionalFields, QWidget* parent):
     r.l->addWidget(new QLabel("Ring height"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 2.0);
     spin->setSingleStep(0.01);
@@ -177,7 +181,7 @@ EditGizmoRingWidget::EditGizmoRingWidget(bool optionalFields, QWidget* parent):
     r.l->addWidget(new QLabel("Outer radius"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 2.0);
     spin->setSingleStep(0.01);
@@ -202,7 +206,7 @@ EditGizmoRingWidget::EditGizmoRingWidget(bool optionalFields, QWidget* parent):
     r.l->addWidget(new QLabel("Inner radius"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 2.0);
     spin->setSingleStep(0.01);
@@ -227,7 +231,7 @@ EditGizmoRingWidget::EditGizmoRingWidget(bool optionalFields, QWidget* parent):
     r.l->addWidget(new QLabel("Spike radius"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 2.0);
     spin->setSingleStep(0.01);
@@ -252,7 +256,7 @@ EditGizmoRingWidget::EditGizmoRingWidget(bool optionalFields, QWidget* parent):
     r.l->addWidget(new QLabel("Arrow inner radius"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 2.0);
     spin->setSingleStep(0.01);
@@ -277,7 +281,7 @@ EditGizmoRingWidget::EditGizmoRingWidget(bool optionalFields, QWidget* parent):
     r.l->addWidget(new QLabel("Arrow outer radius"));
     r.l->addWidget(spin);
 
-    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+    connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
     spin->setRange(0.0, 2.0);
     spin->setSingleStep(0.01);
@@ -296,11 +300,15 @@ EditGizmoRingWidget::EditGizmoRingWidget(bool optionalFields, QWidget* parent):
   }
 
   d->toUI();
+  // Anything set while building the widget goes out now, before listeners are connected.
+  d->coalescer.flush();
+  d->coalescer.flushOnEditingFinished(this);
 }
 
 //##################################################################################################
 EditGizmoRingWidget::~EditGizmoRingWidget()
 {
+  d->coalescer.flush();
   delete d;
 }
 
@@ -312,6 +320,7 @@ void EditGizmoRingWidget::setGizmoRingParameters(const tp_maps::GizmoRingParamet
 
   d->gizmoRingParameters = gizmoRingParameters;
   d->toUI();
+  d->coalescer.flush();
 }
 
 //##################################################################################################
@@ -2,6 +2,7 @@
 #include "tp_qt_maps_widget/EditGizmoRingWidget.h"
 #include "tp_qt_maps_widget/EditGizmoArrowWidget.h"
 #include "tp_qt_maps_widget/EditGizmoPlaneWidget.h"
+#include "tp_qt_maps_widget/EditCoalescer.h"
 
 #include "tp_qt_widgets/WheelSafeScrollArea.h"
 
@@ -34,9 +35,12 @@ struct EditGizmoWidget::Private
   tp_utils::CallbackCollection<void()> toUI;
   tp_utils::CallbackCollection<void()> fromUI;
 
+  EditCoalescer coalescer;
+
   //################################################################################################
   Private(Q* q_):
-    q(q_)
+    q(q_),
+    coalescer([q_]{q_->edited();})
   {
 
   }
@@ -365,7 +369,7 @@ EditGizmoWidget::EditGizmoWidget(const std::function<void(QVBoxLayout*)>& popula
       l->addWidget(new QLabel("Scale"));
       l->addWidget(spin);
 
-      connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{edited();});
+      connect(spin, &QDoubleSpinBox::valueChanged, this, [&]{d->coalescer.edit();});
 
       spin->setRange(0.1, 1000.0);
       spin->setSingleStep(0.01);
@@ -470,11 +474,16 @@ EditGizmoWidget::EditGizmoWidget(const std::function<void(QVBoxLayout*)>& popula
   d->toUI();
   for(auto scroll : scrolls)
     scroll->updateWatchedObjects();
+
+  // Anything set while building the widget goes out now, before listeners are connected.
+  d->coalescer.flush();
+  d->coalescer.flushOnEditingFinished(this);
 }
 
 //##################################################################################################
 EditGizmoWidget::~EditGizmoWidget()
 {
+  d->coalescer.flush();
   delete d;
 }
 
@@ -486,6 +495,7 @@ void EditGizmoWidget::setGizmoParameters(const tp_maps::GizmoParameters& gizmoPa
 
   d->gizmoParameters = gizmoParameters;
   d->toUI();
+  d->coalescer.flush();
 }
 
 //##################################################################################################
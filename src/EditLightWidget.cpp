@@ -1,4 +1,5 @@
 #include "tp_qt_maps_widget/EditLightWidget.h"
+#include "tp_qt_maps_widget/EditCoalescer.h"
 
 #include "tp_qt_widgets/SpinSlider.h"
 #include "tp_qt_widgets/ColorButton.h"
@@ -26,6 +27,7 @@ namespace tp_qt_maps_widget
 //##################################################################################################
 struct EditLightWidget::Private
 {
+  EditLightWidget* q;
   tp_math_utils::Light light;
 
   QLineEdit* nameEdit{nullptr};
@@ -63,6 +65,16 @@ struct EditLightWidget::Private
 
   QCheckBox* castShadows{nullptr};
 
+  EditCoalescer coalescer;
+
+  //################################################################################################
+  Private(EditLightWidget* q_):
+    q(q_),
+    coalescer([q_]{Q_EMIT q_->lightEdited();}, q_)
+  {
+
+  }
+
   //################################################################################################
   void updateColors()
   {
@@ -75,7 +87,7 @@ struct EditLightWidget::Private
 //##################################################################################################
 EditLightWidget::EditLightWidget(QWidget* parent):
   QWidget(parent),
-  d(new Private())
+  d(new Private(this))
 {
   auto l = new QVBoxLayout(this);
   l->setContentsMargins(0,0,0,0);
@@ -171,7 +183,7 @@ EditLightWidget::EditLightWidget(QWidget* parent):
       spin->setDecimals(3);
       spin->setSingleStep(0.001);
       ll->addWidget(spin);
-      connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditLightWidget::lightEdited);
+      connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this]{d->coalescer.edit();});
       return spin;
     };
 
@@ -237,7 +249,7 @@ EditLightWidget::EditLightWidget(QWidget* parent):
       spin->setDecimals(3);
       spin->setSingleStep(0.001);
       ll->addWidget(spin);
-      connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditLightWidget::lightEdited);
+      connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this]{d->coalescer.edit();});
       return spin;
     };
 
@@ -296,8 +308,9 @@ EditLightWidget::EditLightWidget(QWidget* parent):
     {
       float diffuseScale = d->diffuseScale->value();
       d->power->setValue(diffuseScale * d->powerScale);
-      lightEdited();
+      d->coalescer.edit();
     });
+    d->coalescer.flushOnSliderRelease(d->diffuseScale);
   }
 
   {
@@ -315,8 +328,9 @@ EditLightWidget::EditLightWidget(QWidget* parent):
           value = diffuseScale;
         }
       }
-      lightEdited();
+      d->coalescer.edit();
     });
+    d->coalescer.flushOnSliderRelease(d->power);
   }
 
   l->addWidget(new QLabel("Spot light constant, linear and quadratic attenuation coefficients"));
@@ -330,21 +344,21 @@ EditLightWidget::EditLightWidget(QWidget* parent):
   d->spotLightConstant->setRange(0.0, 5.0);
   d->spotLightConstant->setDecimals(2);
   d->spotLightConstant->setSingleStep(0.01);
-  connect(d->spotLightConstant, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditLightWidget::lightEdited);
+  connect(d->spotLightConstant, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this]{d->coalescer.edit();});
 
   d->spotLightLinear = new QDoubleSpinBox();
   ll->addWidget(d->spotLightLinear);
   d->spotLightLinear->setRange(0.0, 5.0);
   d->spotLightLinear->setDecimals(2);
   d->spotLightLinear->setSingleStep(0.01);
-  connect(d->spotLightLinear, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditLightWidget::lightEdited);
+  connect(d->spotLightLinear, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this]{d->coalescer.edit();});
 
   d->spotLightQuadratic = new QDoubleSpinBox();
   ll->addWidget(d->spotLightQuadratic);
   d->spotLightQuadratic->setRange(0.0, 5.0);
   d->spotLightQuadratic->setDecimals(2);
   d->spotLightQuadratic->setSingleStep(0.01);
-  connect(d->spotLightQuadratic, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditLightWidget::lightEdited);
+  connect(d->spotLightQuadratic, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this]{d->coalescer.edit();});
 
   // A fixed formula is used for light attenuation model.
   d->spotLightConstant->setDisabled(true);
@@ -383,7 +397,7 @@ EditLightWidget::EditLightWidget(QWidget* parent):
           }
         }
 
-        EditLightWidget::lightEdited();
+        d->coalescer.edit();
       });
       return spin;
     };
@@ -404,14 +418,14 @@ EditLightWidget::EditLightWidget(QWidget* parent):
     d->near->setRange(0.1, 1000.0);
     d->near->setDecimals(1);
     d->near->setSingleStep(0.1);
-    connect(d->near, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditLightWidget::lightEdited);
+    connect(d->near, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this]{d->coalescer.edit();});
 
     d->far = new QDoubleSpinBox();
     ll->addWidget(d->far);
     d->far->setRange(0.1, 10000.0);
     d->far->setDecimals(1);
     d->far->setSingleStep(0.1);
-    connect(d->far, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditLightWidget::lightEdited);
+    connect(d->far, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this]{d->coalescer.edit();});
   }
 
   {
@@ -437,7 +451,7 @@ EditLightWidget::EditLightWidget(QWidget* parent):
         }
       }
 
-      EditLightWidget::lightEdited();
+      d->coalescer.edit();
     }
     );
 
@@ -446,7 +460,7 @@ EditLightWidget::EditLightWidget(QWidget* parent):
     d->orthoRadius->setRange(0.1, 1000.0);
     d->orthoRadius->setDecimals(1);
     d->orthoRadius->setSingleStep(0.1);
-    connect(d->orthoRadius, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditLightWidget::lightEdited);
+    connect(d->orthoRadius, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this]{d->coalescer.edit();});
   }
 
   {
@@ -467,7 +481,7 @@ EditLightWidget::EditLightWidget(QWidget* parent):
         }
       }
 
-      EditLightWidget::lightEdited();
+      d->coalescer.edit();
     });
   }
 
@@ -476,17 +490,24 @@ EditLightWidget::EditLightWidget(QWidget* parent):
     l->addWidget(d->castShadows);
     connect(d->castShadows, &QCheckBox::clicked, this, &EditLightWidget::lightEdited);
   }
+
+  // Anything set while building the widget goes out now, before listeners are connected.
+  d->coalescer.flush();
+  d->coalescer.flushOnEditingFinished(this);
 }
 
 //##################################################################################################
 EditLightWidget::~EditLightWidget()
 {
+  d->coalescer.flush();
   delete d;
 }
 
 //##################################################################################################
 void EditLightWidget::setLight(const tp_math_utils::Light& light)
 {
+  d->coalescer.flush();
+
   blockSignals(true);
   TP_CLEANUP([&]{blockSignals(false);});
 
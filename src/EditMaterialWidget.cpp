@@ -1,14 +1,14 @@
 #include "tp_qt_maps_widget/EditMaterialWidget.h"
+#include "tp_qt_maps_widget/MaterialDelta.h"
+#include "tp_qt_maps_widget/EditCoalescer.h"
 
 #include "tp_qt_widgets/FileDialogLineEdit.h"
 #include "tp_qt_widgets/ColorButton.h"
 #include "tp_qt_widgets/WheelSafeScrollArea.h"
 
-#include "tp_image_utils/LoadImages.h"
+#include "tp_qt_maps/ConvertTexture.h"
 
-#include "tp_math_utils/materials/OpenGLMaterial.h"
-#include "tp_math_utils/materials/LegacyMaterial.h"
-#include "tp_math_utils/materials/ExternalMaterial.h"
+#include "tp_image_utils/LoadImages.h"
 
 #include "tp_utils/JSONUtils.h"
 
@@ -28,29 +28,35 @@
 #include <QScrollBar>
 #include <QMessageBox>
 
+#include <cstring>
+#include <set>
+
 namespace tp_qt_maps_widget
 {
 
 namespace
 {
 //##################################################################################################
-struct FloatEditor
+//! A collapsible group of rows, the rows are only created the first time it is expanded.
+struct Section_lt
 {
-  std::function<float()> get;
-  std::function<void(float)> set;
-};
+  QPushButton* expandButton{nullptr};
+  QWidget* contents{nullptr};
+  QGridLayout* gridLayout{nullptr};
 
-//##################################################################################################
-struct BoolEditor
-{
-  std::function<bool()> get;
-  std::function<void(bool)> set;
+  std::function<void(Section_lt&)> build;
+
+  //! Copy values from the material into the widgets, filled in as the rows are built.
+  std::vector<std::function<void()>> load;
+
+  bool built{false};
 };
 }
 
 //##################################################################################################
 struct EditMaterialWidget::Private
 {
+  EditMaterialWidget* q;
   tp_math_utils::Material material;
   TextureSupported textureSupported;
   TPGetExistingTexturesCallback getExistingTextures;
@@ -59,148 +65,336 @@ struct EditMaterialWidget::Private
 
   QLineEdit* nameEdit{nullptr};
 
-  QComboBox* shaderType{nullptr};
-
   tp_qt_widgets::WheelSafeScrollArea* scroll{nullptr};
   QWidget* scrollContents{nullptr};
 
-  tp_qt_widgets::ColorButton* albedoColorButton  {nullptr};
-  tp_qt_widgets::ColorButton* sssColorButton     {nullptr};
-  tp_qt_widgets::ColorButton* emissionColorButton{nullptr};
-  tp_qt_widgets::ColorButton* velvetColorButton  {nullptr};
-
-  FloatEditor albedoScaleSlider;
-  FloatEditor sssSlider;
-  FloatEditor emissionSlider;
-  FloatEditor velvetSlider;
-
-  FloatEditor alpha;
-  FloatEditor roughness;
-  FloatEditor metalness;
-  FloatEditor specular;
-  FloatEditor transmission;
-  FloatEditor transmissionRoughness;
-  FloatEditor sheen;
-  FloatEditor sheenTint;
-  FloatEditor clearCoat;
-  FloatEditor clearCoatRoughness;
-  FloatEditor iridescentFactor;
-  FloatEditor iridescentOffset;
-  FloatEditor iridescentFrequency;
-  FloatEditor heightScale;
-  FloatEditor heightMidlevel;
-  FloatEditor ior;
-  FloatEditor normalStrength;
-  QDoubleSpinBox* sssRadiusR{nullptr};
-  QDoubleSpinBox* sssRadiusG{nullptr};
-  QDoubleSpinBox* sssRadiusB{nullptr};
-
-  QComboBox* sssMethod{nullptr};
-
-  FloatEditor albedoBrightness;
-  FloatEditor albedoContrast;
-  FloatEditor albedoGamma;
-  FloatEditor albedoHue;
-  FloatEditor albedoSaturation;
-  FloatEditor albedoValue;
-  FloatEditor albedoFactor;
-
-  FloatEditor skewU;
-  FloatEditor skewV;
-
-  FloatEditor scaleU;
-  FloatEditor scaleV;
-
-  FloatEditor translateU;
-  FloatEditor translateV;
-
-  FloatEditor rotateUV;
-
-  FloatEditor useAmbient;
-  FloatEditor useDiffuse;
-  FloatEditor useNdotL;
-  FloatEditor useAttenuation;
-  FloatEditor useShadow;
-  FloatEditor useLightMask;
-  FloatEditor useReflection;
-
-  BoolEditor rayVisibilityCamera       ;
-  BoolEditor rayVisibilityDiffuse      ;
-  BoolEditor rayVisibilityGlossy       ;
-  BoolEditor rayVisibilityTransmission ;
-  BoolEditor rayVisibilityScatter      ;
-  BoolEditor rayVisibilityShadow       ;
-  BoolEditor rayVisibilityShadowCatcher;
+  std::vector<Section_lt> sections;
 
   std::map<std::string, QLineEdit*> textureLineEdits;
 
-  QLineEdit* blendFileLineEdit{nullptr};
+  // The value shown by each field's widgets, valid once its section has been built.
+  std::vector<MaterialFieldValue> shown;
+  std::vector<bool> shownValid;
+
+  // Edits that have been written to the material but not yet emitted.
+  MaterialDelta pendingDelta;
+  EditCoalescer coalescer;
+
+  // Everything edited since setMaterial() or setMaterials(), see applyEdits().
+  MaterialDelta edits;
+
+  // When editing several materials, the values that differ between them.
+  size_t materialCount{1};
+  std::vector<bool> mixed;
+  std::vector<QLabel*> mixedLabels;
+  std::set<std::string> mixedTextures;
+  bool mixedName{false};
+  bool mixedBlendFile{false};
+  QLineEdit* blendFileEdit{nullptr};
+
+  //################################################################################################
+  Private(EditMaterialWidget* q_, TextureSupported textureSupported_):
+    q(q_),
+    textureSupported(textureSupported_),
+    shown(materialFields().size()),
+    shownValid(materialFields().size(), false),
+    coalescer([&]{emitPending();}),
+    mixed(materialFields().size(), false),
+    mixedLabels(materialFields().size(), nullptr)
+  {
+    material.findOrAddOpenGL();
+    material.findOrAddLegacy();
+  }
 
   //################################################################################################
-  void updateColors()
+  void addSection(QVBoxLayout* l, const QString& name, bool expanded, const std::function<void(Section_lt&)>& build)
   {
-    auto openGLMaterial = material.findOrAddOpenGL();
-    auto legacyMaterial = material.findOrAddLegacy();
+    size_t index = sections.size();
+    auto& section = sections.emplace_back();
+    section.build = build;
+
+    auto hLayout = new QHBoxLayout();
+    hLayout->setContentsMargins(0,0,0,0);
+    l->addLayout(hLayout);
+
+    QIcon normalIcon = tp_qt_maps::loadIconFromResource("/omi_scene_builder/right_chevron.png");
+    QIcon expandedIcon = tp_qt_maps::loadIconFromResource("/omi_scene_builder/down_chevron.png");
+
+    section.expandButton = new QPushButton(normalIcon, "");
+    section.expandButton->setStyleSheet("QPushButton{border:none;background-color:rgba(255, 255, 255,0);}");
+    int size = 16;
+    section.expandButton->setIconSize(QSize(size,size));
+    section.expandButton->setMinimumSize(size,size);
+    section.expandButton->setMaximumSize(size,size);
+    section.expandButton->setCheckable(true);
+    hLayout->addWidget(section.expandButton);
+
+    hLayout->addWidget(new QLabel(QString("<h3>%1</h3>").arg(name)), 1, Qt::AlignLeft);
 
-    albedoColorButton  ->setColor<glm::vec3>(openGLMaterial->albedo  );
-    sssColorButton     ->setColor<glm::vec3>(legacyMaterial->sss     );
-    emissionColorButton->setColor<glm::vec3>(legacyMaterial->emission);
-    velvetColorButton  ->setColor<glm::vec3>(legacyMaterial->velvet  );
+    section.contents = new QWidget();
+    section.contents->setVisible(false);
+    l->addWidget(section.contents);
+
+    QObject::connect(section.expandButton, &QAbstractButton::toggled, q, [=](bool b)
+    {
+      auto& s = sections.at(index);
+      s.expandButton->setIcon(b?expandedIcon:normalIcon);
+
+      if(b && !s.built)
+        buildSection(s);
+
+      s.contents->setVisible(b);
+    });
+
+    section.expandButton->setChecked(expanded);
   }
-};
 
-//##################################################################################################
-EditMaterialWidget::EditMaterialWidget(TextureSupported textureSupported,
-                                       const std::function<void(QLayout*)>& addButtons, QWidget* parent):
-  QWidget(parent),
-  d(new Private())
-{
-  d->textureSupported = textureSupported;
+  //################################################################################################
+  void buildSection(Section_lt& section)
+  {
+    section.gridLayout = new QGridLayout(section.contents);
+    section.gridLayout->setContentsMargins(0,0,0,0);
+    section.build(section);
+    section.built = true;
+    loadSection(section);
+    updateMixed();
+  }
 
-  auto mainLayout = new QVBoxLayout(this);
-  mainLayout->setContentsMargins(0,0,0,0);
+  //################################################################################################
+  void loadSection(Section_lt& section)
+  {
+    for(const auto& load : section.load)
+      load();
+  }
 
+  //################################################################################################
+  //! Record what a field's widgets now show, so that setMaterial() can skip it if it is unchanged.
+  void setShown(size_t field)
   {
-    auto ll = new QHBoxLayout();
-    mainLayout->addLayout(ll);
-    ll->setContentsMargins(0,0,0,0);
-    ll->addWidget(new QLabel("Name"));
-    d->nameEdit = new QLineEdit();
-    ll->addWidget(d->nameEdit);
-    connect(d->nameEdit, &QLineEdit::editingFinished, this, &EditMaterialWidget::materialEdited);
+    shown.at(field) = materialFieldValue(material, field);
+    shownValid.at(field) = true;
   }
 
-  d->scroll = new tp_qt_widgets::WheelSafeScrollArea();
-  d->scroll->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-  d->scroll->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-  d->scroll->setWidgetResizable(true);
-  mainLayout->addWidget(d->scroll);
+  //################################################################################################
+  //! Called after a widget has written a field into the material.
+  void fieldEdited(size_t field)
+  {
+    setShown(field);
 
-  d->scrollContents = new QWidget();
-  d->scroll->setWidget(d->scrollContents);
-  d->scrollContents->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::MinimumExpanding);
-  d->scrollContents->installEventFilter(this);
+    MaterialDelta delta;
+    delta.setField(field, shown.at(field));
+    queueEdit(delta, true);
+  }
 
-  auto l = new QVBoxLayout(d->scrollContents);
-  l->setContentsMargins(4,4,4,4);
+  //################################################################################################
+  //! Apply an edit made by the user to the material and notify listeners.
+  void applyEdit(const MaterialDelta& delta)
+  {
+    delta.apply(material);
+    queueEdit(delta, false);
+  }
+
+  //################################################################################################
+  //! Queue an edit that is already in the material, continuous edits such as drags are coalesced.
+  void queueEdit(const MaterialDelta& delta, bool continuous)
+  {
+    // Listeners are only told about edits that change something.
+    if(delta.empty())
+      return;
+
+    clearMixed(delta);
+    edits.merge(delta);
+    pendingDelta.merge(delta);
+    coalescer.edit();
+    if(!continuous)
+      coalescer.flush();
+  }
+
+  //################################################################################################
+  void resetBatch(size_t count)
+  {
+    materialCount = count;
+    std::fill(mixed.begin(), mixed.end(), false);
+    mixedTextures.clear();
+    mixedName = false;
+    mixedBlendFile = false;
+    edits = MaterialDelta();
+  }
+
+  //################################################################################################
+  //! Compare each material with the first, this touches no widgets so that it scales to large sets.
+  void findMixed(const std::vector<tp_math_utils::Material>& materials)
+  {
+    const auto& first = materials.front();
+
+    const auto& fields = materialFields();
+    std::vector<MaterialFieldValue> firstValues(fields.size());
+    for(size_t i=0; i<fields.size(); i++)
+      firstValues.at(i) = materialFieldValue(first, i);
+
+    std::vector<std::pair<std::string, std::string>> firstTextures;
+    viewMaterialTextureTypes(first, [&](const std::string& type, const std::string&)
+    {
+      firstTextures.emplace_back(type, materialTexture(first, type));
+    });
+
+    auto firstBlendFile = materialBlendFile(first);
+
+    for(size_t m=1; m<materials.size(); m++)
+    {
+      const auto& other = materials.at(m);
+
+      for(size_t i=0; i<fields.size(); i++)
+        if(!mixed.at(i) && materialFieldValue(other, i) != firstValues.at(i))
+          mixed.at(i) = true;
+
+      for(const auto& [type, name] : firstTextures)
+        if(mixedTextures.count(type)==0 && materialTexture(other, type) != name)
+          mixedTextures.insert(type);
+
+      if(!(other.name == first.name))
+        mixedName = true;
 
-  auto gridLayout = new QGridLayout();
-  gridLayout->setContentsMargins(0,0,0,0);
-  l->addLayout(gridLayout);
+      if(!mixedBlendFile && materialBlendFile(other) != firstBlendFile)
+        mixedBlendFile = true;
+    }
+  }
+
+  //################################################################################################
+  //! Add the values from material for everything that is mixed, used when pasting onto a set.
+  void addMixed(MaterialDelta& delta, const tp_math_utils::Material& material)
+  {
+    for(size_t i=0; i<mixed.size(); i++)
+      if(mixed.at(i))
+        delta.setField(i, materialFieldValue(material, i));
+
+    for(const auto& type : mixedTextures)
+      delta.setTexture(type, materialTexture(material, type));
+
+    if(mixedBlendFile)
+      delta.setBlendFile(materialBlendFile(material));
+  }
+
+  //################################################################################################
+  //! Once edited a value is the same on every material, only the edited values are updated.
+  void clearMixed(const MaterialDelta& delta)
+  {
+    for(const auto& change : delta.fields)
+    {
+      if(!mixed.at(change.field))
+        continue;
+
+      mixed.at(change.field) = false;
+      if(auto label = mixedLabels.at(change.field); label)
+        label->setVisible(false);
+    }
+
+    for(const auto& change : delta.textures)
+    {
+      if(mixedTextures.erase(change.type)==0)
+        continue;
+
+      if(auto i = textureLineEdits.find(change.type); i != textureLineEdits.end())
+        showMixed(i->second, false);
+    }
+
+    if(delta.nameChanged && mixedName)
+    {
+      mixedName = false;
+      showMixed(nameEdit, false);
+    }
+
+    if(delta.blendFileChanged && mixedBlendFile)
+    {
+      mixedBlendFile = false;
+      showMixed(blendFileEdit, false);
+    }
+  }
+
+  //################################################################################################
+  //! Mixed names and textures are shown as an empty placeholder.
+  static void showMixed(QLineEdit* edit, bool isMixed)
+  {
+    if(!edit)
+      return;
+
+    edit->setPlaceholderText(isMixed?"Mixed":"");
+    if(isMixed && !edit->text().isEmpty())
+      edit->clear();
+  }
+
+  //################################################################################################
+  //! Show which values are mixed.
+  void updateMixed()
+  {
+    for(size_t i=0; i<mixedLabels.size(); i++)
+      if(auto label = mixedLabels.at(i); label)
+        label->setVisible(mixed.at(i));
+
+    showMixed(nameEdit, mixedName);
+    showMixed(blendFileEdit, mixedBlendFile);
+    for(const auto& i : textureLineEdits)
+      showMixed(i.second, mixedTextures.count(i.first)!=0);
+  }
 
-  //------------------------------------------------------------------------------------------------
-  auto makeFloatEditor = [&](float min, float max, int row, const bool linear)
+  //################################################################################################
+  void loadMaterial(const tp_math_utils::Material& material_)
   {
-    float scale = max - min;
+    q->blockSignals(true);
+    TP_CLEANUP([&]{q->blockSignals(false);});
+
+    material = material_;
+    material.findOrAddOpenGL();
+    material.findOrAddLegacy();
 
-    FloatEditor floatEditor;
+    if(auto name = QString::fromStdString(material.name.toString()); name != nameEdit->text())
+      nameEdit->setText(name);
+
+    // Only widgets whose field differs from what they show are touched.
+    for(auto& section : sections)
+      if(section.built)
+        loadSection(section);
+
+    updateMixed();
+  }
+
+  //################################################################################################
+  void emitPending()
+  {
+    MaterialDelta delta;
+    std::swap(delta, pendingDelta);
+    Q_EMIT q->materialDeltaEdited(delta);
+    Q_EMIT q->materialEdited();
+  }
+
+  //################################################################################################
+  //! Adds a load function that only calls update if the field differs from what is shown.
+  void addFieldLoad(Section_lt& section, size_t field, const std::function<void(const MaterialFieldValue&)>& update)
+  {
+    section.load.push_back([this, field, update]
+    {
+      auto value = materialFieldValue(material, field);
+      if(shownValid.at(field) && shown.at(field) == value)
+        return;
+
+      update(value);
+      shown.at(field) = value;
+      shownValid.at(field) = true;
+    });
+  }
+
+  //################################################################################################
+  //! A spin box and slider for the float of a Float or Color field, returns a function to set it.
+  std::function<void(float)> makeFloatEditor(Section_lt& section, int row, size_t field)
+  {
+    const auto& f = materialFields().at(field);
 
     auto hLayout = new QHBoxLayout();
     hLayout->setContentsMargins(0,0,0,0);
-    gridLayout->addLayout(hLayout, row, 1);
+    section.gridLayout->addLayout(hLayout, row, 1);
 
     auto spin = new QDoubleSpinBox();
-    spin->setRange(double(min), double(max));
+    spin->setRange(double(f.min), double(f.max));
     spin->setDecimals(3);
     spin->setSingleStep(0.01);
     hLayout->addWidget(spin, 1);
@@ -209,337 +403,399 @@ EditMaterialWidget::EditMaterialWidget(TextureSupported textureSupported,
     slider->setRange(0, 100000);
     hLayout->addWidget(slider, 3);
 
-    connect(slider, &QSlider::valueChanged, this, [this, spin, slider, scale, min, linear]
+    QObject::connect(slider, &QSlider::valueChanged, q, [this, spin, slider, field]
     {
-      float v = float(slider->value()) / 100000.0f;
-      v = linear?((v*scale) + min):(v*v*scale);
+      const auto& f = materialFields().at(field);
+      float v = f.fromSlider(float(slider->value()) / 100000.0f);
       if(std::fabs(v-float(spin->value())) > 0.000001f)
       {
         spin->blockSignals(true);
         spin->setValue(double(v));
         spin->blockSignals(false);
-        Q_EMIT materialEdited();
+        *f.floatField(material) = float(spin->value());
+        fieldEdited(field);
       }
     });
 
-    auto spinValueChanged = [this, slider, spin, linear, scale, min]
+    QObject::connect(slider, &QSlider::sliderReleased, q, [this]{coalescer.flush();});
+    QObject::connect(spin, &QDoubleSpinBox::editingFinished, q, [this]{coalescer.flush();});
+
+    auto updateSlider = [slider, spin, field]
     {
       if(slider->isSliderDown())
         return;
 
-      auto s = (float(spin->value())-min)/scale;
-      int newSliderValue = int((linear?s:std::sqrt(s))*100000.0f);
+      int newSliderValue = int(materialFields().at(field).toSlider(float(spin->value()))*100000.0f);
       if(newSliderValue != slider->value())
       {
         slider->blockSignals(true);
         slider->setValue(newSliderValue);
         slider->blockSignals(false);
-        Q_EMIT materialEdited();
       }
     };
 
-    connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, spinValueChanged);
+    QObject::connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), q, [this, updateSlider, field](double v)
+    {
+      *materialFields().at(field).floatField(material) = float(v);
+      updateSlider();
+      fieldEdited(field);
+    });
 
-    floatEditor.get = [=]{return spin->value();};
-    floatEditor.set = [=](float v)
+    return [spin, updateSlider](float v)
     {
+      spin->blockSignals(true);
       spin->setValue(double(v));
-      spinValueChanged();
+      spin->blockSignals(false);
+      updateSlider();
     };
+  }
 
-    return floatEditor;
-  };
-
-  //------------------------------------------------------------------------------------------------
-  auto makeColorEdit = [&](const QString& text, const std::function<glm::vec3&()>& getColor, FloatEditor& slider, float scaleMax, const bool linear)
+  //################################################################################################
+  //! Create the widgets for a field from the table.
+  void makeFieldRow(Section_lt& section, size_t field)
   {
-    int row = gridLayout->rowCount();
+    const auto& f = materialFields().at(field);
+    int row = section.gridLayout->rowCount();
 
-    auto button = new tp_qt_widgets::ColorButton(text);
-    gridLayout->addWidget(button, row, 0);
+    switch(f.type)
+    {
+      case MaterialFieldType::Float:
+      {
+        section.gridLayout->addWidget(new QLabel(f.name), row, 0, Qt::AlignLeft);
+        auto setSpin = makeFloatEditor(section, row, field);
+        addFieldLoad(section, field, [setSpin](const MaterialFieldValue& value){setSpin(value.f);});
+        break;
+      }
 
-    slider = makeFloatEditor(0.0f, scaleMax, row, linear);
+      case MaterialFieldType::Color:
+      {
+        auto button = new tp_qt_widgets::ColorButton(f.name);
+        section.gridLayout->addWidget(button, row, 0);
 
-    button->edited.addCallback([this, button, getColor]()
-    {
-      QColor color = button->qColor();
+        auto setSpin = makeFloatEditor(section, row, field);
 
-      glm::vec3& c = getColor();
-      c.x = color.redF();
-      c.y = color.greenF();
-      c.z = color.blueF();
+        button->edited.addCallback([this, button, field]()
+        {
+          QColor color = button->qColor();
 
-      d->updateColors();
-      Q_EMIT materialEdited();
-    });
+          glm::vec3& c = *materialFields().at(field).vec3Field(material);
+          c.x = color.redF();
+          c.y = color.greenF();
+          c.z = color.blueF();
 
-    return button;
-  };
+          button->setColor<glm::vec3>(c);
+          fieldEdited(field);
+        });
 
-  //------------------------------------------------------------------------------------------------
-  auto makeFloatEditorRow = [&](const QString& name, float min, float scaleMax, bool linear)
-  {
-    int row = gridLayout->rowCount();
-    gridLayout->addWidget(new QLabel(name), row, 0, Qt::AlignLeft);
-    return makeFloatEditor(min, scaleMax, row, linear);
-  };
+        addFieldLoad(section, field, [button, setSpin](const MaterialFieldValue& value)
+        {
+          button->setColor<glm::vec3>(value.v);
+          setSpin(value.f);
+        });
+        break;
+      }
 
-  //------------------------------------------------------------------------------------------------
-  auto makeBoolEditorRow = [&](const QString& name)
-  {
-    BoolEditor boolEditor;
+      case MaterialFieldType::Bool:
+      {
+        auto check = new QCheckBox(f.name);
+        section.gridLayout->addWidget(check, row, 1);
 
-    int row = gridLayout->rowCount();
+        QObject::connect(check, &QCheckBox::toggled, q, [this, field](bool v)
+        {
+          *materialFields().at(field).boolField(material) = v;
+          fieldEdited(field);
+        });
 
-    auto check = new QCheckBox(name);
-    gridLayout->addWidget(check, row, 1);
+        addFieldLoad(section, field, [check](const MaterialFieldValue& value)
+        {
+          check->blockSignals(true);
+          check->setChecked(value.b);
+          check->blockSignals(false);
+        });
+        break;
+      }
 
-    connect(check, &QCheckBox::toggled, this, &EditMaterialWidget::materialEdited);
+      case MaterialFieldType::Vec3:
+      {
+        section.gridLayout->addWidget(new QLabel(f.name), row, 0, Qt::AlignLeft);
 
-    boolEditor.get = [=]{return check->isChecked();};
-    boolEditor.set = [=](bool v){check->setChecked(v);};
+        auto ll = new QHBoxLayout();
+        section.gridLayout->addLayout(ll, row, 1);
 
-    return boolEditor;
-  };
+        std::array<QDoubleSpinBox*, 3> spins;
+        for(glm::vec3::length_type c=0; c<3; c++)
+        {
+          auto spin = new QDoubleSpinBox();
+          ll->addWidget(spin);
+          spin->setRange(double(f.min), double(f.max));
+          spins.at(size_t(c)) = spin;
 
-  //------------------------------------------------------------------------------------------------
-  auto addTitle = [&](const QString& name)
-  {
-    int row = gridLayout->rowCount();
-    gridLayout->addWidget(new QLabel(QString("<h3>%1</h3>").arg(name)), row, 0, 1, 2, Qt::AlignLeft);
-  };
+          QObject::connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), q, [this, field, c](double v)
+          {
+            (*materialFields().at(field).vec3Field(material))[c] = float(v);
+            fieldEdited(field);
+          });
+        }
 
+        addFieldLoad(section, field, [spins](const MaterialFieldValue& value)
+        {
+          for(glm::vec3::length_type c=0; c<3; c++)
+          {
+            auto spin = spins.at(size_t(c));
+            spin->blockSignals(true);
+            spin->setValue(double(value.v[c]));
+            spin->blockSignals(false);
+          }
+        });
+        break;
+      }
 
-  addTitle("Shader Type");
-  {
-    d->shaderType = new QComboBox();
-    d->shaderType->addItems({"Principled", "None"});
-    int row = gridLayout->rowCount();
-    gridLayout->addWidget(new QLabel("Shader type"), row, 0, Qt::AlignLeft);
-    gridLayout->addWidget(d->shaderType, row, 1);
-    connect(d->shaderType, &QComboBox::currentTextChanged, this, [this]{emit materialEdited();});
+      case MaterialFieldType::Choice:
+      {
+        auto combo = new QComboBox();
+        for(auto choice : f.choices)
+          if(choice)
+            combo->addItem(choice);
+        section.gridLayout->addWidget(new QLabel(f.name), row, 0, Qt::AlignLeft);
+        section.gridLayout->addWidget(combo, row, 1);
+
+        QObject::connect(combo, &QComboBox::currentTextChanged, q, [this, field](const QString& text)
+        {
+          materialFields().at(field).setChoice(material, text.toStdString());
+          fieldEdited(field);
+        });
+
+        addFieldLoad(section, field, [combo](const MaterialFieldValue& value)
+        {
+          combo->blockSignals(true);
+          combo->setCurrentText(QString::fromStdString(value.s));
+          combo->blockSignals(false);
+        });
+        break;
+      }
+    }
+
+    auto mixedLabel = new QLabel("Mixed");
+    mixedLabel->setToolTip("The materials being edited have different values, an edit sets them all.");
+    mixedLabel->setVisible(false);
+    section.gridLayout->addWidget(mixedLabel, row, 2);
+    mixedLabels.at(field) = mixedLabel;
   }
 
-  addTitle("Colors");
-  d->albedoColorButton   = makeColorEdit("Albedo"    , [&]()->glm::vec3&{return d->material.findOrAddOpenGL()->albedo;}  , d->albedoScaleSlider  ,     4.0f, false);
-  d->sssColorButton      = makeColorEdit("Subsurface", [&]()->glm::vec3&{return d->material.findOrAddLegacy()->sss;}     , d->sssSlider          ,     1.0f, false);
-  d->emissionColorButton = makeColorEdit("Emission"  , [&]()->glm::vec3&{return d->material.findOrAddLegacy()->emission;}, d->emissionSlider     , 50000.0f, false);
-  d->velvetColorButton   = makeColorEdit("Velvet"    , [&]()->glm::vec3&{return d->material.findOrAddLegacy()->velvet;}  , d->velvetSlider       ,     1.0f, false);
-
-
-  addTitle("Material Properties");
-  d->alpha                 = makeFloatEditorRow("Alpha"                 , 0.0f,  1.0f, true);
-  d->roughness             = makeFloatEditorRow("Roughness"             , 0.0f,  1.0f, true);
-  d->metalness             = makeFloatEditorRow("Metalness"             , 0.0f,  1.0f, true);
-  d->specular              = makeFloatEditorRow("Specular"              , 0.0f,  1.0f, true);
-  d->transmission          = makeFloatEditorRow("Transmission"          , 0.0f,  1.0f, true);
-  d->transmissionRoughness = makeFloatEditorRow("Transmission roughness", 0.0f,  1.0f, true);
-  d->ior                   = makeFloatEditorRow("IOR"                   , 0.0f,  6.0f, true);
-  d->sheen                 = makeFloatEditorRow("Sheen"                 , 0.0f,  1.0f, true);
-  d->sheenTint             = makeFloatEditorRow("Sheen tint"            , 0.0f,  1.0f, true);
-  d->clearCoat             = makeFloatEditorRow("Clear coat"            , 0.0f,  1.0f, true);
-  d->clearCoatRoughness    = makeFloatEditorRow("Clear coat roughness"  , 0.0f,  1.0f, true);
-  d->iridescentFactor      = makeFloatEditorRow("Iridescent factor"     , 0.0f,  1.0f, true);
-  d->iridescentOffset      = makeFloatEditorRow("Iridescent offset"     , 0.0f,  1.0f, true);
-  d->iridescentFrequency   = makeFloatEditorRow("Iridescent frequency"  , 0.0f, 20.0f, false);
-  d->normalStrength        = makeFloatEditorRow("Normal strength"       , 0.1f, 10.0f, false);
-
-  {
-    int row = gridLayout->rowCount();
-    gridLayout->addWidget(new QLabel("Subsurface radius"), row, 0, Qt::AlignLeft);
+  //################################################################################################
+  void makeTextureBlendEdit(Section_lt& section,
+                            const QString& name,
+                            bool isBlendFile,
+                            const std::string& type=std::string())
+  {
+    int row = section.gridLayout->rowCount();
+    section.gridLayout->addWidget(new QLabel(name), row, 0, Qt::AlignLeft);
 
     auto ll = new QHBoxLayout();
-    gridLayout->addLayout(ll, row, 1);
+    section.gridLayout->addLayout(ll, row, 1);
+
+    auto edit = new QLineEdit();
+    ll->addWidget(edit);
 
-    auto make = [&]
+    auto apply = [this, edit, isBlendFile, type]
     {
-      auto spin = new QDoubleSpinBox();
-      ll->addWidget(spin);
-      spin->setRange(0.0, 100.0);
-      connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EditMaterialWidget::materialEdited);
-      return spin;
+      MaterialDelta delta;
+      if(isBlendFile)
+        delta.setBlendFile(edit->text().toStdString());
+      else
+        delta.setTexture(type, edit->text().toStdString());
+      applyEdit(delta);
     };
 
-    d->sssRadiusR = make();
-    d->sssRadiusG = make();
-    d->sssRadiusB = make();
-  }
+    // Only apply typed edits, so that leaving a mixed edit empty doesn't clear every material.
+    QObject::connect(edit, &QLineEdit::editingFinished, q, [edit, apply]
+    {
+      if(!edit->isModified())
+        return;
+      edit->setModified(false);
+      apply();
+    });
 
-  {
-    d->sssMethod = new QComboBox();
-    d->sssMethod->addItems({"ChristensenBurley", "RandomWalk", "RandomWalkFixedRadius"});
-    int row = gridLayout->rowCount();
-    gridLayout->addWidget(new QLabel("Subsurface method"), row, 0, Qt::AlignLeft);
-    gridLayout->addWidget(d->sssMethod, row, 1);
-    connect(d->sssMethod, &QComboBox::currentTextChanged, this, [this]{emit materialEdited();});
-  }
+    auto button = new QPushButton("Load");
+    ll->addWidget(button);
+    QObject::connect(button, &QPushButton::clicked, q, [this, edit, isBlendFile, apply]
+    {
+      showLoadDialog(edit, isBlendFile, apply);
+    });
 
+    edit->installEventFilter(q);
 
-  addTitle("Albedo Color Modification");
-  d->albedoBrightness  = makeFloatEditorRow("Albedo brightness", -50.0f, 50.0f, true);
-  d->albedoContrast    = makeFloatEditorRow("Albedo contrast"  , -50.0f, 50.0f, true);
-  d->albedoGamma       = makeFloatEditorRow("Albedo gamma"     ,   0.0f, 50.0f, true);
-  d->albedoHue         = makeFloatEditorRow("Albedo hue shift" ,   0.0f,  1.0f, true);
-  d->albedoSaturation  = makeFloatEditorRow("Albedo saturation",   0.0f, 10.0f, true);
-  d->albedoValue       = makeFloatEditorRow("Albedo value"     ,   0.0f, 10.0f, true);
-  d->albedoFactor      = makeFloatEditorRow("Albedo factor"    ,   0.0f,  1.0f, true);
+    if(!type.empty())
+      textureLineEdits[type] = edit;
 
+    if(isBlendFile)
+      blendFileEdit = edit;
 
-  addTitle("Displacement");
-  d->heightScale    = makeFloatEditorRow("Height scale"   , 0.0f, 1.0f, true);
-  d->heightMidlevel = makeFloatEditorRow("Height midlevel", 0.0f, 1.0f, true);
+    section.load.push_back([this, edit, isBlendFile, type]
+    {
+      auto value = isBlendFile?materialBlendFile(material):materialTexture(material, type);
+      if(auto text = QString::fromStdString(value); text != edit->text())
+        edit->setText(text);
+    });
+  }
 
+  //################################################################################################
+  void showLoadDialog(QLineEdit* edit, bool isBlendFile, const std::function<void()>& apply)
+  {
+    QPointer<QDialog> dialog = new QDialog(q);
+    TP_CLEANUP([&]{delete dialog;});
 
-  addTitle("Texture Transformation");
-  d->skewU      = makeFloatEditorRow("Skew U"     ,  -70.00f,  70.0f, true );
-  d->skewV      = makeFloatEditorRow("Skew V"     ,  -70.00f,  70.0f, true );
+    auto l = new QVBoxLayout(dialog);
 
-  d->scaleU     = makeFloatEditorRow("Scale U"    ,    0.01f,  10.0f, false);
-  d->scaleV     = makeFloatEditorRow("Scale V"    ,    0.01f,  10.0f, false);
+    auto existingRadio = new QRadioButton("Existing");
+    l->addWidget(existingRadio);
+    auto existing = new QComboBox();
+    l->addWidget(existing);
+    existing->setEnabled(false);
 
-  d->translateU = makeFloatEditorRow("Translate U",    0.00f,   5.0f, true );
-  d->translateV = makeFloatEditorRow("Translate V",    0.00f,   5.0f, true );
+    if(getExistingTextures)
+    {
+      for(const auto& name : getExistingTextures())
+        existing->addItem(QString::fromStdString(name.toString()));
+    }
 
-  d->rotateUV   = makeFloatEditorRow("Rotate UV"  , -180.00f, 180.0f, true );
+    auto loadRadio = new QRadioButton("Load");
+    loadRadio->setChecked(true);
+    l->addWidget(loadRadio);
+    auto load = new tp_qt_widgets::FileDialogLineEdit();
+    load->setQSettingsPath("EditMaterialWidget");
+    load->setMode(tp_qt_widgets::FileDialogLineEdit::OpenFileMode);
+    if(isBlendFile)
+      load->setFilter(QString::fromStdString("*.blend"));
+    else
+      load->setFilter(QString::fromStdString(tp_image_utils::imageTypesFilter()));
 
+    l->addWidget(load);
 
-  addTitle("Texture Maps");
-  auto addTextureBlendEdit = [&](const auto& name, bool isBlendFile=false)
-  {
-    int row = gridLayout->rowCount();
-    gridLayout->addWidget(new QLabel(name), row, 0, Qt::AlignLeft);
+    QObject::connect(loadRadio, &QRadioButton::toggled, q, [=]
+    {
+      existing->setEnabled(existingRadio->isChecked());
+      load->setEnabled(loadRadio->isChecked());
+    });
 
-    auto ll = new QHBoxLayout();
-    gridLayout->addLayout(ll, row, 1);
+    l->addStretch();
+    auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    l->addWidget(buttonBox);
+    QObject::connect(buttonBox, &QDialogButtonBox::accepted, dialog, &QDialog::accept);
+    QObject::connect(buttonBox, &QDialogButtonBox::rejected, dialog, &QDialog::reject);
 
-    auto edit = new QLineEdit();
-    ll->addWidget(edit);
-    connect(edit, &QLineEdit::editingFinished, this, &EditMaterialWidget::materialEdited);
+    if(dialog->exec() != QDialog::Accepted)
+      return;
 
-    auto button = new QPushButton("Load");
-    ll->addWidget(button);
-    connect(button, &QPushButton::clicked, this, [this, edit, isBlendFile]
+    if(existingRadio->isChecked() && !existing->currentText().isEmpty())
     {
-      QPointer<QDialog> dialog = new QDialog(this);
-      TP_CLEANUP([&]{delete dialog;});
-
-      auto l = new QVBoxLayout(dialog);
-
-      auto existingRadio = new QRadioButton("Existing");
-      l->addWidget(existingRadio);
-      auto existing = new QComboBox();
-      l->addWidget(existing);
-      existing->setEnabled(false);
+      edit->setText(existing->currentText());
+      apply();
+    }
+    else if(loadRadio->isChecked())
+    {
+      const auto& loadCallback = isBlendFile?loadMaterialBlend:loadTexture;
+      if(!loadCallback)
+        return;
 
-      if(d->getExistingTextures)
+      std::string error;
+      auto text = loadCallback(load->text().toStdString(), error);
+      if(text.isValid())
       {
-        for(const auto& name : d->getExistingTextures())
-          existing->addItem(QString::fromStdString(name.toString()));
+        edit->setText(QString::fromStdString(text.toString()));
+        apply();
       }
 
-      auto loadRadio = new QRadioButton("Load");
-      loadRadio->setChecked(true);
-      l->addWidget(loadRadio);
-      auto load = new tp_qt_widgets::FileDialogLineEdit();
-      load->setQSettingsPath("EditMaterialWidget");
-      load->setMode(tp_qt_widgets::FileDialogLineEdit::OpenFileMode);
-      if(isBlendFile)
-        load->setFilter(QString::fromStdString("*.blend"));
-      else
-        load->setFilter(QString::fromStdString(tp_image_utils::imageTypesFilter()));
-        
-      l->addWidget(load);
+      if(!error.empty())
+        QMessageBox::critical(q, isBlendFile?"Error Loading Blend Material!":"Error Loading Image!", QString::fromStdString(error));
+    }
+  }
+};
 
-      connect(loadRadio, &QRadioButton::toggled, this, [=]
-      {
-        existing->setEnabled(existingRadio->isChecked());
-        load->setEnabled(loadRadio->isChecked());
-      });
+//##################################################################################################
+EditMaterialWidget::EditMaterialWidget(TextureSupported textureSupported,
+                                       const std::function<void(QLayout*)>& addButtons, QWidget* parent):
+  QWidget(parent),
+  d(new Private(this, textureSupported))
+{
+  // So that materialDeltaEdited() can be used with queued connections.
+  qRegisterMetaType<MaterialDelta>("tp_qt_maps_widget::MaterialDelta");
 
-      l->addStretch();
-      auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
-      l->addWidget(buttonBox);
-      connect(buttonBox, &QDialogButtonBox::accepted, dialog, &QDialog::accept);
-      connect(buttonBox, &QDialogButtonBox::rejected, dialog, &QDialog::reject);
+  auto mainLayout = new QVBoxLayout(this);
+  mainLayout->setContentsMargins(0,0,0,0);
 
-      if(dialog->exec() == QDialog::Accepted)
-      {
-        if(existingRadio->isChecked() && !existing->currentText().isEmpty())
-        {
-          edit->setText(existing->currentText());
-          Q_EMIT materialEdited();
-        }
-        else if(loadRadio->isChecked())
-        {
-          if(isBlendFile)
-          {
-              std::string error;
-              auto text = d->loadMaterialBlend(load->text().toStdString(), error);
-              if(text.isValid())
-              {
-                  edit->setText(QString::fromStdString(text.toString()));
-                  Q_EMIT materialEdited();
-              }
-
-              if(!error.empty())
-                  QMessageBox::critical(this, "Error Loading Blend Material!", QString::fromStdString(error));
-          }
-          else if(d->loadTexture)
-          {
-              std::string error;
-              auto text = d->loadTexture(load->text().toStdString(), error);
-              if(text.isValid())
-              {
-                  edit->setText(QString::fromStdString(text.toString()));
-                  Q_EMIT materialEdited();
-              }
-
-              if(!error.empty())
-                  QMessageBox::critical(this, "Error Loading Image!", QString::fromStdString(error));
-          }
-        }
+  {
+    auto ll = new QHBoxLayout();
+    mainLayout->addLayout(ll);
+    ll->setContentsMargins(0,0,0,0);
+    ll->addWidget(new QLabel("Name"));
+    d->nameEdit = new QLineEdit();
+    ll->addWidget(d->nameEdit);
+    connect(d->nameEdit, &QLineEdit::editingFinished, this, [this]
+    {
+      if(!d->nameEdit->isModified())
+        return;
+      d->nameEdit->setModified(false);
 
-        }
+      MaterialDelta delta;
+      delta.setName(d->nameEdit->text().toStdString());
+      d->applyEdit(delta);
     });
+  }
 
-    edit->installEventFilter(this);
+  d->scroll = new tp_qt_widgets::WheelSafeScrollArea();
+  d->scroll->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+  d->scroll->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+  d->scroll->setWidgetResizable(true);
+  mainLayout->addWidget(d->scroll);
 
-    return edit;
-  };
+  d->scrollContents = new QWidget();
+  d->scroll->setWidget(d->scrollContents);
+  d->scrollContents->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::MinimumExpanding);
+  d->scrollContents->installEventFilter(this);
 
-  if(textureSupported == TextureSupported::Yes)
+  auto l = new QVBoxLayout(d->scrollContents);
+  l->setContentsMargins(4,4,4,4);
+
+  // Sections are only built when first expanded, until then the material holds their values.
+  auto addFieldsSection = [&](const char* name, bool expanded)
   {
-    d->material.findOrAddOpenGL()->viewTypedTextures([this, addTextureBlendEdit](const auto& type, const auto&, const auto& pretty)
+    d->addSection(l, name, expanded, [this, name](Section_lt& s)
     {
-      d->textureLineEdits[type] = addTextureBlendEdit(pretty);
+      const auto& fields = materialFields();
+      for(size_t i=0; i<fields.size(); i++)
+        if(std::strcmp(fields.at(i).section, name) == 0)
+          d->makeFieldRow(s, i);
     });
+  };
+
+  addFieldsSection("Shader Type", true);
+  addFieldsSection("Colors", true);
+  addFieldsSection("Material Properties", false);
+  addFieldsSection("Albedo Color Modification", false);
+  addFieldsSection("Displacement", false);
+  addFieldsSection("Texture Transformation", false);
 
-    d->material.findOrAddLegacy()->viewTypedTextures([this, addTextureBlendEdit](const auto& type, const auto&, const auto& pretty)
+  if(textureSupported == TextureSupported::Yes)
+  {
+    d->addSection(l, "Texture Maps", false, [this](Section_lt& s)
     {
-      d->textureLineEdits[type] = addTextureBlendEdit(pretty);
+      viewMaterialTextureTypes(d->material, [&](const std::string& type, const std::string& pretty)
+      {
+        d->makeTextureBlendEdit(s, QString::fromStdString(pretty), false, type);
+      });
     });
   }
 
-  addTitle(".Blend Material");
-  d->blendFileLineEdit = addTextureBlendEdit(".blend material", true);
+  d->addSection(l, ".Blend Material", false, [this](Section_lt& s)
+  {
+    d->makeTextureBlendEdit(s, ".blend material", true);
+  });
 
-  addTitle("OpenGL Shading Calculation");
-  d->useAmbient     = makeFloatEditorRow("Use ambient"    , 0.0f, 1.0f, true);
-  d->useDiffuse     = makeFloatEditorRow("Use diffuse"    , 0.0f, 1.0f, true);
-  d->useNdotL       = makeFloatEditorRow("Use N dot L"    , 0.0f, 1.0f, true);
-  d->useAttenuation = makeFloatEditorRow("Use attenuation", 0.0f, 1.0f, true);
-  d->useShadow      = makeFloatEditorRow("Use shadow"     , 0.0f, 1.0f, true);
-  d->useLightMask   = makeFloatEditorRow("Light mask"     , 0.0f, 1.0f, true);
-  d->useReflection  = makeFloatEditorRow("Use reflection" , 0.0f, 1.0f, true);
+  addFieldsSection("OpenGL Shading Calculation", false);
+  addFieldsSection("Ray Visibility", false);
 
-  addTitle("Ray Visibility");
-  d->rayVisibilityCamera        = makeBoolEditorRow("Camera"        );
-  d->rayVisibilityDiffuse       = makeBoolEditorRow("Diffuse"       );
-  d->rayVisibilityGlossy        = makeBoolEditorRow("Glossy"        );
-  d->rayVisibilityTransmission  = makeBoolEditorRow("Transmission"  );
-  d->rayVisibilityScatter       = makeBoolEditorRow("Volume scatter");
-  d->rayVisibilityShadow        = makeBoolEditorRow("Shadow"        );
-  d->rayVisibilityShadowCatcher = makeBoolEditorRow("Shadow catcher");
+  l->addStretch();
 
   {
     auto hLayout = new QHBoxLayout();
@@ -567,8 +823,20 @@ EditMaterialWidget::EditMaterialWidget(TextureSupported textureSupported,
       {
         tp_math_utils::Material material;
         material.loadState(tp_utils::jsonFromString(QGuiApplication::clipboard()->text().toStdString()));
-        setMaterial(material);
-        Q_EMIT materialEdited();
+        auto delta = diffMaterials(d->material, material);
+        if(d->materialCount>1)
+        {
+          // Pasting onto a set sets every value apart from the name.
+          d->addMixed(delta, material);
+          delta.nameChanged = false;
+          material.name = d->material.name;
+        }
+        d->coalescer.flush();
+
+        // Clear mixed first, otherwise loading blanks the pasted names in the mixed line edits.
+        d->clearMixed(delta);
+        d->loadMaterial(material);
+        d->queueEdit(delta, false);
       });
     }
   }
@@ -580,208 +848,63 @@ EditMaterialWidget::EditMaterialWidget(TextureSupported textureSupported,
 //##################################################################################################
 EditMaterialWidget::~EditMaterialWidget()
 {
+  d->coalescer.flush();
   delete d;
 }
 
 //##################################################################################################
 void EditMaterialWidget::setMaterial(const tp_math_utils::Material& material)
 {
-  blockSignals(true);
-  TP_CLEANUP([&]{blockSignals(false);});
-
-  d->material = material;
-  auto openGLMaterial = d->material.findOrAddOpenGL();
-  auto legacyMaterial = d->material.findOrAddLegacy();
-
-  d->nameEdit->setText(QString::fromStdString(material.name.toString()));
-
-  d->shaderType->setCurrentText(QString::fromStdString(tp_math_utils::shaderTypeToString(legacyMaterial->shaderType)));
-
-  d->updateColors();
-
-  d->alpha                .set(openGLMaterial->alpha                );
-  d->roughness            .set(openGLMaterial->roughness            );
-  d->metalness            .set(openGLMaterial->metalness            );
-  d->specular             .set(legacyMaterial->specular             );
-  d->transmission         .set(openGLMaterial->transmission         );
-  d->transmissionRoughness.set(openGLMaterial->transmissionRoughness);
-  d->heightScale          .set(legacyMaterial->heightScale          );
-  d->heightMidlevel       .set(legacyMaterial->heightMidlevel       );
-  d->ior                  .set(legacyMaterial->ior                  );
-  d->sheen                .set(legacyMaterial->sheen                );
-  d->sheenTint            .set(legacyMaterial->sheenTint            );
-  d->clearCoat            .set(legacyMaterial->clearCoat            );
-  d->clearCoatRoughness   .set(legacyMaterial->clearCoatRoughness   );
-  d->iridescentFactor     .set(legacyMaterial->iridescentFactor     );
-  d->iridescentOffset     .set(legacyMaterial->iridescentOffset     );
-  d->iridescentFrequency  .set(legacyMaterial->iridescentFrequency  );
-  d->normalStrength       .set(legacyMaterial->normalStrength       );
-
-  d->sssRadiusR->setValue(double(legacyMaterial->sssRadius.x));
-  d->sssRadiusG->setValue(double(legacyMaterial->sssRadius.y));
-  d->sssRadiusB->setValue(double(legacyMaterial->sssRadius.z));
-
-  d->sssMethod->setCurrentText(QString::fromStdString(tp_math_utils::sssMethodToString(legacyMaterial->sssMethod)));
-
-  d->albedoBrightness     .set(openGLMaterial->albedoBrightness     );
-  d->albedoContrast       .set(openGLMaterial->albedoContrast       );
-  d->albedoGamma          .set(openGLMaterial->albedoGamma          );
-  d->albedoHue            .set(openGLMaterial->albedoHue            );
-  d->albedoSaturation     .set(openGLMaterial->albedoSaturation     );
-  d->albedoValue          .set(openGLMaterial->albedoValue          );
-  d->albedoFactor         .set(openGLMaterial->albedoFactor         );
-
-  d->skewU                .set(material.uvTransformation.skewUV.x     );
-  d->skewV                .set(material.uvTransformation.skewUV.y     );
-
-  d->scaleU               .set(material.uvTransformation.scaleUV.x    );
-  d->scaleV               .set(material.uvTransformation.scaleUV.y    );
-
-  d->translateU           .set(material.uvTransformation.translateUV.x);
-  d->translateV           .set(material.uvTransformation.translateUV.y);
-
-  d->rotateUV             .set(material.uvTransformation.rotateUV     );
-
-  d->useAmbient           .set(openGLMaterial->useAmbient           );
-  d->useDiffuse           .set(openGLMaterial->useDiffuse           );
-  d->useNdotL             .set(openGLMaterial->useNdotL             );
-  d->useAttenuation       .set(openGLMaterial->useAttenuation       );
-  d->useShadow            .set(openGLMaterial->useShadow            );
-  d->useLightMask         .set(openGLMaterial->useLightMask         );
-  d->useReflection        .set(openGLMaterial->useReflection        );
-
-  d->rayVisibilityCamera       .set(legacyMaterial->rayVisibilityCamera       );
-  d->rayVisibilityDiffuse      .set(legacyMaterial->rayVisibilityDiffuse      );
-  d->rayVisibilityGlossy       .set(legacyMaterial->rayVisibilityGlossy       );
-  d->rayVisibilityTransmission .set(legacyMaterial->rayVisibilityTransmission );
-  d->rayVisibilityScatter      .set(legacyMaterial->rayVisibilityScatter      );
-  d->rayVisibilityShadow       .set(legacyMaterial->rayVisibilityShadow       );
-  d->rayVisibilityShadowCatcher.set(openGLMaterial->rayVisibilityShadowCatcher);
-
-  d->albedoScaleSlider    .set(openGLMaterial->albedoScale          );
-  d->sssSlider            .set(legacyMaterial->sssScale             );
-  d->emissionSlider       .set(legacyMaterial->emissionScale        );
-  d->velvetSlider         .set(legacyMaterial->velvetScale          );
-
-  openGLMaterial->viewTypedTextures([&](const auto& type, const auto& value, const auto&)
-  {
-    if(d->textureSupported == TextureSupported::Yes)
-      d->textureLineEdits[type]->setText(QString::fromStdString(value.toString()));
-  });
-
-  legacyMaterial->viewTypedTextures([&](const auto& type, const auto& value, const auto&)
-  {
-    if(d->textureSupported == TextureSupported::Yes)
-      d->textureLineEdits[type]->setText(QString::fromStdString(value.toString()));
-  });
-
-  d->blendFileLineEdit->setText("");
-  d->material.viewExternal("blend", [&](const tp_math_utils::ExternalMaterial& externalMaterial)
-  {
-    d->blendFileLineEdit->setText(QString::fromStdString(externalMaterial.subPath.toString()));
-  });
+  // Deliver edits made to the old material before it is replaced.
+  d->coalescer.flush();
+  d->resetBatch(1);
+  d->loadMaterial(material);
 }
 
 //##################################################################################################
 tp_math_utils::Material EditMaterialWidget::material() const
 {
-  auto openGLMaterial = d->material.findOrAddOpenGL();
-  auto legacyMaterial = d->material.findOrAddLegacy();
-
-  d->material.name = d->nameEdit->text().toStdString();
-
-  legacyMaterial->shaderType = tp_math_utils::shaderTypeFromString(d->shaderType->currentText().toStdString());
-
-  openGLMaterial->alpha                 = d->alpha                .get();
-  openGLMaterial->roughness             = d->roughness            .get();
-  openGLMaterial->metalness             = d->metalness            .get();
-  legacyMaterial->specular              = d->specular             .get();
-  openGLMaterial->transmission          = d->transmission         .get();
-  openGLMaterial->transmissionRoughness = d->transmissionRoughness.get();
-  legacyMaterial->heightScale           = d->heightScale          .get();
-  legacyMaterial->heightMidlevel        = d->heightMidlevel       .get();
-  legacyMaterial->ior                   = d->ior                  .get();
-  legacyMaterial->sheen                 = d->sheen                .get();
-  legacyMaterial->sheenTint             = d->sheenTint            .get();
-  legacyMaterial->clearCoat             = d->clearCoat            .get();
-  legacyMaterial->clearCoatRoughness    = d->clearCoatRoughness   .get();
-  legacyMaterial->iridescentFactor      = d->iridescentFactor     .get();
-  legacyMaterial->iridescentOffset      = d->iridescentOffset     .get();
-  legacyMaterial->iridescentFrequency   = d->iridescentFrequency  .get();
-  legacyMaterial->normalStrength        = d->normalStrength       .get();
-
-  legacyMaterial->sssRadius.x = d->sssRadiusR->value();
-  legacyMaterial->sssRadius.y = d->sssRadiusG->value();
-  legacyMaterial->sssRadius.z = d->sssRadiusB->value();
-
-  legacyMaterial->sssMethod = tp_math_utils::sssMethodFromString(d->sssMethod->currentText().toStdString());
-
-
-  openGLMaterial->albedoBrightness = d->albedoBrightness.get();
-  openGLMaterial->albedoContrast   = d->albedoContrast  .get();
-  openGLMaterial->albedoGamma      = d->albedoGamma     .get();
-  openGLMaterial->albedoHue        = d->albedoHue       .get();
-  openGLMaterial->albedoSaturation = d->albedoSaturation.get();
-  openGLMaterial->albedoValue      = d->albedoValue     .get();
-  openGLMaterial->albedoFactor     = d->albedoFactor    .get();
-
-  d->material.uvTransformation.skewUV.x      = d->skewU     .get();
-  d->material.uvTransformation.skewUV.y      = d->skewV     .get();
-
-  d->material.uvTransformation.scaleUV.x     = d->scaleU    .get();
-  d->material.uvTransformation.scaleUV.y     = d->scaleV    .get();
-
-  d->material.uvTransformation.translateUV.x = d->translateU.get();
-  d->material.uvTransformation.translateUV.y = d->translateV.get();
-
-  d->material.uvTransformation.rotateUV      = d->rotateUV  .get();
-
-  openGLMaterial->useAmbient            = d->useAmbient       .get();
-  openGLMaterial->useDiffuse            = d->useDiffuse       .get();
-  openGLMaterial->useNdotL              = d->useNdotL         .get();
-  openGLMaterial->useAttenuation        = d->useAttenuation   .get();
-  openGLMaterial->useShadow             = d->useShadow        .get();
-  openGLMaterial->useLightMask          = d->useLightMask     .get();
-  openGLMaterial->useReflection         = d->useReflection    .get();
-
-  legacyMaterial->rayVisibilityCamera        = d->rayVisibilityCamera         .get();
-  legacyMaterial->rayVisibilityDiffuse       = d->rayVisibilityDiffuse        .get();
-  legacyMaterial->rayVisibilityGlossy        = d->rayVisibilityGlossy         .get();
-  legacyMaterial->rayVisibilityTransmission  = d->rayVisibilityTransmission   .get();
-  legacyMaterial->rayVisibilityScatter       = d->rayVisibilityScatter        .get();
-  legacyMaterial->rayVisibilityShadow        = d->rayVisibilityShadow         .get();
-  openGLMaterial->rayVisibilityShadowCatcher = d->rayVisibilityShadowCatcher  .get();
-
-  openGLMaterial->albedoScale           = d->albedoScaleSlider.get();
-  legacyMaterial->sssScale              = d->sssSlider        .get();
-  legacyMaterial->emissionScale         = d->emissionSlider   .get();
-  legacyMaterial->velvetScale           = d->velvetSlider     .get();
-
-  openGLMaterial->updateTypedTextures([&](const auto& type, auto& value, const auto&)
-  {
-    if(d->textureSupported == TextureSupported::Yes)
-      value = d->textureLineEdits[type]->text().toStdString();
-  });
+  if(!d->mixedName)
+    d->material.name = d->nameEdit->text().toStdString();
+  return d->material;
+}
 
-  legacyMaterial->updateTypedTextures([&](const auto& type, auto& value, const auto&)
-  {
-    if(d->textureSupported == TextureSupported::Yes)
-      value = d->textureLineEdits[type]->text().toStdString();
-  });
+//##################################################################################################
+void EditMaterialWidget::setMaterials(const std::vector<tp_math_utils::Material>& materials)
+{
+  d->coalescer.flush();
 
+  if(materials.empty())
   {
-    tp_utils::StringID subPath = d->blendFileLineEdit->text().toStdString();
-    if(subPath.isValid())
-    {
-      auto externalMaterial = d->material.findOrAddExternal("blend");
-      externalMaterial->subPath = d->blendFileLineEdit->text().toStdString();
-    }
-    else
-    {
-      d->material.removeExternal("blend");
-    }
+    setMaterial(tp_math_utils::Material());
+    return;
   }
-  return d->material;
+
+  d->resetBatch(materials.size());
+  d->findMixed(materials);
+  d->loadMaterial(materials.front());
+}
+
+//##################################################################################################
+size_t EditMaterialWidget::materialCount() const
+{
+  return d->materialCount;
+}
+
+//##################################################################################################
+const MaterialDelta& EditMaterialWidget::edits() const
+{
+  return d->edits;
+}
+
+//##################################################################################################
+void EditMaterialWidget::applyEdits(std::vector<tp_math_utils::Material>& materials) const
+{
+  if(d->edits.empty())
+    return;
+
+  for(auto& material : materials)
+    d->edits.apply(material);
 }
 
 //##################################################################################################
@@ -840,6 +963,43 @@ bool EditMaterialWidget::editMaterialDialog(QWidget* parent,
   return false;
 }
 
+//##################################################################################################
+bool EditMaterialWidget::editMaterialsDialog(QWidget* parent,
+                                             std::vector<tp_math_utils::Material>& materials,
+                                             TextureSupported textureSupported,
+                                             const TPGetExistingTexturesCallback& getExistingTextures,
+                                             const TPLoadTextureCallback& loadTexture,
+                                             const TPLoadMaterialBlendCallback& loadMaterialBlend)
+{
+  QPointer<QDialog> dialog = new QDialog(parent);
+  TP_CLEANUP([&]{delete dialog;});
+
+  dialog->setWindowTitle(QString("Edit %1 Materials").arg(materials.size()));
+
+  auto l = new QVBoxLayout(dialog);
+
+  auto editMaterialWidget = new EditMaterialWidget(textureSupported);
+  l->addWidget(editMaterialWidget);
+  editMaterialWidget->setMaterials(materials);
+  editMaterialWidget->setGetExistingTextures(getExistingTextures);
+  editMaterialWidget->setLoadTexture(loadTexture);
+  editMaterialWidget->setMaterialBlend(loadMaterialBlend);
+
+  auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+  l->addWidget(buttons);
+
+  connect(buttons, &QDialogButtonBox::accepted, dialog, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, dialog, &QDialog::reject);
+
+  if(dialog->exec() == QDialog::Accepted)
+  {
+    editMaterialWidget->applyEdits(materials);
+    return true;
+  }
+
+  return false;
+}
+
 //##################################################################################################
 bool EditMaterialWidget::eventFilter(QObject* watched, QEvent* event)
 {
@@ -865,15 +1025,20 @@ bool EditMaterialWidget::eventFilter(QObject* watched, QEvent* event)
       auto text = d->loadTexture(path, error);
       if(text.isValid())
       {
+        // Drops onto anything other than a texture edit change nothing.
+        MaterialDelta delta;
         for(const auto& i: d->textureLineEdits)
         {
           if(watched == i.second)
           {
             i.second->setText(QString::fromStdString(text.toString()));
+            delta.setTexture(i.first, text.toString());
             break;
           }
         }
-        Q_EMIT materialEdited();
+
+        if(!delta.empty())
+          d->applyEdit(delta);
       }
 
       if(!error.empty())
@@ -1,4 +1,5 @@
 #include "tp_qt_maps_widget/EditSwapParametersWidget.h"
+#include "tp_qt_maps_widget/EditCoalescer.h"
 
 #include "tp_qt_widgets/SpinSlider.h"
 
@@ -130,6 +131,15 @@ struct EditVec3ComponentWidget::Private
   tp_qt_widgets::SpinSlider* x{nullptr};
   tp_qt_widgets::SpinSlider* y{nullptr};
   tp_qt_widgets::SpinSlider* z{nullptr};
+
+  EditCoalescer coalescer;
+
+  //################################################################################################
+  Private(EditVec3ComponentWidget* q):
+    coalescer([q]{q->edited();})
+  {
+
+  }
 };
 
 //##################################################################################################
@@ -140,7 +150,7 @@ EditVec3ComponentWidget::EditVec3ComponentWidget(VectorComponents vectorComponen
                                                  const QString& title,
                                                  QWidget* parent):
   QWidget(parent),
-  d(new Private())
+  d(new Private(this))
 {
   auto addExpandIcon = [&](QBoxLayout* layout)
   {
@@ -219,12 +229,15 @@ EditVec3ComponentWidget::EditVec3ComponentWidget(VectorComponents vectorComponen
     d->x->setValue(d->shared->value());
     d->y->setValue(d->shared->value());
     d->z->setValue(d->shared->value());
-    edited();
+    d->coalescer.edit();
   });
 
-  d->x->edited.addCallback([this](float){edited();});
-  d->y->edited.addCallback([this](float){edited();});
-  d->z->edited.addCallback([this](float){edited();});
+  d->x->edited.addCallback([this](float){d->coalescer.edit();});
+  d->y->edited.addCallback([this](float){d->coalescer.edit();});
+  d->z->edited.addCallback([this](float){d->coalescer.edit();});
+
+  for(auto slider : {d->shared, d->x, d->y, d->z})
+    d->coalescer.flushOnSliderRelease(slider);
 
   if(vectorComponents == VectorComponents::XRotYRot)
     d->z->setEnabled(false);
@@ -242,12 +255,14 @@ EditVec3ComponentWidget::EditVec3ComponentWidget(VectorComponents vectorComponen
 //##################################################################################################
 EditVec3ComponentWidget::~EditVec3ComponentWidget()
 {
+  d->coalescer.flush();
   delete d;
 }
 
 //##################################################################################################
 void EditVec3ComponentWidget::setVec3(const glm::vec3& vec3)
 {
+  d->coalescer.flush();
   d->shared->setValue(vec3.x);
   d->x->setValue(vec3.x);
   d->y->setValue(vec3.y);
@@ -379,9 +394,12 @@ struct EditFloatSwapParametersWidget::Private
   tp_qt_widgets::SpinSlider* scale{nullptr};
   tp_qt_widgets::SpinSlider* bias {nullptr};
 
+  EditCoalescer coalescer;
+
   //################################################################################################
-  Private(HelperButtons helperButtons_):
-    helperButtons(helperButtons_)
+  Private(EditFloatSwapParametersWidget* q, HelperButtons helperButtons_):
+    helperButtons(helperButtons_),
+    coalescer([q]{q->edited();})
   {
 
   }
@@ -395,7 +413,7 @@ EditFloatSwapParametersWidget::EditFloatSwapParametersWidget(HelperButtons helpe
                                                              float biasMax,
                                                              QWidget* parent):
   QWidget(parent),
-  d(new Private(helperButtons))
+  d(new Private(this, helperButtons))
 {
   auto l = new QVBoxLayout(this);
   l->setContentsMargins(0, 0, 0, 0);
@@ -415,7 +433,8 @@ EditFloatSwapParametersWidget::EditFloatSwapParametersWidget(HelperButtons helpe
     spinSlider->setSingleStep(0.1f);
     ll->addWidget(spinSlider);
 
-    spinSlider->edited.addCallback([&](float){edited();});
+    spinSlider->edited.addCallback([&](float){d->coalescer.edit();});
+    d->coalescer.flushOnSliderRelease(spinSlider);
 
     return spinSlider;
   };
@@ -462,12 +481,14 @@ EditFloatSwapParametersWidget::EditFloatSwapParametersWidget(HelperButtons helpe
 //##################################################################################################
 EditFloatSwapParametersWidget::~EditFloatSwapParametersWidget()
 {
+  d->coalescer.flush();
   delete d;
 }
 
 //##################################################################################################
 void EditFloatSwapParametersWidget::setFloatSwapParameters(const tp_math_utils::FloatSwapParameters& floatSwapParameters)
 {
+  d->coalescer.flush();
   d->use  ->setValue(floatSwapParameters.use  );
   d->scale->setValue(floatSwapParameters.scale);
   d->bias ->setValue(floatSwapParameters.bias );
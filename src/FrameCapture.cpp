@@ -0,0 +1,352 @@
+#include "tp_qt_maps_widget/FrameCapture.h"
+
+#include "tp_maps/subsystems/open_gl/OpenGL.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include <QImage>
+#include <QDir>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+struct FrameCapture::Private
+{
+  //! Frames are mapped this many frames after they are read, by which time the GPU is done.
+  static constexpr size_t slotCount{3};
+
+  //! Frames are dropped rather than queued once this many are waiting per encoder thread.
+  static constexpr int maxQueuedPerThread{4};
+
+  //! How long finish() waits on each frame still being read back, in nanoseconds.
+  static constexpr GLuint64 finishTimeout{1000000000};
+
+  struct Slot
+  {
+    GLuint pbo{0};
+    size_t size{0};
+    int width{0};
+    int height{0};
+    size_t frame{0};
+    GLsync fence{nullptr};
+    bool pending{false};
+  };
+
+  std::string directory;
+  std::string format{"png"};
+  bool capturing{false};
+
+  std::array<Slot, slotCount> slots;
+  size_t next{0};
+  size_t frameNumber{0};
+
+  GLuint resolveFBO{0};
+  GLuint resolveColor{0};
+  int resolveWidth{0};
+  int resolveHeight{0};
+
+  QThreadPool encoders;
+  std::atomic<int> queuedEncodes{0};
+
+  FrameCaptureStats stats;
+
+  //################################################################################################
+  Private()
+  {
+    encoders.setMaxThreadCount(2);
+  }
+
+  //################################################################################################
+  ~Private()
+  {
+    encoders.waitForDone();
+  }
+
+  //################################################################################################
+  void prepareResolveFBO(int width, int height)
+  {
+    if(resolveFBO && resolveWidth == width && resolveHeight == height)
+      return;
+
+    if(!resolveFBO)
+    {
+      glGenFramebuffers(1, &resolveFBO);
+      glGenRenderbuffers(1, &resolveColor);
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, resolveColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveColor);
+
+    resolveWidth = width;
+    resolveHeight = height;
+  }
+
+  //################################################################################################
+  //! Map slots whose fence has signalled, oldest first, and pass their pixels to the encoders.
+  /*!
+  With a timeout each pending slot is waited on, and dropped if it is still not ready, so that
+  nothing is left in flight.
+  */
+  void collect(GLuint64 timeout=0)
+  {
+    for(size_t i=0; i<slotCount; i++)
+    {
+      auto& slot = slots[(next+i) % slotCount];
+      if(!slot.pending)
+        continue;
+
+      GLenum result = glClientWaitSync(slot.fence, timeout?GL_SYNC_FLUSH_COMMANDS_BIT:0, timeout);
+      if(result == GL_TIMEOUT_EXPIRED && !timeout)
+        break;
+
+      glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+      slot.pending = false;
+
+      if(result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED || queuedEncodes >= encoders.maxThreadCount()*maxQueuedPerThread)
+      {
+        stats.dropped++;
+        continue;
+      }
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+      auto pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(slot.size), GL_MAP_READ_BIT);
+      if(!pixels)
+      {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        stats.dropped++;
+        continue;
+      }
+
+      QImage image(slot.width, slot.height, QImage::Format_RGBA8888);
+      std::memcpy(image.bits(), pixels, slot.size);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+      encode(image, slot.frame);
+    }
+  }
+
+  //################################################################################################
+  void encode(const QImage& image, size_t frame)
+  {
+    stats.written++;
+    queuedEncodes++;
+
+    auto path = QString::fromStdString(framePath(frame, format));
+    auto f = format;
+    encoders.start([this, image, path, f]
+    {
+      // GL rows are bottom up.
+      if(!image.mirrored().save(path, f.c_str()))
+        tpWarning() << "Failed to save captured frame: " << path.toStdString();
+      queuedEncodes--;
+    });
+  }
+
+  //################################################################################################
+  std::string framePath(size_t frame, const std::string& extension) const
+  {
+    auto name = QString("%1.%2").arg(frame, 6, 10, QChar('0')).arg(QString::fromStdString(extension));
+    return QDir(QString::fromStdString(directory)).filePath(name).toStdString();
+  }
+
+  //################################################################################################
+  void releaseSlots()
+  {
+    for(auto& slot : slots)
+    {
+      if(slot.fence)
+        glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+      slot.pending = false;
+    }
+  }
+};
+
+//##################################################################################################
+FrameCapture::FrameCapture():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+FrameCapture::~FrameCapture()
+{
+  delete d;
+}
+
+//##################################################################################################
+void FrameCapture::start(const std::string& directory)
+{
+  d->directory = directory;
+  d->capturing = true;
+  d->frameNumber = 0;
+  d->stats = FrameCaptureStats();
+  QDir().mkpath(QString::fromStdString(directory));
+}
+
+//##################################################################################################
+void FrameCapture::stop()
+{
+  d->capturing = false;
+}
+
+//##################################################################################################
+bool FrameCapture::isCapturing() const
+{
+  return d->capturing;
+}
+
+//##################################################################################################
+const std::string& FrameCapture::directory() const
+{
+  return d->directory;
+}
+
+//##################################################################################################
+void FrameCapture::setFormat(const std::string& format)
+{
+  d->format = format;
+}
+
+//##################################################################################################
+void FrameCapture::setEncoderThreads(int encoderThreads)
+{
+  d->encoders.setMaxThreadCount(std::max(1, encoderThreads));
+}
+
+//##################################################################################################
+void FrameCapture::capture(uint32_t sourceFBO, int width, int height)
+{
+  if(!d->capturing)
+  {
+    // Finish writing anything still in flight from a previous capture.
+    d->collect();
+    return;
+  }
+
+  if(width<1 || height<1)
+    return;
+
+  d->collect();
+
+  auto& slot = d->slots[d->next];
+  if(slot.pending)
+  {
+    d->stats.dropped++;
+    d->frameNumber++;
+    return;
+  }
+
+  d->next = (d->next+1) % Private::slotCount;
+
+  // Resolve first, the source is often multisampled and glReadPixels can't read those.
+  d->prepareResolveFBO(width, height);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, sourceFBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, d->resolveFBO);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, d->resolveFBO);
+
+  if(!slot.pbo)
+    glGenBuffers(1, &slot.pbo);
+
+  size_t size = size_t(width)*size_t(height)*4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+  if(slot.size != size)
+  {
+    glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(size), nullptr, GL_STREAM_READ);
+    slot.size = size;
+  }
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.width = width;
+  slot.height = height;
+  slot.frame = d->frameNumber++;
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.pending = true;
+
+  d->stats.captured++;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, sourceFBO);
+}
+
+//##################################################################################################
+size_t FrameCapture::frameNumber() const
+{
+  return d->frameNumber;
+}
+
+//##################################################################################################
+std::string FrameCapture::framePath(size_t frame, const std::string& extension) const
+{
+  return d->framePath(frame, extension);
+}
+
+//##################################################################################################
+FrameCaptureStats FrameCapture::stats() const
+{
+  return d->stats;
+}
+
+//##################################################################################################
+void FrameCapture::waitForEncoders()
+{
+  d->encoders.waitForDone();
+}
+
+//##################################################################################################
+void FrameCapture::finish()
+{
+  d->capturing = false;
+  d->collect(Private::finishTimeout);
+  d->encoders.waitForDone();
+}
+
+//##################################################################################################
+void FrameCapture::deleteBuffers()
+{
+  // Frames still being read back are written rather than dropped with their buffers.
+  d->collect(Private::finishTimeout);
+  d->releaseSlots();
+
+  for(auto& slot : d->slots)
+    if(slot.pbo)
+      glDeleteBuffers(1, &slot.pbo);
+
+  if(d->resolveFBO)
+  {
+    glDeleteFramebuffers(1, &d->resolveFBO);
+    glDeleteRenderbuffers(1, &d->resolveColor);
+  }
+
+  invalidateBuffers();
+}
+
+//##################################################################################################
+void FrameCapture::invalidateBuffers()
+{
+  d->slots = {};
+  d->next = 0;
+  d->resolveFBO = 0;
+  d->resolveColor = 0;
+  d->resolveWidth = 0;
+  d->resolveHeight = 0;
+}
+
+}
@@ -0,0 +1,469 @@
+#include "tp_qt_maps_widget/FrameTimings.h"
+
+#include "tp_maps/subsystems/open_gl/OpenGL.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+
+namespace tp_qt_maps_widget
+{
+
+namespace
+{
+//##################################################################################################
+template<typename T>
+FrameTimingSummary summarize(const std::vector<FrameTiming>& timings, T get)
+{
+  std::vector<double> values;
+  values.reserve(timings.size());
+  for(const auto& timing : timings)
+    if(double v=get(timing); v>=0.0)
+      values.push_back(v);
+
+  FrameTimingSummary summary;
+  summary.count = values.size();
+  if(values.empty())
+    return summary;
+
+  double total=0.0;
+  summary.min = values.front();
+  for(auto v : values)
+  {
+    total += v;
+    summary.min = std::min(summary.min, v);
+  }
+  summary.avg = total / double(values.size());
+
+  auto percentile = [&](double p)
+  {
+    size_t n = size_t(p*double(values.size()-1) + 0.5);
+    std::nth_element(values.begin(), values.begin()+ptrdiff_t(n), values.end());
+    return values.at(n);
+  };
+
+  summary.p95 = percentile(0.95);
+  summary.p99 = percentile(0.99);
+
+  return summary;
+}
+}
+
+//##################################################################################################
+struct FrameTimings::Private
+{
+  std::vector<FrameTiming> ring;
+  size_t capacity;
+  size_t next{0};
+  size_t count{0};
+
+  //################################################################################################
+  Private(size_t capacity_):
+    capacity(std::max(size_t(1), capacity_))
+  {
+    ring.resize(capacity);
+  }
+
+  //################################################################################################
+  //! Index in the ring of the i'th oldest of the last n frames.
+  size_t index(size_t n, size_t i) const
+  {
+    return (next + capacity - n + i) % capacity;
+  }
+};
+
+//##################################################################################################
+FrameTimings::FrameTimings(size_t capacity):
+  d(new Private(capacity))
+{
+
+}
+
+//##################################################################################################
+FrameTimings::~FrameTimings()
+{
+  delete d;
+}
+
+//##################################################################################################
+void FrameTimings::setCapacity(size_t capacity)
+{
+  auto timings = this->timings(capacity);
+  delete d;
+  d = new Private(capacity);
+  for(const auto& timing : timings)
+    addFrame(timing);
+}
+
+//##################################################################################################
+size_t FrameTimings::capacity() const
+{
+  return d->capacity;
+}
+
+//##################################################################################################
+void FrameTimings::clear()
+{
+  d->next = 0;
+  d->count = 0;
+}
+
+//##################################################################################################
+void FrameTimings::addFrame(const FrameTiming& frameTiming)
+{
+  d->ring[d->next] = frameTiming;
+  d->next = (d->next+1) % d->capacity;
+  d->count = std::min(d->count+1, d->capacity);
+}
+
+//##################################################################################################
+std::vector<FrameTiming> FrameTimings::timings(size_t window) const
+{
+  size_t n = std::min(window, d->count);
+  std::vector<FrameTiming> timings;
+  timings.reserve(n);
+  for(size_t i=0; i<n; i++)
+    timings.push_back(d->ring[d->index(n, i)]);
+  return timings;
+}
+
+//##################################################################################################
+FrameTimingStats FrameTimings::stats(size_t window) const
+{
+  auto timings = this->timings(window);
+
+  FrameTimingStats stats;
+  stats.cpuAnimate = summarize(timings, [](const FrameTiming& t){return t.cpuAnimateMS;});
+  stats.cpuPaint   = summarize(timings, [](const FrameTiming& t){return t.cpuPaintMS;  });
+  stats.gpuPaint   = summarize(timings, [](const FrameTiming& t){return t.gpuPaintMS;  });
+  stats.present    = summarize(timings, [](const FrameTiming& t){return t.presentMS;   });
+  stats.inputLatency = summarize(timings, [](const FrameTiming& t){return t.inputLatencyMS;});
+  return stats;
+}
+
+//##################################################################################################
+struct GPUFrameTimer::Private
+{
+  //! Enough slots that results are normally available two or three frames later.
+  static constexpr size_t slotCount{4};
+
+  struct Slot
+  {
+    GLuint query{0};
+    size_t frame{0};
+    bool pending{false};
+  };
+
+  std::array<Slot, slotCount> slots;
+  size_t next{0};
+  Slot* active{nullptr};
+  bool initialized{false};
+};
+
+//##################################################################################################
+GPUFrameTimer::GPUFrameTimer():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+GPUFrameTimer::~GPUFrameTimer()
+{
+  delete d;
+}
+
+//##################################################################################################
+bool GPUFrameTimer::supported()
+{
+#ifdef GL_TIME_ELAPSED
+  return true;
+#else
+  return false;
+#endif
+}
+
+//##################################################################################################
+bool GPUFrameTimer::begin([[maybe_unused]] size_t frame)
+{
+#ifdef GL_TIME_ELAPSED
+  if(!d->initialized)
+  {
+    for(auto& slot : d->slots)
+      glGenQueries(1, &slot.query);
+    d->initialized = true;
+  }
+
+  auto& slot = d->slots[d->next];
+  if(slot.pending)
+    return false;
+
+  d->next = (d->next+1) % Private::slotCount;
+
+  slot.frame = frame;
+  slot.pending = true;
+  d->active = &slot;
+  glBeginQuery(GL_TIME_ELAPSED, slot.query);
+  return true;
+#else
+  return false;
+#endif
+}
+
+//##################################################################################################
+void GPUFrameTimer::end()
+{
+#ifdef GL_TIME_ELAPSED
+  if(d->active)
+  {
+    glEndQuery(GL_TIME_ELAPSED);
+    d->active = nullptr;
+  }
+#endif
+}
+
+//##################################################################################################
+void GPUFrameTimer::collect([[maybe_unused]] const std::function<void(size_t frame, double gpuMS)>& resolved)
+{
+#ifdef GL_TIME_ELAPSED
+  if(!d->initialized)
+    return;
+
+  // Walk the slots oldest first, stopping at the first one that is not ready.
+  for(size_t i=0; i<Private::slotCount; i++)
+  {
+    auto& slot = d->slots[(d->next+i) % Private::slotCount];
+    if(!slot.pending || &slot == d->active)
+      continue;
+
+    GLuint available=0;
+    glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+      break;
+
+    GLuint64 elapsed=0;
+    glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &elapsed);
+    slot.pending = false;
+    resolved(slot.frame, double(elapsed) / 1000000.0);
+  }
+#endif
+}
+
+//##################################################################################################
+void GPUFrameTimer::deleteQueries()
+{
+#ifdef GL_TIME_ELAPSED
+  if(d->initialized)
+    for(auto& slot : d->slots)
+      glDeleteQueries(1, &slot.query);
+#endif
+  invalidateQueries();
+}
+
+//##################################################################################################
+void GPUFrameTimer::invalidateQueries()
+{
+  d->slots = {};
+  d->next = 0;
+  d->active = nullptr;
+  d->initialized = false;
+}
+
+//##################################################################################################
+struct FrameTimingRecorder::Private
+{
+  using Clock = std::chrono::steady_clock;
+
+  //! Frames waiting for more than this many newer frames are given up on.
+  static constexpr size_t maxPending{8};
+
+  struct Pending
+  {
+    FrameTiming timing;
+    Clock::time_point paintEnd;
+    Clock::time_point input;
+    bool hasInput{false};
+    bool awaitingGPU{false};
+    bool awaitingPresent{true};
+  };
+
+  std::function<void(const FrameTiming&)> frameCompleted;
+  GPUFrameTimer gpuFrameTimer;
+  std::deque<Pending> pending;
+
+  size_t frameCounter{0};
+  double pendingAnimateMS{0.0};
+
+  Clock::time_point firstInput;
+  bool hasInput{false};
+
+  Clock::time_point paintStart;
+  Clock::time_point frameInput;
+  bool frameHasInput{false};
+  bool awaitingGPU{false};
+
+  //################################################################################################
+  static double elapsedMS(const Clock::time_point& from, const Clock::time_point& to)
+  {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+  }
+
+  //################################################################################################
+  void collectGPU()
+  {
+    gpuFrameTimer.collect([&](size_t frame, double gpuMS)
+    {
+      for(auto& p : pending)
+      {
+        if(p.timing.frame == frame)
+        {
+          p.timing.gpuPaintMS = gpuMS;
+          p.awaitingGPU = false;
+          break;
+        }
+      }
+    });
+  }
+
+  //################################################################################################
+  //! Pass on completed timings in frame order, stopping at the first one that is still waiting.
+  void emitCompleted()
+  {
+    while(pending.size()>maxPending)
+    {
+      pending.front().awaitingGPU = false;
+      pending.front().awaitingPresent = false;
+      popFront();
+    }
+
+    while(!pending.empty() && !pending.front().awaitingGPU && !pending.front().awaitingPresent)
+      popFront();
+  }
+
+  //################################################################################################
+  void popFront()
+  {
+    auto timing = pending.front().timing;
+    pending.pop_front();
+    if(frameCompleted)
+      frameCompleted(timing);
+  }
+};
+
+//##################################################################################################
+FrameTimingRecorder::FrameTimingRecorder():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+FrameTimingRecorder::~FrameTimingRecorder()
+{
+  delete d;
+}
+
+//##################################################################################################
+void FrameTimingRecorder::setFrameCompletedCallback(const std::function<void(const FrameTiming&)>& frameCompleted)
+{
+  d->frameCompleted = frameCompleted;
+}
+
+//##################################################################################################
+void FrameTimingRecorder::addAnimateMS(double animateMS)
+{
+  d->pendingAnimateMS += animateMS;
+}
+
+//##################################################################################################
+void FrameTimingRecorder::inputReceived()
+{
+  if(!d->hasInput)
+  {
+    d->firstInput = Private::Clock::now();
+    d->hasInput = true;
+  }
+}
+
+//##################################################################################################
+void FrameTimingRecorder::beginFrame()
+{
+  d->paintStart = Private::Clock::now();
+
+  d->frameInput = d->firstInput;
+  d->frameHasInput = d->hasInput;
+  d->hasInput = false;
+
+  d->collectGPU();
+  d->emitCompleted();
+  d->awaitingGPU = d->gpuFrameTimer.begin(d->frameCounter);
+}
+
+//##################################################################################################
+void FrameTimingRecorder::endFrame(float renderScale)
+{
+  d->gpuFrameTimer.end();
+
+  Private::Pending p;
+  p.paintEnd = Private::Clock::now();
+  p.input = d->frameInput;
+  p.hasInput = d->frameHasInput;
+  p.awaitingGPU = d->awaitingGPU;
+  p.timing.frame = d->frameCounter++;
+  p.timing.cpuAnimateMS = d->pendingAnimateMS;
+  p.timing.cpuPaintMS = Private::elapsedMS(d->paintStart, p.paintEnd);
+  p.timing.renderScale = renderScale;
+  d->pendingAnimateMS = 0.0;
+
+  d->pending.push_back(p);
+  d->emitCompleted();
+}
+
+//##################################################################################################
+void FrameTimingRecorder::framePresented()
+{
+  auto now = Private::Clock::now();
+  for(auto& p : d->pending)
+  {
+    if(!p.awaitingPresent)
+      continue;
+
+    p.awaitingPresent = false;
+    p.timing.presentMS = Private::elapsedMS(p.paintEnd, now);
+    if(p.hasInput)
+      p.timing.inputLatencyMS = Private::elapsedMS(p.input, now);
+  }
+
+  d->emitCompleted();
+}
+
+//##################################################################################################
+void FrameTimingRecorder::abandonPending()
+{
+  for(auto& p : d->pending)
+  {
+    p.awaitingGPU = false;
+    p.awaitingPresent = false;
+  }
+
+  d->emitCompleted();
+  d->pendingAnimateMS = 0.0;
+  d->hasInput = false;
+}
+
+//##################################################################################################
+void FrameTimingRecorder::deleteQueries()
+{
+  d->gpuFrameTimer.deleteQueries();
+  abandonPending();
+}
+
+//##################################################################################################
+void FrameTimingRecorder::invalidateQueries()
+{
+  d->gpuFrameTimer.invalidateQueries();
+  abandonPending();
+}
+
+}
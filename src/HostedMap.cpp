@@ -0,0 +1,62 @@
+#include "tp_qt_maps_widget/HostedMap.h"
+
+#include "tp_qt_maps/Globals.h"
+
+#include "tp_utils/DebugUtils.h"
+#include "tp_utils/StackTrace.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+HostedMap::HostedMap():
+  tp_maps::Map(false)
+{
+  setShaderProfile(tp_qt_maps::getShaderProfile());
+}
+
+//##################################################################################################
+HostedMap::~HostedMap()
+{
+  preDelete();
+}
+
+//##################################################################################################
+void HostedMap::makeCurrent()
+{
+  if(inPaint() == nullptr)
+  {
+    if(makeCurrentCallback)
+      makeCurrentCallback();
+  }
+  else if(inPaint() != this)
+  {
+    tpWarning() << "Nested makeCurrent() call for a different context.";
+    tp_utils::printStackTrace();
+  }
+}
+
+//##################################################################################################
+void HostedMap::update(const tp_maps::RenderFromStage& renderFromStage, const std::vector<tp_utils::StringID>& subviews)
+{
+  tp_maps::Map::update(renderFromStage, subviews);
+
+  updateRequested = true;
+
+  if(inPaint() || suppressHostUpdate)
+    return;
+
+  if(repaintCallback && tpContains(subviews, tp_maps::defaultSID()))
+    repaintCallback();
+
+  if(updateCallback)
+    updateCallback();
+}
+
+//##################################################################################################
+void HostedMap::callAsync(const std::function<void()>& callback)
+{
+  callAsyncQueue.post(callback);
+}
+
+}
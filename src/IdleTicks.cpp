@@ -0,0 +1,25 @@
+#include "tp_qt_maps_widget/IdleTicks.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+void IdleTicks::reset()
+{
+  idleTicks = 0;
+}
+
+//##################################################################################################
+bool IdleTicks::tick(bool updateRequested)
+{
+  if(updateRequested)
+  {
+    idleTicks = 0;
+    return false;
+  }
+
+  idleTicks++;
+  return stopWhenIdle && idleTicks>=maxIdleTicks;
+}
+
+}
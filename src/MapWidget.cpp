@@ -1,18 +1,15 @@
 #include "tp_qt_maps_widget/MapWidget.h"
 #include "tp_qt_maps_widget/ConnectContext.h"
+#include "tp_qt_maps_widget/HostedMap.h"
+#include "tp_qt_maps_widget/ConvertEvents.h"
+#include "tp_qt_maps_widget/IdleTicks.h"
 
-#include "tp_qt_maps/Globals.h"
-
-#include "tp_qt_utils/CrossThreadCallback.h"
-
-#include "tp_maps/MouseEvent.h"
-#include "tp_maps/KeyEvent.h"
 #include "tp_maps/DragDropEvent.h"
+#include "tp_maps/subsystems/open_gl/OpenGL.h"
 
 #include "tp_utils/DebugUtils.h"
 #include "tp_utils/TimeUtils.h"
 #include "tp_utils/JSONUtils.h"
-#include "tp_utils/StackTrace.h"
 
 #ifdef TP_DEBUG_RENDER_PASSES
 #include "tp_utils/FileUtils.h"
@@ -20,172 +17,435 @@
 
 #include <QMouseEvent>
 #include <QWheelEvent>
+#include <QKeyEvent>
 #include <QDrag>
 #include <QDragEnterEvent>
 #include <QDragLeaveEvent>
 #include <QMimeData>
+#include <QOpenGLFramebufferObject>
 #include <QTimer>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 
 namespace tp_qt_maps_widget
 {
 namespace
 {
+using Clock_lt = std::chrono::steady_clock;
 
 //##################################################################################################
-tp_maps::KeyboardModifier convertKeyboardModifiers(Qt::KeyboardModifiers modifiers)
+double elapsedMS(const Clock_lt::time_point& from)
 {
-  tp_maps::KeyboardModifier m{tp_maps::KeyboardModifier::None};
-  if(modifiers & Qt::ShiftModifier  ) m = m | tp_maps::KeyboardModifier::Shift;
-  if(modifiers & Qt::ControlModifier) m = m | tp_maps::KeyboardModifier::Control;
-  if(modifiers & Qt::AltModifier    ) m = m | tp_maps::KeyboardModifier::Alt;
-  return m;
+  return std::chrono::duration<double, std::milli>(Clock_lt::now() - from).count();
+}
 }
 
 //##################################################################################################
-int32_t toScancode(int key)
+struct MapWidget::Private
 {
-  switch(key)
+  TP_REF_COUNT_OBJECTS("tp_qt_maps_widget::MapWidget::Private");
+  TP_NONCOPYABLE(Private);
+
+  Q* q;
+  HostedMap* map;
+
+  int animationTimerID{-1};
+  int64_t animationInterval{0};
+  FramePacing framePacing{FramePacing::FixedRate};
+  IdleTicks idleTicks;
+  bool ticking{false};
+
+  QMetaObject::Connection aboutToBeDestroyedConnection;
+
+  QString dragDropMimeType;
+
+  //################################################################################################
+  struct DragDropCache
   {
-  case Qt::Key_PageUp:   return TP_PAGE_UP_KEY;
-  case Qt::Key_PageDown: return TP_PAGE_DOWN_KEY;
-  case Qt::Key_Up:       return TP_UP_KEY;
-  case Qt::Key_Down:     return TP_DOWN_KEY;
-  case Qt::Key_Left:     return TP_LEFT_KEY;
-  case Qt::Key_Right:    return TP_RIGHT_KEY;
-  case Qt::Key_Space:    return TP_SPACE_KEY;
-  case Qt::Key_Shift:    return TP_L_SHIFT_KEY;
-  case Qt::Key_Control:  return TP_L_CTRL_KEY;
-  }
+    const QMimeData* mimeData{nullptr};
+    nlohmann::json payload;
+    bool valid{false};
+  };
 
-  return int32_t(key - Qt::Key_A) + TP_A_KEY;
-}
+  DragDropCache dragDropCache;
 
-//##################################################################################################
-class Map_lt final : public tp_maps::Map
-{
-  TP_NONCOPYABLE(Map_lt);
-public:
+  //################################################################################################
+  struct PendingMouseEvent
+  {
+    tp_maps::MouseEventType type;
+    tp_maps::MouseEvent event;
+  };
+
+  bool coalesceInputEvents{false};
+  std::vector<PendingMouseEvent> pendingMouseEvents;
+  InputCoalescingStats inputCoalescingStats;
+
+  // Whether the map took the last move and wheel events it was given, events are only queued while
+  // it does so that unhandled events still reach parent widgets such as scroll areas.
+  bool moveHandled{false};
+  bool wheelHandled{false};
+
+  bool frameTimingEnabled{false};
+  FrameTimings frameTimings;
+  FrameTimingRecorder frameTimingRecorder;
+
+  FrameCapture frameCapture;
+
+  bool adaptiveRenderScale{false};
+  RenderScaleController renderScaleController;
+  QTimer* renderScaleIdleTimer{nullptr};
+  std::unique_ptr<QOpenGLFramebufferObject> scaledFBO;
+  std::unique_ptr<QOpenGLFramebufferObject> upscaleFBO;
+  int mapWidth{0};
+  int mapHeight{0};
+
+  //################################################################################################
+  Private(Q* q_):
+    q(q_)
+  {
+    map = new HostedMap();
+    map->makeCurrentCallback = [&]
+    {
+      assert(q->isValid());
+      q->makeCurrent();
+    };
+    map->repaintCallback = [&]{q->update();};
+    map->updateCallback = [&]{startTicking();};
+
+    frameTimingRecorder.setFrameCompletedCallback([&](const FrameTiming& timing){frameCompleted(timing);});
+
+    renderScaleIdleTimer = new QTimer(q);
+    renderScaleIdleTimer->setSingleShot(true);
+    renderScaleIdleTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(renderScaleIdleTimer, &QTimer::timeout, q, [&]
+    {
+      auto now = double(tp_utils::currentTimeMS());
+      if(renderScaleController.checkIdle(now))
+      {
+        renderScaleChanged();
+        return;
+      }
+
+      // The timer can fire early, wait out the rest of the delay as nothing else restores the scale.
+      if(renderScaleController.scale()<1.0f && renderScaleController.interacting(now))
+        renderScaleIdleTimer->start(int(std::ceil(renderScaleController.idleRemainingMS(now))));
+    });
+  }
 
   //################################################################################################
-  Map_lt(MapWidget* mapWidget_):
-    tp_maps::Map(false)
+  ~Private()
   {
-    mapWidget = mapWidget_;
-    setShaderProfile(tp_qt_maps::getShaderProfile());
+    map->clearLayers();
+    delete map;
   }
 
   //################################################################################################
-  ~Map_lt() override
+  bool parseDragDropPayload(const QMimeData* mimeData, nlohmann::json& j)
   {
-    preDelete();
+    if(QString cborMimeType = dragDropMimeType + "+cbor"; mimeData->hasFormat(cborMimeType))
+    {
+      QByteArray assetData = mimeData->data(cborMimeType);
+      auto begin = reinterpret_cast<const uint8_t*>(assetData.constData());
+      j = nlohmann::json::from_cbor(begin, begin+assetData.size(), true, false);
+      if(!j.is_discarded())
+        return true;
+
+      tpWarning() << "Failed to parse CBOR drag drop payload.";
+    }
+
+    if(mimeData->hasFormat(dragDropMimeType))
+    {
+      QByteArray assetData = mimeData->data(dragDropMimeType);
+      QDataStream dataStream(&assetData, QIODevice::ReadOnly);
+      QString dataPayload;
+      dataStream >> dataPayload;
+      j = tp_utils::jsonFromString(dataPayload.toStdString());
+
+      return true;
+    }
+
+    return false;
   }
 
   //################################################################################################
-  using tp_maps::Map::setVisible;
+  //! Parse the payload once per drag, enter, move, and drop events all share the same QMimeData.
+  const nlohmann::json* getDragDropPayload(QDropEvent* event)
+  {
+    const QMimeData* mimeData = event->mimeData();
+    if(!mimeData)
+      return nullptr;
+
+    if(dragDropCache.mimeData != mimeData)
+    {
+      dragDropCache.mimeData = mimeData;
+      dragDropCache.payload = nlohmann::json();
+      dragDropCache.valid = parseDragDropPayload(mimeData, dragDropCache.payload);
+    }
+
+    return dragDropCache.valid?&dragDropCache.payload:nullptr;
+  }
 
   //################################################################################################
-  using tp_maps::Map::invalidateBuffers;
+  //! Lend the cached payload to the map for one event, it is swapped in and out rather than copied.
+  bool dispatchCachedDragDropEvent(tp_maps::DragDropEvent& e)
+  {
+    e.payload.swap(dragDropCache.payload);
+    TP_CLEANUP([&]{e.payload.swap(dragDropCache.payload);});
+    return map->dragDropEvent(e);
+  }
 
-  // GL functions
   //################################################################################################
-  void makeCurrent() override
+  void clearDragDropCache()
   {
-    if(inPaint() == nullptr)
+    dragDropCache = DragDropCache();
+  }
+
+  //################################################################################################
+  void startTicking()
+  {
+    idleTicks.reset();
+
+    if(ticking || q->isHidden())
+      return;
+
+    switch(framePacing)
     {
-      assert(mapWidget->isValid());
-      mapWidget->makeCurrent();
+    case FramePacing::OnDemand:
+      return;
+
+    case FramePacing::FixedRate:
+      if(animationInterval<1)
+        return;
+      animationTimerID = q->startTimer(int(animationInterval));
+      break;
+
+    case FramePacing::VSync:
+      q->update();
+      break;
     }
-    else if(inPaint() != this)
+
+    ticking = true;
+  }
+
+  //################################################################################################
+  void stopTicking()
+  {
+    if(animationTimerID>0)
     {
-      tpWarning() << "Nested makeCurrent() call for a different context.";
-      tp_utils::printStackTrace();
+      q->killTimer(animationTimerID);
+      animationTimerID = -1;
     }
+
+    ticking = false;
   }
 
   //################################################################################################
-  void update(const tp_maps::RenderFromStage& renderFromStage, const std::vector<tp_utils::StringID>& subviews) override
+  void tick()
   {
-    tp_maps::Map::update(renderFromStage, subviews);
+    if(q->visibleRegion().isEmpty())
+      return;
 
-    if(!inPaint() && tpContains(subviews, tp_maps::defaultSID()))
-      mapWidget->update();
+    map->updateRequested = false;
+    animate();
+
+    if(idleTicks.tick(map->updateRequested))
+    {
+      stopTicking();
+      return;
+    }
+
+    // Without an update there will be no frame, and so no frameSwapped to drive the next tick.
+    if(!map->updateRequested && framePacing == FramePacing::VSync)
+      q->update();
   }
 
   //################################################################################################
-  void callAsync(const std::function<void()>& callback) override
+  //! Frames are timed if the user asked for timings or adaptive render scale needs them.
+  bool timingActive() const
   {
-    callAsyncRequests.push_back(callback);
-    callAsyncProcess.call();
+    return frameTimingEnabled || adaptiveRenderScale;
   }
 
   //################################################################################################
-  std::vector<std::function<void()>> callAsyncRequests;
-  tp_qt_utils::CrossThreadCallback callAsyncProcess = tp_qt_utils::CrossThreadCallback([&]
+  void animate()
   {
-    while(!callAsyncRequests.empty())
-      tpTakeFirst(callAsyncRequests)();
-  });
+    if(!timingActive())
+    {
+      map->animate(double(tp_utils::currentTimeMS()));
+      return;
+    }
 
-  MapWidget* mapWidget;
-};
-}
+    auto start = Clock_lt::now();
+    map->animate(double(tp_utils::currentTimeMS()));
+    frameTimingRecorder.addAnimateMS(elapsedMS(start));
+  }
 
-//##################################################################################################
-struct MapWidget::Private
-{
-  TP_REF_COUNT_OBJECTS("tp_qt_maps_widget::MapWidget::Private");
-  TP_NONCOPYABLE(Private);
+  //################################################################################################
+  void frameCompleted(const FrameTiming& timing)
+  {
+    // Frames drawn before the last scale change say nothing about the current scale.
+    if(adaptiveRenderScale && timing.renderScale == renderScaleController.scale())
+    {
+      double cost = std::max(timing.cpuPaintMS, timing.gpuPaintMS);
+      if(renderScaleController.addFrameCost(cost, double(tp_utils::currentTimeMS())))
+        renderScaleChanged();
+    }
 
-  Q* q;
-  Map_lt* map;
+    if(frameTimingEnabled)
+    {
+      frameTimings.addFrame(timing);
+      Q_EMIT q->frameTimed(timing);
+    }
+  }
 
-  int animationTimerID{-1};
+  //################################################################################################
+  void inputReceived()
+  {
+    if(timingActive())
+      frameTimingRecorder.inputReceived();
+  }
 
-  QMetaObject::Connection aboutToBeDestroyedConnection;
+  //################################################################################################
+  //! The scale from Qt's logical pixels to the pixels that the map is drawn at.
+  double pixelScale() const
+  {
+    return q->devicePixelRatio() * double(renderScaleController.scale());
+  }
 
-  QString dragDropMimeType;
+  //################################################################################################
+  void interaction()
+  {
+    if(!adaptiveRenderScale)
+      return;
+
+    renderScaleController.interaction(double(tp_utils::currentTimeMS()));
+    renderScaleIdleTimer->start(int(renderScaleController.idleDelayMS()));
+  }
 
   //################################################################################################
-  Private(Q* q_):
-    q(q_)
+  //! The map is resized at the start of the next paintGL where the context is current.
+  void renderScaleChanged()
   {
-    map = new Map_lt(q);
+    q->update();
+    Q_EMIT q->renderScaleChanged(renderScaleController.scale());
   }
 
   //################################################################################################
-  ~Private()
+  //! Size the map to the widget at the current render scale.
+  void resizeMap()
   {
-    map->clearLayers();
-    delete map;
+    double scale = pixelScale();
+    int w = std::max(1, int(double(q->width())*scale));
+    int h = std::max(1, int(double(q->height())*scale));
+    if(w == mapWidth && h == mapHeight)
+      return;
+
+    mapWidth = w;
+    mapHeight = h;
+    map->resizeGL(w, h);
   }
 
   //################################################################################################
-  bool getDragDropPayload(QDropEvent* event, nlohmann::json& j)
+  //! Bind the framebuffer that the map should draw into, returns true if it must be upscaled.
+  bool bindScaledFBO()
   {
-    if(event->mimeData()->hasFormat(dragDropMimeType))
+    if(renderScaleController.scale()>=1.0f)
     {
-      QByteArray assetData = event->mimeData()->data(dragDropMimeType);
-      QDataStream dataStream(&assetData, QIODevice::ReadOnly);
-      QString dataPayload;
-      dataStream >> dataPayload;
-      j = tp_utils::jsonFromString(dataPayload.toStdString());
+      scaledFBO.reset();
+      upscaleFBO.reset();
+      return false;
+    }
 
-      return true;
+    if(!scaledFBO || scaledFBO->width()!=mapWidth || scaledFBO->height()!=mapHeight)
+    {
+      // Single sampled, the upscale blit can't read from a multisampled buffer.
+      QOpenGLFramebufferObjectFormat format;
+      format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+      scaledFBO = std::make_unique<QOpenGLFramebufferObject>(mapWidth, mapHeight, format);
     }
 
-    return false;
+    scaledFBO->bind();
+    return true;
+  }
+
+  //################################################################################################
+  //! Stretch the scaled frame over the widget's framebuffer.
+  void upscale()
+  {
+    int w = int(double(q->width())*q->devicePixelRatio());
+    int h = int(double(q->height())*q->devicePixelRatio());
+
+    GLuint target = q->defaultFramebufferObject();
+
+    // Scaling blits can't write to a multisampled buffer, so go through a full size buffer first.
+    if(q->format().samples()>0)
+    {
+      if(!upscaleFBO || upscaleFBO->width()!=w || upscaleFBO->height()!=h)
+        upscaleFBO = std::make_unique<QOpenGLFramebufferObject>(w, h);
+      target = upscaleFBO->handle();
+    }
+    else
+      upscaleFBO.reset();
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, scaledFBO->handle());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(0, 0, mapWidth, mapHeight, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    if(upscaleFBO)
+    {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, upscaleFBO->handle());
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, q->defaultFramebufferObject());
+      glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, q->defaultFramebufferObject());
+  }
+
+  //################################################################################################
+  //! Queue a move or wheel event, merging it with the last pending event if possible.
+  void queueMouseEvent(tp_maps::MouseEventType type, const tp_maps::MouseEvent& e)
+  {
+    if(!pendingMouseEvents.empty())
+    {
+      auto& last = pendingMouseEvents.back();
+      if(last.type == type && last.event.modifiers == e.modifiers && last.event.button == e.button)
+      {
+        int delta = last.event.delta;
+        last.event = e;
+        if(type == tp_maps::MouseEventType::Wheel)
+          last.event.delta += delta;
+        return;
+      }
+    }
+
+    pendingMouseEvents.push_back({type, e});
   }
 
   //################################################################################################
-  static tp_maps::Button convertMouseButton(Qt::MouseButton button)
+  void flushPendingMouseEvents()
   {
-    switch(button)
+    if(pendingMouseEvents.empty())
+      return;
+
+    // Swap out first, the map may spin the event loop and queue more events.
+    std::vector<PendingMouseEvent> events;
+    events.swap(pendingMouseEvents);
+
+    for(const auto& pending : events)
     {
-    case Qt::RightButton:  return tp_maps::Button::RightButton;
-    case Qt::LeftButton:   return tp_maps::Button::LeftButton;
-    case Qt::MiddleButton: return tp_maps::Button::MiddleButton;
-    default:               return tp_maps::Button::NoButton;
+      if(pending.type == tp_maps::MouseEventType::Wheel)
+      {
+        inputCoalescingStats.dispatchedWheelEvents++;
+        wheelHandled = map->mouseEvent(pending.event);
+      }
+      else
+      {
+        inputCoalescingStats.dispatchedMouseMoveEvents++;
+        moveHandled = map->mouseEvent(pending.event);
+      }
     }
   }
 };
@@ -209,12 +469,32 @@ MapWidget::MapWidget(QWidget* parent):
 
   d->map->setVisible(false);
   d->map->setWriteAlpha(true);
+
+  connect(this, &QOpenGLWidget::frameSwapped, this, [&]
+  {
+    if(d->timingActive())
+      d->frameTimingRecorder.framePresented();
+
+    if(d->framePacing == FramePacing::VSync && d->ticking)
+      d->tick();
+  });
 }
 
 //##################################################################################################
 MapWidget::~MapWidget()
 {
   disconnect(d->aboutToBeDestroyedConnection);
+
+  if(isValid())
+  {
+    makeCurrent();
+    d->frameTimingRecorder.deleteQueries();
+    d->frameCapture.deleteBuffers();
+    d->scaledFBO.reset();
+    d->upscaleFBO.reset();
+    doneCurrent();
+  }
+
   delete d;
 }
 
@@ -228,6 +508,7 @@ tp_maps::Map* MapWidget::map()
 void MapWidget::setDragDropMimeType(const QString& dragDropMimeType)
 {
   d->dragDropMimeType = dragDropMimeType;
+  d->clearDragDropCache();
 }
 
 //##################################################################################################
@@ -245,9 +526,151 @@ QSize MapWidget::sizeHint() const
 //##################################################################################################
 void MapWidget::setAnimationInterval(int64_t interval)
 {
-  if(d->animationTimerID>0)
-    killTimer(d->animationTimerID);
-  d->animationTimerID = startTimer(int(interval));
+  d->animationInterval = interval;
+  d->stopTicking();
+  d->startTicking();
+}
+
+//##################################################################################################
+void MapWidget::setFramePacing(FramePacing framePacing)
+{
+  d->framePacing = framePacing;
+  d->stopTicking();
+  d->startTicking();
+}
+
+//##################################################################################################
+FramePacing MapWidget::framePacing() const
+{
+  return d->framePacing;
+}
+
+//##################################################################################################
+void MapWidget::setStopAnimationWhenIdle(bool stopAnimationWhenIdle)
+{
+  d->idleTicks.stopWhenIdle = stopAnimationWhenIdle;
+  d->startTicking();
+}
+
+//##################################################################################################
+bool MapWidget::stopAnimationWhenIdle() const
+{
+  return d->idleTicks.stopWhenIdle;
+}
+
+//##################################################################################################
+bool MapWidget::isAnimating() const
+{
+  return d->ticking;
+}
+
+//##################################################################################################
+CallAsyncStats MapWidget::callAsyncStats() const
+{
+  return d->map->callAsyncQueue.stats();
+}
+
+//##################################################################################################
+void MapWidget::setCallAsyncMaxDrainTimeMS(double maxDrainTimeMS)
+{
+  d->map->callAsyncQueue.setMaxDrainTimeMS(maxDrainTimeMS);
+}
+
+//##################################################################################################
+void MapWidget::setCoalesceInputEvents(bool coalesceInputEvents)
+{
+  d->coalesceInputEvents = coalesceInputEvents;
+  if(!coalesceInputEvents)
+    d->flushPendingMouseEvents();
+}
+
+//##################################################################################################
+bool MapWidget::coalesceInputEvents() const
+{
+  return d->coalesceInputEvents;
+}
+
+//##################################################################################################
+InputCoalescingStats MapWidget::inputCoalescingStats() const
+{
+  return d->inputCoalescingStats;
+}
+
+//##################################################################################################
+void MapWidget::resetInputCoalescingStats()
+{
+  d->inputCoalescingStats = InputCoalescingStats();
+}
+
+//##################################################################################################
+void MapWidget::setFrameTimingEnabled(bool frameTimingEnabled)
+{
+  d->frameTimingEnabled = frameTimingEnabled;
+  if(!d->timingActive())
+    d->frameTimingRecorder.abandonPending();
+}
+
+//##################################################################################################
+bool MapWidget::frameTimingEnabled() const
+{
+  return d->frameTimingEnabled;
+}
+
+//##################################################################################################
+FrameTimings& MapWidget::frameTimings()
+{
+  return d->frameTimings;
+}
+
+//##################################################################################################
+FrameTimingStats MapWidget::frameTimingStats(size_t window) const
+{
+  return d->frameTimings.stats(window);
+}
+
+//##################################################################################################
+FrameCapture& MapWidget::frameCapture()
+{
+  return d->frameCapture;
+}
+
+//##################################################################################################
+void MapWidget::setAdaptiveRenderScale(bool adaptiveRenderScale)
+{
+  if(d->adaptiveRenderScale == adaptiveRenderScale)
+    return;
+
+  d->adaptiveRenderScale = adaptiveRenderScale;
+
+  if(!adaptiveRenderScale)
+  {
+    d->renderScaleIdleTimer->stop();
+    if(!d->timingActive())
+      d->frameTimingRecorder.abandonPending();
+  }
+
+  bool changed = d->renderScaleController.scale()<1.0f;
+  d->renderScaleController.reset();
+  if(changed)
+    d->renderScaleChanged();
+}
+
+//##################################################################################################
+bool MapWidget::adaptiveRenderScale() const
+{
+  return d->adaptiveRenderScale;
+}
+
+//##################################################################################################
+RenderScaleController& MapWidget::renderScaleController()
+{
+  return d->renderScaleController;
+}
+
+//##################################################################################################
+float MapWidget::renderScale() const
+{
+  return d->renderScaleController.scale();
 }
 
 //##################################################################################################
@@ -271,14 +694,22 @@ void MapWidget::initializeGL()
 
   d->aboutToBeDestroyedConnection = connectContext(context(), this, [&]
   {
+    makeCurrent();
+    d->frameTimingRecorder.deleteQueries();
+    d->frameCapture.deleteBuffers();
+    d->scaledFBO.reset();
+    d->upscaleFBO.reset();
+    doneCurrent();
+
     d->map->invalidateBuffers();
   });
 }
 
 //##################################################################################################
-void MapWidget::resizeGL(int width, int height)
+void MapWidget::resizeGL([[maybe_unused]] int width, [[maybe_unused]] int height)
 {
-  d->map->resizeGL(width*devicePixelRatio(), height*devicePixelRatio());
+  d->interaction();
+  d->resizeMap();
 }
 
 //##################################################################################################
@@ -286,35 +717,54 @@ void MapWidget::paintGL()
 {
 
 #ifdef TP_DEBUG_RENDER_PASSES
-  static size_t counter=0;
-  counter++;
+  // Log each frame next to the image that the frame capture writes for it.
+  std::unique_ptr<tp_utils::TeeMessageHandler> tee;
+  if(d->frameCapture.isCapturing())
+    tee = std::make_unique<tp_utils::TeeMessageHandler>(d->frameCapture.framePath(d->frameCapture.frameNumber(), "txt"), false);
+#endif
 
-  std::string rootFolder="/home/tom/Desktop/iii/";
-  tp_utils::TeeMessageHandler tee(tp_utils::pathAppend(rootFolder, std::to_string(counter) + ".txt"), false);
+  d->resizeMap();
 
-  TP_CLEANUP([&]
+  bool timed = d->timingActive();
+  if(timed)
+    d->frameTimingRecorder.beginFrame();
+
+  if(!d->pendingMouseEvents.empty() || d->framePacing == FramePacing::OnDemand)
   {
-    QImage img = grabFramebuffer();
-    img.save(QString::fromStdString(tp_utils::pathAppend(rootFolder, std::to_string(counter) + ".png")));
-  });
-#endif
+    d->map->suppressHostUpdate = true;
+    d->flushPendingMouseEvents();
+    if(d->framePacing == FramePacing::OnDemand)
+      d->animate();
+    d->map->suppressHostUpdate = false;
+  }
 
+  bool scaled = d->bindScaledFBO();
 
   d->map->paintGL();
   d->map->setWriteAlpha(true);
+
+  if(scaled)
+    d->upscale();
+
+  d->frameCapture.capture(defaultFramebufferObject(), int(width()*devicePixelRatio()), int(height()*devicePixelRatio()));
+
+  if(timed)
+    d->frameTimingRecorder.endFrame(d->renderScaleController.scale());
 }
 
 //################################################################################################
 void MapWidget::dragEnterEvent(QDragEnterEvent* event)
 {
-  nlohmann::json j;
-  if(d->getDragDropPayload(event, j))
+  d->flushPendingMouseEvents();
+
+  d->clearDragDropCache();
+
+  if(d->getDragDropPayload(event))
   {
     tp_maps::DragDropEvent e(tp_maps::DragDropEventType::Enter);
     e.pos.x = event->position().toPoint().x();
     e.pos.y = event->position().toPoint().y();
-    e.payload = j;
-    if(d->map->dragDropEvent(e))
+    if(d->dispatchCachedDragDropEvent(e))
       event->accept();
   }
   else
@@ -326,6 +776,10 @@ void MapWidget::dragEnterEvent(QDragEnterEvent* event)
 //##################################################################################################
 void MapWidget::dragLeaveEvent(QDragLeaveEvent* event)
 {
+  d->flushPendingMouseEvents();
+
+  d->clearDragDropCache();
+
   tp_maps::DragDropEvent e(tp_maps::DragDropEventType::Leave);
   d->map->dragDropEvent(e);
   event->accept();
@@ -334,14 +788,14 @@ void MapWidget::dragLeaveEvent(QDragLeaveEvent* event)
 //##################################################################################################
 void MapWidget::dragMoveEvent(QDragMoveEvent* event)
 {
-  nlohmann::json j;
-  if(d->getDragDropPayload(event, j))
+  d->flushPendingMouseEvents();
+
+  if(d->getDragDropPayload(event))
   {
     tp_maps::DragDropEvent e(tp_maps::DragDropEventType::Move);
-    e.pos.x = event->position().toPoint().x() * devicePixelRatio();
-    e.pos.y = event->position().toPoint().y() * devicePixelRatio();
-    e.payload = j;
-    d->map->dragDropEvent(e);
+    e.pos.x = event->position().toPoint().x() * d->pixelScale();
+    e.pos.y = event->position().toPoint().y() * d->pixelScale();
+    d->dispatchCachedDragDropEvent(e);
 
     event->setDropAction(Qt::MoveAction);
     event->accept();
@@ -355,13 +809,17 @@ void MapWidget::dragMoveEvent(QDragMoveEvent* event)
 //################################################################################################
 void MapWidget::dropEvent(QDropEvent *event)
 {
-  nlohmann::json j;
-  if(d->getDragDropPayload(event, j))
+  d->flushPendingMouseEvents();
+
+  if(d->getDragDropPayload(event))
   {
     tp_maps::DragDropEvent e(tp_maps::DragDropEventType::Drop);
-    e.pos.x = event->position().toPoint().x() * devicePixelRatio();
-    e.pos.y = event->position().toPoint().y() * devicePixelRatio();
-    e.payload = j;
+    e.pos.x = event->position().toPoint().x() * d->pixelScale();
+    e.pos.y = event->position().toPoint().y() * d->pixelScale();
+
+    // The drag is over so the cached payload can be moved rather than copied.
+    e.payload = std::move(d->dragDropCache.payload);
+    d->clearDragDropCache();
     d->map->dragDropEvent(e);
 
     event->setDropAction(Qt::MoveAction);
@@ -369,20 +827,20 @@ void MapWidget::dropEvent(QDropEvent *event)
   }
   else
   {
-      event->ignore();
+    d->clearDragDropCache();
+    event->ignore();
   }
 }
 
 //##################################################################################################
 void MapWidget::mousePressEvent(QMouseEvent* event)
 {
-  tp_maps::MouseEvent e(tp_maps::MouseEventType::Press);
+  d->flushPendingMouseEvents();
 
-  e.button = Private::convertMouseButton(event->button());
-  e.pos.x = event->pos().x()*devicePixelRatio();
-  e.pos.y = event->pos().y()*devicePixelRatio();
+  d->interaction();
+  d->inputReceived();
 
-  e.modifiers = convertKeyboardModifiers(event->modifiers());
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Press, event, d->pixelScale());
 
   if(d->map->mouseEvent(e))
     event->accept();
@@ -391,28 +849,35 @@ void MapWidget::mousePressEvent(QMouseEvent* event)
 //##################################################################################################
 void MapWidget::mouseMoveEvent(QMouseEvent* event)
 {
-  tp_maps::MouseEvent e(tp_maps::MouseEventType::Move);
+  if(event->buttons() != Qt::NoButton)
+    d->interaction();
+  d->inputReceived();
 
-  e.button = Private::convertMouseButton(event->button());
-  e.pos.x = event->pos().x()*devicePixelRatio();
-  e.pos.y = event->pos().y()*devicePixelRatio();
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Move, event, d->pixelScale());
 
-  e.modifiers = convertKeyboardModifiers(event->modifiers());
+  d->inputCoalescingStats.rawMouseMoveEvents++;
 
-  if(d->map->mouseEvent(e))
+  if(d->coalesceInputEvents && d->moveHandled)
+  {
+    d->queueMouseEvent(tp_maps::MouseEventType::Move, e);
+    update();
+    event->accept();
+    return;
+  }
+
+  d->inputCoalescingStats.dispatchedMouseMoveEvents++;
+
+  d->moveHandled = d->map->mouseEvent(e);
+  if(d->moveHandled)
     event->accept();
 }
 
 //##################################################################################################
 void MapWidget::mouseReleaseEvent(QMouseEvent* event)
 {
-  tp_maps::MouseEvent e(tp_maps::MouseEventType::Release);
-
-  e.button = Private::convertMouseButton(event->button());
-  e.pos.x = event->pos().x()*devicePixelRatio();
-  e.pos.y = event->pos().y()*devicePixelRatio();
+  d->flushPendingMouseEvents();
 
-  e.modifiers = convertKeyboardModifiers(event->modifiers());
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Release, event, d->pixelScale());
 
   if(d->map->mouseEvent(e))
     event->accept();
@@ -421,34 +886,34 @@ void MapWidget::mouseReleaseEvent(QMouseEvent* event)
 //##################################################################################################
 void MapWidget::wheelEvent(QWheelEvent* event)
 {
-  tp_maps::MouseEvent e(tp_maps::MouseEventType::Wheel);
+  d->interaction();
+  d->inputReceived();
 
-#if QT_VERSION < 0x060000
-  e.pos.x = event->pos().x()*devicePixelRatio();
-  e.pos.y = event->pos().y()*devicePixelRatio();
-  e.delta = event->delta();
-#else
-  e.pos.x = event->position().x()*devicePixelRatio();
-  e.pos.y = event->position().y()*devicePixelRatio();
-  e.delta = event->angleDelta().y();
-#endif
+  auto e = convertWheelEvent(event, d->pixelScale());
 
-  e.modifiers = convertKeyboardModifiers(event->modifiers());
+  d->inputCoalescingStats.rawWheelEvents++;
 
-  if(d->map->mouseEvent(e))
+  if(d->coalesceInputEvents && d->wheelHandled)
+  {
+    d->queueMouseEvent(tp_maps::MouseEventType::Wheel, e);
+    update();
+    event->accept();
+    return;
+  }
+
+  d->inputCoalescingStats.dispatchedWheelEvents++;
+
+  d->wheelHandled = d->map->mouseEvent(e);
+  if(d->wheelHandled)
     event->accept();
 }
 
 //##################################################################################################
 void MapWidget::mouseDoubleClickEvent(QMouseEvent* event)
 {
-  tp_maps::MouseEvent e(tp_maps::MouseEventType::DoubleClick);
+  d->flushPendingMouseEvents();
 
-  e.button = Private::convertMouseButton(event->button());
-  e.pos.x = event->pos().x()*devicePixelRatio();
-  e.pos.y = event->pos().y()*devicePixelRatio();
-
-  e.modifiers = convertKeyboardModifiers(event->modifiers());
+  auto e = convertMouseEvent(tp_maps::MouseEventType::DoubleClick, event, d->pixelScale());
 
   if(d->map->mouseEvent(e))
     event->accept();
@@ -457,9 +922,12 @@ void MapWidget::mouseDoubleClickEvent(QMouseEvent* event)
 //##################################################################################################
 void MapWidget::keyPressEvent(QKeyEvent *event)
 {
-  tp_maps::KeyEvent e(tp_maps::KeyEventType::Press);
-  e.scancode = toScancode(event->key());
-  e.modifiers = convertKeyboardModifiers(event->modifiers());
+  d->flushPendingMouseEvents();
+
+  d->interaction();
+  d->inputReceived();
+
+  auto e = convertKeyEvent(tp_maps::KeyEventType::Press, event);
   if(d->map->keyEvent(e))
     event->accept();
 }
@@ -467,9 +935,9 @@ void MapWidget::keyPressEvent(QKeyEvent *event)
 //##################################################################################################
 void MapWidget::keyReleaseEvent(QKeyEvent *event)
 {
-  tp_maps::KeyEvent e(tp_maps::KeyEventType::Release);
-  e.scancode = toScancode(event->key());
-  e.modifiers = convertKeyboardModifiers(event->modifiers());
+  d->flushPendingMouseEvents();
+
+  auto e = convertKeyEvent(tp_maps::KeyEventType::Release, event);
   if(d->map->keyEvent(e))
     event->accept();
 }
@@ -477,16 +945,15 @@ void MapWidget::keyReleaseEvent(QKeyEvent *event)
 //##################################################################################################
 void MapWidget::timerEvent(QTimerEvent* event)
 {
-  if(isHidden() || visibleRegion().isEmpty())
-    return;
-
   if(event->timerId() == d->animationTimerID)
-    d->map->animate(double(tp_utils::currentTimeMS()));
+    d->tick();
 }
 
 //##################################################################################################
 void MapWidget::hideEvent(QHideEvent* event)
 {
+  d->flushPendingMouseEvents();
+  d->stopTicking();
   d->map->setVisible(false);
   event->accept();
 }
@@ -495,6 +962,7 @@ void MapWidget::hideEvent(QHideEvent* event)
 void MapWidget::showEvent(QShowEvent* event)
 {
   d->map->setVisible(true);
+  d->startTicking();
   event->accept();
 }
 
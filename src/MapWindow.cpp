@@ -0,0 +1,324 @@
+#include "tp_qt_maps_widget/MapWindow.h"
+#include "tp_qt_maps_widget/HostedMap.h"
+#include "tp_qt_maps_widget/ConvertEvents.h"
+#include "tp_qt_maps_widget/ConnectContext.h"
+#include "tp_qt_maps_widget/IdleTicks.h"
+
+#include "tp_utils/DebugUtils.h"
+#include "tp_utils/TimeUtils.h"
+
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QKeyEvent>
+
+#include <chrono>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+struct MapWindow::Private
+{
+  TP_REF_COUNT_OBJECTS("tp_qt_maps_widget::MapWindow::Private");
+  TP_NONCOPYABLE(Private);
+
+  Q* q;
+  HostedMap* map;
+
+  int animationTimerID{-1};
+  int64_t animationInterval{16};
+  IdleTicks idleTicks;
+
+  bool frameTimingEnabled{false};
+  FrameTimings frameTimings;
+  FrameTimingRecorder frameTimingRecorder;
+
+  QMetaObject::Connection aboutToBeDestroyedConnection;
+
+  //################################################################################################
+  Private(Q* q_):
+    q(q_)
+  {
+    map = new HostedMap();
+    map->makeCurrentCallback = [&]{q->makeCurrent();};
+    map->repaintCallback = [&]{q->update();};
+    map->updateCallback = [&]{startTicking();};
+
+    frameTimingRecorder.setFrameCompletedCallback([&](const FrameTiming& timing)
+    {
+      frameTimings.addFrame(timing);
+      Q_EMIT q->frameTimed(timing);
+    });
+  }
+
+  //################################################################################################
+  ~Private()
+  {
+    map->clearLayers();
+    delete map;
+  }
+
+  //################################################################################################
+  void startTicking()
+  {
+    idleTicks.reset();
+    if(animationTimerID>0 || animationInterval<1 || !q->isVisible())
+      return;
+
+    animationTimerID = q->startTimer(int(animationInterval));
+  }
+
+  //################################################################################################
+  void stopTicking()
+  {
+    if(animationTimerID>0)
+    {
+      q->killTimer(animationTimerID);
+      animationTimerID = -1;
+    }
+  }
+
+  //################################################################################################
+  void animate()
+  {
+    if(!frameTimingEnabled)
+    {
+      map->animate(double(tp_utils::currentTimeMS()));
+      return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    map->animate(double(tp_utils::currentTimeMS()));
+    frameTimingRecorder.addAnimateMS(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  //################################################################################################
+  void tick()
+  {
+    map->updateRequested = false;
+    animate();
+
+    if(idleTicks.tick(map->updateRequested))
+      stopTicking();
+  }
+
+  //################################################################################################
+  void inputReceived()
+  {
+    if(frameTimingEnabled)
+      frameTimingRecorder.inputReceived();
+  }
+};
+
+//##################################################################################################
+MapWindow::MapWindow(QWindow* parent):
+  QOpenGLWindow(QOpenGLWindow::NoPartialUpdate, parent),
+  d(new Private(this))
+{
+  d->map->setVisible(false);
+  d->map->setWriteAlpha(true);
+
+  connect(this, &QOpenGLWindow::frameSwapped, this, [&]
+  {
+    if(d->frameTimingEnabled)
+      d->frameTimingRecorder.framePresented();
+  });
+}
+
+//##################################################################################################
+MapWindow::~MapWindow()
+{
+  disconnect(d->aboutToBeDestroyedConnection);
+
+  if(isValid())
+  {
+    makeCurrent();
+    d->frameTimingRecorder.deleteQueries();
+    doneCurrent();
+  }
+
+  delete d;
+}
+
+//##################################################################################################
+tp_maps::Map* MapWindow::map()
+{
+  return d->map;
+}
+
+//##################################################################################################
+void MapWindow::setAnimationInterval(int64_t interval)
+{
+  d->animationInterval = interval;
+  d->stopTicking();
+  d->startTicking();
+}
+
+//##################################################################################################
+void MapWindow::setStopAnimationWhenIdle(bool stopAnimationWhenIdle)
+{
+  d->idleTicks.stopWhenIdle = stopAnimationWhenIdle;
+  d->startTicking();
+}
+
+//##################################################################################################
+bool MapWindow::stopAnimationWhenIdle() const
+{
+  return d->idleTicks.stopWhenIdle;
+}
+
+//##################################################################################################
+CallAsyncStats MapWindow::callAsyncStats() const
+{
+  return d->map->callAsyncQueue.stats();
+}
+
+//##################################################################################################
+void MapWindow::setFrameTimingEnabled(bool frameTimingEnabled)
+{
+  d->frameTimingEnabled = frameTimingEnabled;
+  if(!frameTimingEnabled)
+    d->frameTimingRecorder.abandonPending();
+}
+
+//##################################################################################################
+bool MapWindow::frameTimingEnabled() const
+{
+  return d->frameTimingEnabled;
+}
+
+//##################################################################################################
+FrameTimings& MapWindow::frameTimings()
+{
+  return d->frameTimings;
+}
+
+//##################################################################################################
+FrameTimingStats MapWindow::frameTimingStats(size_t window) const
+{
+  return d->frameTimings.stats(window);
+}
+
+//##################################################################################################
+void MapWindow::initializeGL()
+{
+  d->map->initializeGL();
+  Q_EMIT initialized();
+
+  if(d->aboutToBeDestroyedConnection)
+    disconnect(d->aboutToBeDestroyedConnection);
+
+  d->aboutToBeDestroyedConnection = connectContext(context(), this, [&]
+  {
+    makeCurrent();
+    d->frameTimingRecorder.deleteQueries();
+    doneCurrent();
+
+    d->map->invalidateBuffers();
+  });
+}
+
+//##################################################################################################
+void MapWindow::resizeGL(int width, int height)
+{
+  d->map->resizeGL(width*devicePixelRatio(), height*devicePixelRatio());
+}
+
+//##################################################################################################
+void MapWindow::paintGL()
+{
+  bool timed = d->frameTimingEnabled;
+  if(timed)
+    d->frameTimingRecorder.beginFrame();
+
+  d->map->paintGL();
+  d->map->setWriteAlpha(true);
+
+  if(timed)
+    d->frameTimingRecorder.endFrame();
+}
+
+//##################################################################################################
+void MapWindow::mousePressEvent(QMouseEvent* event)
+{
+  d->inputReceived();
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Press, event, devicePixelRatio());
+  if(d->map->mouseEvent(e))
+    event->accept();
+}
+
+//##################################################################################################
+void MapWindow::mouseMoveEvent(QMouseEvent* event)
+{
+  d->inputReceived();
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Move, event, devicePixelRatio());
+  if(d->map->mouseEvent(e))
+    event->accept();
+}
+
+//##################################################################################################
+void MapWindow::mouseReleaseEvent(QMouseEvent* event)
+{
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Release, event, devicePixelRatio());
+  if(d->map->mouseEvent(e))
+    event->accept();
+}
+
+//##################################################################################################
+void MapWindow::wheelEvent(QWheelEvent* event)
+{
+  d->inputReceived();
+  auto e = convertWheelEvent(event, devicePixelRatio());
+  if(d->map->mouseEvent(e))
+    event->accept();
+}
+
+//##################################################################################################
+void MapWindow::mouseDoubleClickEvent(QMouseEvent* event)
+{
+  auto e = convertMouseEvent(tp_maps::MouseEventType::DoubleClick, event, devicePixelRatio());
+  if(d->map->mouseEvent(e))
+    event->accept();
+}
+
+//##################################################################################################
+void MapWindow::keyPressEvent(QKeyEvent* event)
+{
+  d->inputReceived();
+  auto e = convertKeyEvent(tp_maps::KeyEventType::Press, event);
+  if(d->map->keyEvent(e))
+    event->accept();
+}
+
+//##################################################################################################
+void MapWindow::keyReleaseEvent(QKeyEvent* event)
+{
+  auto e = convertKeyEvent(tp_maps::KeyEventType::Release, event);
+  if(d->map->keyEvent(e))
+    event->accept();
+}
+
+//##################################################################################################
+void MapWindow::timerEvent(QTimerEvent* event)
+{
+  if(event->timerId() == d->animationTimerID)
+    d->tick();
+}
+
+//##################################################################################################
+void MapWindow::hideEvent(QHideEvent* event)
+{
+  d->stopTicking();
+  d->map->setVisible(false);
+  QOpenGLWindow::hideEvent(event);
+}
+
+//##################################################################################################
+void MapWindow::showEvent(QShowEvent* event)
+{
+  d->map->setVisible(true);
+  QOpenGLWindow::showEvent(event);
+  d->startTicking();
+}
+
+}
@@ -0,0 +1,112 @@
+#include "tp_qt_maps_widget/MaterialDelta.h"
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+bool MaterialDelta::empty() const
+{
+  return fields.empty() && textures.empty() && !nameChanged && !blendFileChanged;
+}
+
+//##################################################################################################
+void MaterialDelta::setField(size_t field, const MaterialFieldValue& value)
+{
+  for(auto& change : fields)
+  {
+    if(change.field == field)
+    {
+      change.value = value;
+      return;
+    }
+  }
+
+  fields.push_back({field, value});
+}
+
+//##################################################################################################
+void MaterialDelta::setTexture(const std::string& type, const std::string& name)
+{
+  for(auto& change : textures)
+  {
+    if(change.type == type)
+    {
+      change.name = name;
+      return;
+    }
+  }
+
+  textures.push_back({type, name});
+}
+
+//##################################################################################################
+void MaterialDelta::setName(const std::string& name_)
+{
+  nameChanged = true;
+  name = name_;
+}
+
+//##################################################################################################
+void MaterialDelta::setBlendFile(const std::string& blendFile_)
+{
+  blendFileChanged = true;
+  blendFile = blendFile_;
+}
+
+//##################################################################################################
+void MaterialDelta::merge(const MaterialDelta& other)
+{
+  for(const auto& change : other.fields)
+    setField(change.field, change.value);
+
+  for(const auto& change : other.textures)
+    setTexture(change.type, change.name);
+
+  if(other.nameChanged)
+    setName(other.name);
+
+  if(other.blendFileChanged)
+    setBlendFile(other.blendFile);
+}
+
+//##################################################################################################
+void MaterialDelta::apply(tp_math_utils::Material& material) const
+{
+  for(const auto& change : fields)
+    setMaterialFieldValue(material, change.field, change.value);
+
+  for(const auto& change : textures)
+    setMaterialTexture(material, change.type, change.name);
+
+  if(nameChanged)
+    material.name = name;
+
+  if(blendFileChanged)
+    setMaterialBlendFile(material, blendFile);
+}
+
+//##################################################################################################
+MaterialDelta diffMaterials(const tp_math_utils::Material& from, const tp_math_utils::Material& to)
+{
+  MaterialDelta delta;
+
+  for(size_t i=0; i<materialFields().size(); i++)
+    if(auto value = materialFieldValue(to, i); value != materialFieldValue(from, i))
+      delta.fields.push_back({i, value});
+
+  viewMaterialTextureTypes(to, [&](const std::string& type, const std::string&)
+  {
+    if(auto name = materialTexture(to, type); name != materialTexture(from, type))
+      delta.textures.push_back({type, name});
+  });
+
+  if(!(from.name == to.name))
+    delta.setName(to.name.toString());
+
+  if(auto blendFile = materialBlendFile(to); blendFile != materialBlendFile(from))
+    delta.setBlendFile(blendFile);
+
+  return delta;
+}
+
+}
@@ -0,0 +1,442 @@
+#include "tp_qt_maps_widget/MaterialFields.h"
+
+#include "tp_math_utils/materials/OpenGLMaterial.h"
+#include "tp_math_utils/materials/LegacyMaterial.h"
+#include "tp_math_utils/materials/ExternalMaterial.h"
+
+#include <functional>
+#include <type_traits>
+
+namespace tp_qt_maps_widget
+{
+
+namespace
+{
+using Material_lt = tp_math_utils::Material;
+using OpenGL_lt = std::remove_pointer_t<decltype(std::declval<Material_lt&>().findOrAddOpenGL())>;
+using Legacy_lt = std::remove_pointer_t<decltype(std::declval<Material_lt&>().findOrAddLegacy())>;
+using UV_lt = decltype(Material_lt::uvTransformation);
+
+//##################################################################################################
+template<typename T>
+struct MemberType_lt;
+
+//##################################################################################################
+template<typename C, typename T>
+struct MemberType_lt<T C::*>
+{
+  using Type = T;
+};
+
+//##################################################################################################
+//! Write and read access to one value, see MaterialField.
+template<typename T>
+struct Accessor_lt
+{
+  T* (*field)(Material_lt&);
+  T (*value)(const Material_lt&);
+};
+
+//##################################################################################################
+//! True if M has a const viewOpenGL() and viewLegacy(), older versions of Material only have findOrAdd.
+template<typename M, typename = void>
+struct HasConstView_lt : std::false_type{};
+
+//##################################################################################################
+template<typename M>
+struct HasConstView_lt<M, std::void_t<decltype(std::declval<const M&>().viewOpenGL(std::function<void(const OpenGL_lt&)>())),
+                                      decltype(std::declval<const M&>().viewLegacy(std::function<void(const Legacy_lt&)>()))>> : std::true_type{};
+
+//##################################################################################################
+//! Calls closure with the OpenGL sub-material, or the defaults findOrAddOpenGL() would add.
+template<typename M, typename F>
+void viewOpenGL_lt(const M& material, const F& closure)
+{
+  if constexpr(HasConstView_lt<M>::value)
+  {
+    bool found{false};
+    material.viewOpenGL([&](const OpenGL_lt& openGL)
+    {
+      found = true;
+      closure(openGL);
+    });
+
+    if(!found)
+    {
+      static const OpenGL_lt defaults;
+      closure(defaults);
+    }
+  }
+  else
+  {
+    // Slow, copies the whole material, but only needs findOrAddOpenGL().
+    M copy = material;
+    closure(*copy.findOrAddOpenGL());
+  }
+}
+
+//##################################################################################################
+//! Calls closure with the legacy sub-material, or the defaults findOrAddLegacy() would add.
+template<typename M, typename F>
+void viewLegacy_lt(const M& material, const F& closure)
+{
+  if constexpr(HasConstView_lt<M>::value)
+  {
+    bool found{false};
+    material.viewLegacy([&](const Legacy_lt& legacy)
+    {
+      found = true;
+      closure(legacy);
+    });
+
+    if(!found)
+    {
+      static const Legacy_lt defaults;
+      closure(defaults);
+    }
+  }
+  else
+  {
+    M copy = material;
+    closure(*copy.findOrAddLegacy());
+  }
+}
+
+//##################################################################################################
+template<auto member>
+auto openGLField_lt(Material_lt& material)
+{
+  return &(material.findOrAddOpenGL()->*member);
+}
+
+//##################################################################################################
+template<auto member>
+auto openGLValue_lt(const Material_lt& material)
+{
+  typename MemberType_lt<decltype(member)>::Type value{};
+  viewOpenGL_lt(material, [&](const OpenGL_lt& openGL){value = openGL.*member;});
+  return value;
+}
+
+//##################################################################################################
+template<auto member>
+constexpr Accessor_lt<typename MemberType_lt<decltype(member)>::Type> openGL_lt{&openGLField_lt<member>, &openGLValue_lt<member>};
+
+//##################################################################################################
+template<auto member>
+auto legacyField_lt(Material_lt& material)
+{
+  return &(material.findOrAddLegacy()->*member);
+}
+
+//##################################################################################################
+template<auto member>
+auto legacyValue_lt(const Material_lt& material)
+{
+  typename MemberType_lt<decltype(member)>::Type value{};
+  viewLegacy_lt(material, [&](const Legacy_lt& legacy){value = legacy.*member;});
+  return value;
+}
+
+//##################################################################################################
+template<auto member>
+constexpr Accessor_lt<typename MemberType_lt<decltype(member)>::Type> legacy_lt{&legacyField_lt<member>, &legacyValue_lt<member>};
+
+//##################################################################################################
+//! A float of the UV transformation, component selects from a vector member or is -1 for a float.
+template<auto member, int component>
+float* uvField_lt(Material_lt& material)
+{
+  if constexpr(component<0)
+    return &(material.uvTransformation.*member);
+  else
+    return &(material.uvTransformation.*member)[component];
+}
+
+//##################################################################################################
+template<auto member, int component>
+float uvValue_lt(const Material_lt& material)
+{
+  if constexpr(component<0)
+    return material.uvTransformation.*member;
+  else
+    return (material.uvTransformation.*member)[component];
+}
+
+//##################################################################################################
+template<auto member, int component=-1>
+constexpr Accessor_lt<float> uv_lt{&uvField_lt<member, component>, &uvValue_lt<member, component>};
+
+//##################################################################################################
+constexpr MaterialField floatField_lt(const char* section,
+                                      const char* name,
+                                      float min,
+                                      float max,
+                                      MaterialFieldMapping mapping,
+                                      const Accessor_lt<float>& accessor)
+{
+  MaterialField field{section, name, MaterialFieldType::Float};
+  field.min = min;
+  field.max = max;
+  field.mapping = mapping;
+  field.floatField = accessor.field;
+  field.floatValue = accessor.value;
+  return field;
+}
+
+//##################################################################################################
+constexpr MaterialField colorField_lt(const char* section,
+                                      const char* name,
+                                      float scaleMax,
+                                      const Accessor_lt<glm::vec3>& color,
+                                      const Accessor_lt<float>& scale)
+{
+  MaterialField field{section, name, MaterialFieldType::Color};
+  field.max = scaleMax;
+  field.mapping = MaterialFieldMapping::Quadratic;
+  field.vec3Field = color.field;
+  field.vec3Value = color.value;
+  field.floatField = scale.field;
+  field.floatValue = scale.value;
+  return field;
+}
+
+//##################################################################################################
+constexpr MaterialField boolField_lt(const char* section, const char* name, const Accessor_lt<bool>& accessor)
+{
+  MaterialField field{section, name, MaterialFieldType::Bool};
+  field.boolField = accessor.field;
+  field.boolValue = accessor.value;
+  return field;
+}
+
+//##################################################################################################
+constexpr MaterialField vec3Field_lt(const char* section, const char* name, float min, float max, const Accessor_lt<glm::vec3>& accessor)
+{
+  MaterialField field{section, name, MaterialFieldType::Vec3};
+  field.min = min;
+  field.max = max;
+  field.vec3Field = accessor.field;
+  field.vec3Value = accessor.value;
+  return field;
+}
+
+//##################################################################################################
+constexpr MaterialField choiceField_lt(const char* section,
+                                       const char* name,
+                                       std::string (*getChoice)(const Material_lt&),
+                                       void (*setChoice)(Material_lt&, const std::string&),
+                                       const std::array<const char*, 4>& choices)
+{
+  MaterialField field{section, name, MaterialFieldType::Choice};
+  field.getChoice = getChoice;
+  field.setChoice = setChoice;
+  field.choices = choices;
+  return field;
+}
+}
+
+//##################################################################################################
+const MaterialFields& materialFields()
+{
+  constexpr auto L = MaterialFieldMapping::Linear;
+  constexpr auto Q = MaterialFieldMapping::Quadratic;
+
+  // Constant initialized, so there is nothing to construct at startup or on first use.
+  static constexpr std::array fields
+  {
+    choiceField_lt("Shader Type", "Shader type",
+                   [](const Material_lt& m){return tp_math_utils::shaderTypeToString(legacyValue_lt<&Legacy_lt::shaderType>(m));},
+                   [](Material_lt& m, const std::string& v){m.findOrAddLegacy()->shaderType = tp_math_utils::shaderTypeFromString(v);},
+                   {"Principled", "None"}),
+
+    colorField_lt("Colors", "Albedo"    ,     4.0f, openGL_lt<&OpenGL_lt::albedo  >, openGL_lt<&OpenGL_lt::albedoScale  >),
+    colorField_lt("Colors", "Subsurface",     1.0f, legacy_lt<&Legacy_lt::sss     >, legacy_lt<&Legacy_lt::sssScale     >),
+    colorField_lt("Colors", "Emission"  , 50000.0f, legacy_lt<&Legacy_lt::emission>, legacy_lt<&Legacy_lt::emissionScale>),
+    colorField_lt("Colors", "Velvet"    ,     1.0f, legacy_lt<&Legacy_lt::velvet  >, legacy_lt<&Legacy_lt::velvetScale  >),
+
+    floatField_lt("Material Properties", "Alpha"                 , 0.0f,  1.0f, L, openGL_lt<&OpenGL_lt::alpha                >),
+    floatField_lt("Material Properties", "Roughness"             , 0.0f,  1.0f, L, openGL_lt<&OpenGL_lt::roughness            >),
+    floatField_lt("Material Properties", "Metalness"             , 0.0f,  1.0f, L, openGL_lt<&OpenGL_lt::metalness            >),
+    floatField_lt("Material Properties", "Specular"              , 0.0f,  1.0f, L, legacy_lt<&Legacy_lt::specular             >),
+    floatField_lt("Material Properties", "Transmission"          , 0.0f,  1.0f, L, openGL_lt<&OpenGL_lt::transmission         >),
+    floatField_lt("Material Properties", "Transmission roughness", 0.0f,  1.0f, L, openGL_lt<&OpenGL_lt::transmissionRoughness>),
+    floatField_lt("Material Properties", "IOR"                   , 0.0f,  6.0f, L, legacy_lt<&Legacy_lt::ior                  >),
+    floatField_lt("Material Properties", "Sheen"                 , 0.0f,  1.0f, L, legacy_lt<&Legacy_lt::sheen                >),
+    floatField_lt("Material Properties", "Sheen tint"            , 0.0f,  1.0f, L, legacy_lt<&Legacy_lt::sheenTint            >),
+    floatField_lt("Material Properties", "Clear coat"            , 0.0f,  1.0f, L, legacy_lt<&Legacy_lt::clearCoat            >),
+    floatField_lt("Material Properties", "Clear coat roughness"  , 0.0f,  1.0f, L, legacy_lt<&Legacy_lt::clearCoatRoughness   >),
+    floatField_lt("Material Properties", "Iridescent factor"     , 0.0f,  1.0f, L, legacy_lt<&Legacy_lt::iridescentFactor     >),
+    floatField_lt("Material Properties", "Iridescent offset"     , 0.0f,  1.0f, L, legacy_lt<&Legacy_lt::iridescentOffset     >),
+    floatField_lt("Material Properties", "Iridescent frequency"  , 0.0f, 20.0f, Q, legacy_lt<&Legacy_lt::iridescentFrequency  >),
+    floatField_lt("Material Properties", "Normal strength"       , 0.1f, 10.0f, Q, legacy_lt<&Legacy_lt::normalStrength       >),
+    vec3Field_lt ("Material Properties", "Subsurface radius"     , 0.0f, 100.0f,   legacy_lt<&Legacy_lt::sssRadius            >),
+
+    choiceField_lt("Material Properties", "Subsurface method",
+                   [](const Material_lt& m){return tp_math_utils::sssMethodToString(legacyValue_lt<&Legacy_lt::sssMethod>(m));},
+                   [](Material_lt& m, const std::string& v){m.findOrAddLegacy()->sssMethod = tp_math_utils::sssMethodFromString(v);},
+                   {"ChristensenBurley", "RandomWalk", "RandomWalkFixedRadius"}),
+
+    floatField_lt("Albedo Color Modification", "Albedo brightness", -50.0f, 50.0f, L, openGL_lt<&OpenGL_lt::albedoBrightness>),
+    floatField_lt("Albedo Color Modification", "Albedo contrast"  , -50.0f, 50.0f, L, openGL_lt<&OpenGL_lt::albedoContrast  >),
+    floatField_lt("Albedo Color Modification", "Albedo gamma"     ,   0.0f, 50.0f, L, openGL_lt<&OpenGL_lt::albedoGamma     >),
+    floatField_lt("Albedo Color Modification", "Albedo hue shift" ,   0.0f,  1.0f, L, openGL_lt<&OpenGL_lt::albedoHue       >),
+    floatField_lt("Albedo Color Modification", "Albedo saturation",   0.0f, 10.0f, L, openGL_lt<&OpenGL_lt::albedoSaturation>),
+    floatField_lt("Albedo Color Modification", "Albedo value"     ,   0.0f, 10.0f, L, openGL_lt<&OpenGL_lt::albedoValue     >),
+    floatField_lt("Albedo Color Modification", "Albedo factor"    ,   0.0f,  1.0f, L, openGL_lt<&OpenGL_lt::albedoFactor    >),
+
+    floatField_lt("Displacement", "Height scale"   , 0.0f, 1.0f, L, legacy_lt<&Legacy_lt::heightScale   >),
+    floatField_lt("Displacement", "Height midlevel", 0.0f, 1.0f, L, legacy_lt<&Legacy_lt::heightMidlevel>),
+
+    floatField_lt("Texture Transformation", "Skew U"     ,  -70.00f,  70.0f, L, uv_lt<&UV_lt::skewUV     , 0>),
+    floatField_lt("Texture Transformation", "Skew V"     ,  -70.00f,  70.0f, L, uv_lt<&UV_lt::skewUV     , 1>),
+    floatField_lt("Texture Transformation", "Scale U"    ,    0.01f,  10.0f, Q, uv_lt<&UV_lt::scaleUV    , 0>),
+    floatField_lt("Texture Transformation", "Scale V"    ,    0.01f,  10.0f, Q, uv_lt<&UV_lt::scaleUV    , 1>),
+    floatField_lt("Texture Transformation", "Translate U",    0.00f,   5.0f, L, uv_lt<&UV_lt::translateUV, 0>),
+    floatField_lt("Texture Transformation", "Translate V",    0.00f,   5.0f, L, uv_lt<&UV_lt::translateUV, 1>),
+    floatField_lt("Texture Transformation", "Rotate UV"  , -180.00f, 180.0f, L, uv_lt<&UV_lt::rotateUV      >),
+
+    floatField_lt("OpenGL Shading Calculation", "Use ambient"    , 0.0f, 1.0f, L, openGL_lt<&OpenGL_lt::useAmbient    >),
+    floatField_lt("OpenGL Shading Calculation", "Use diffuse"    , 0.0f, 1.0f, L, openGL_lt<&OpenGL_lt::useDiffuse    >),
+    floatField_lt("OpenGL Shading Calculation", "Use N dot L"    , 0.0f, 1.0f, L, openGL_lt<&OpenGL_lt::useNdotL      >),
+    floatField_lt("OpenGL Shading Calculation", "Use attenuation", 0.0f, 1.0f, L, openGL_lt<&OpenGL_lt::useAttenuation>),
+    floatField_lt("OpenGL Shading Calculation", "Use shadow"     , 0.0f, 1.0f, L, openGL_lt<&OpenGL_lt::useShadow     >),
+    floatField_lt("OpenGL Shading Calculation", "Light mask"     , 0.0f, 1.0f, L, openGL_lt<&OpenGL_lt::useLightMask  >),
+    floatField_lt("OpenGL Shading Calculation", "Use reflection" , 0.0f, 1.0f, L, openGL_lt<&OpenGL_lt::useReflection >),
+
+    boolField_lt("Ray Visibility", "Camera"        , legacy_lt<&Legacy_lt::rayVisibilityCamera       >),
+    boolField_lt("Ray Visibility", "Diffuse"       , legacy_lt<&Legacy_lt::rayVisibilityDiffuse      >),
+    boolField_lt("Ray Visibility", "Glossy"        , legacy_lt<&Legacy_lt::rayVisibilityGlossy       >),
+    boolField_lt("Ray Visibility", "Transmission"  , legacy_lt<&Legacy_lt::rayVisibilityTransmission >),
+    boolField_lt("Ray Visibility", "Volume scatter", legacy_lt<&Legacy_lt::rayVisibilityScatter      >),
+    boolField_lt("Ray Visibility", "Shadow"        , legacy_lt<&Legacy_lt::rayVisibilityShadow       >),
+    boolField_lt("Ray Visibility", "Shadow catcher", openGL_lt<&OpenGL_lt::rayVisibilityShadowCatcher>)
+  };
+
+  static_assert(fields.size() == materialFieldCount, "Update materialFieldCount to match the table.");
+  return fields;
+}
+
+//##################################################################################################
+MaterialFieldValue materialFieldValue(const tp_math_utils::Material& material, size_t field)
+{
+  const auto& f = materialFields().at(field);
+
+  MaterialFieldValue value;
+  switch(f.type)
+  {
+    case MaterialFieldType::Float:
+    value.f = f.floatValue(material);
+    break;
+
+    case MaterialFieldType::Color:
+    value.f = f.floatValue(material);
+    value.v = f.vec3Value(material);
+    break;
+
+    case MaterialFieldType::Bool:
+    value.b = f.boolValue(material);
+    break;
+
+    case MaterialFieldType::Vec3:
+    value.v = f.vec3Value(material);
+    break;
+
+    case MaterialFieldType::Choice:
+    value.s = f.getChoice(material);
+    break;
+  }
+
+  return value;
+}
+
+//##################################################################################################
+void setMaterialFieldValue(tp_math_utils::Material& material, size_t field, const MaterialFieldValue& value)
+{
+  const auto& f = materialFields().at(field);
+
+  switch(f.type)
+  {
+    case MaterialFieldType::Float:
+    *f.floatField(material) = value.f;
+    break;
+
+    case MaterialFieldType::Color:
+    *f.floatField(material) = value.f;
+    *f.vec3Field(material) = value.v;
+    break;
+
+    case MaterialFieldType::Bool:
+    *f.boolField(material) = value.b;
+    break;
+
+    case MaterialFieldType::Vec3:
+    *f.vec3Field(material) = value.v;
+    break;
+
+    case MaterialFieldType::Choice:
+    f.setChoice(material, value.s);
+    break;
+  }
+}
+
+//##################################################################################################
+std::string materialTexture(const tp_math_utils::Material& material, const std::string& type)
+{
+  std::string result;
+  auto view = [&](const auto& t, const auto& value, const auto&)
+  {
+    if(std::string(t) == type)
+      result = value.toString();
+  };
+  viewOpenGL_lt(material, [&](const OpenGL_lt& openGL){openGL.viewTypedTextures(view);});
+  viewLegacy_lt(material, [&](const Legacy_lt& legacy){legacy.viewTypedTextures(view);});
+  return result;
+}
+
+//##################################################################################################
+void setMaterialTexture(tp_math_utils::Material& material, const std::string& type, const std::string& name)
+{
+  auto update = [&](const auto& t, auto& value, const auto&)
+  {
+    if(std::string(t) == type)
+      value = name;
+  };
+  material.findOrAddOpenGL()->updateTypedTextures(update);
+  material.findOrAddLegacy()->updateTypedTextures(update);
+}
+
+//##################################################################################################
+void viewMaterialTextureTypes(const tp_math_utils::Material& material,
+                              const std::function<void(const std::string& type, const std::string& pretty)>& closure)
+{
+  auto view = [&](const auto& type, const auto&, const auto& pretty)
+  {
+    closure(type, pretty);
+  };
+  viewOpenGL_lt(material, [&](const OpenGL_lt& openGL){openGL.viewTypedTextures(view);});
+  viewLegacy_lt(material, [&](const Legacy_lt& legacy){legacy.viewTypedTextures(view);});
+}
+
+//##################################################################################################
+std::string materialBlendFile(const tp_math_utils::Material& material)
+{
+  std::string subPath;
+  material.viewExternal("blend", [&](const tp_math_utils::ExternalMaterial& externalMaterial)
+  {
+    subPath = externalMaterial.subPath.toString();
+  });
+  return subPath;
+}
+
+//##################################################################################################
+void setMaterialBlendFile(tp_math_utils::Material& material, const std::string& subPath)
+{
+  tp_utils::StringID id = subPath;
+  if(id.isValid())
+    material.findOrAddExternal("blend")->subPath = id;
+  else
+    material.removeExternal("blend");
+}
+
+}
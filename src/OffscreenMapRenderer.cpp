@@ -0,0 +1,398 @@
+#include "tp_qt_maps_widget/OffscreenMapRenderer.h"
+#include "tp_qt_maps_widget/HostedMap.h"
+#include "tp_qt_maps_widget/ConvertEvents.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QKeyEvent>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+struct OffscreenMapRenderer::Private
+{
+  TP_REF_COUNT_OBJECTS("tp_qt_maps_widget::OffscreenMapRenderer::Private");
+  TP_NONCOPYABLE(Private);
+
+  OffscreenMapRenderer* q;
+
+  int width;
+  int height;
+  QOpenGLContext* shareContext;
+
+  QOffscreenSurface* surface{nullptr};
+  QOpenGLContext* context{nullptr};
+  std::vector<std::unique_ptr<QOpenGLFramebufferObject>> fbos;
+  size_t bufferCount{1};
+  size_t currentBuffer{0};
+
+  HostedMap* map{nullptr};
+
+  double timeMS{0.0};
+
+  //################################################################################################
+  Private(OffscreenMapRenderer* q_, int width_, int height_, QOpenGLContext* shareContext_):
+    q(q_),
+    width(std::max(1, width_)),
+    height(std::max(1, height_)),
+    shareContext(shareContext_)
+  {
+
+  }
+
+  //################################################################################################
+  QOpenGLFramebufferObject* fbo() const
+  {
+    return (currentBuffer<fbos.size())?fbos.at(currentBuffer).get():nullptr;
+  }
+
+  //################################################################################################
+  void makeCurrent()
+  {
+    context->makeCurrent(surface);
+    if(auto f=fbo(); f)
+      f->bind();
+  }
+
+  //################################################################################################
+  void createFBOs()
+  {
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+
+    fbos.clear();
+    for(size_t i=0; i<bufferCount; i++)
+      fbos.push_back(std::make_unique<QOpenGLFramebufferObject>(width, height, format));
+  }
+};
+
+//##################################################################################################
+OffscreenMapRenderer::OffscreenMapRenderer(int width, int height, QOpenGLContext* shareContext, QObject* parent):
+  QObject(parent),
+  d(new Private(this, width, height, shareContext))
+{
+  d->surface = new QOffscreenSurface();
+  d->surface->setFormat(QSurfaceFormat::defaultFormat());
+  d->surface->create();
+}
+
+//##################################################################################################
+OffscreenMapRenderer::~OffscreenMapRenderer()
+{
+  release();
+  delete d->surface;
+  delete d;
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::setShareContext(QOpenGLContext* shareContext)
+{
+  d->shareContext = shareContext;
+}
+
+//##################################################################################################
+bool OffscreenMapRenderer::initialize()
+{
+  if(d->context)
+    return true;
+
+  d->context = new QOpenGLContext();
+  d->context->setFormat(QSurfaceFormat::defaultFormat());
+  if(d->shareContext)
+    d->context->setShareContext(d->shareContext);
+
+  if(!d->context->create() || !d->context->makeCurrent(d->surface))
+  {
+    tpWarning() << "OffscreenMapRenderer failed to create an OpenGL context.";
+    delete d->context;
+    d->context = nullptr;
+    return false;
+  }
+
+  d->createFBOs();
+  d->fbo()->bind();
+
+  d->map = new HostedMap();
+  d->map->makeCurrentCallback = [&]{d->makeCurrent();};
+  d->map->repaintCallback = [&]{Q_EMIT updateRequested();};
+  d->map->setWriteAlpha(true);
+  d->map->initializeGL();
+  d->map->resizeGL(d->width, d->height);
+  d->map->setVisible(true);
+
+  return true;
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::release()
+{
+  if(!d->context)
+    return;
+
+  d->makeCurrent();
+  d->map->clearLayers();
+  delete d->map;
+  d->map = nullptr;
+  d->fbos.clear();
+  d->context->doneCurrent();
+  delete d->context;
+  d->context = nullptr;
+}
+
+//##################################################################################################
+bool OffscreenMapRenderer::isValid() const
+{
+  return d->map;
+}
+
+//##################################################################################################
+tp_maps::Map* OffscreenMapRenderer::map()
+{
+  return d->map;
+}
+
+//##################################################################################################
+QOpenGLContext* OffscreenMapRenderer::context() const
+{
+  return d->context;
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::makeCurrent()
+{
+  if(d->context)
+    d->makeCurrent();
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::doneCurrent()
+{
+  if(d->context)
+    d->context->doneCurrent();
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::setVisible(bool visible)
+{
+  if(d->map)
+    d->map->setVisible(visible);
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::resize(int width, int height)
+{
+  width = std::max(1, width);
+  height = std::max(1, height);
+
+  if(width == d->width && height == d->height)
+    return;
+
+  d->width = width;
+  d->height = height;
+
+  if(!d->map)
+    return;
+
+  d->context->makeCurrent(d->surface);
+  d->createFBOs();
+  d->fbo()->bind();
+  d->map->resizeGL(width, height);
+}
+
+//##################################################################################################
+int OffscreenMapRenderer::width() const
+{
+  return d->width;
+}
+
+//##################################################################################################
+int OffscreenMapRenderer::height() const
+{
+  return d->height;
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::setTime(double timeMS)
+{
+  d->timeMS = timeMS;
+}
+
+//##################################################################################################
+double OffscreenMapRenderer::time() const
+{
+  return d->timeMS;
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::stepFrame(double deltaMS)
+{
+  d->timeMS += deltaMS;
+
+  if(!d->map)
+    return;
+
+  processCallAsync();
+  d->map->animate(d->timeMS);
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::processCallAsync()
+{
+  if(!d->map)
+    return;
+
+  // Drain is time limited so loop until everything posted so far has been processed. Callbacks
+  // posted while draining are left for the next frame, otherwise one that posts itself again
+  // would never let this return.
+  auto& queue = d->map->callAsyncQueue;
+  for(size_t remaining=queue.stats().queueDepth; remaining;)
+  {
+    size_t processed = queue.stats().processed;
+    bool limited = queue.drain(remaining);
+    remaining -= std::min(remaining, queue.stats().processed - processed);
+    if(!limited)
+      break;
+  }
+}
+
+//##################################################################################################
+bool OffscreenMapRenderer::needsRender() const
+{
+  return d->map && d->map->updateRequested;
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::render()
+{
+  if(!d->map)
+    return;
+
+  d->makeCurrent();
+  d->map->updateRequested = false;
+  d->map->paintGL();
+  d->map->setWriteAlpha(true);
+  d->context->functions()->glFlush();
+}
+
+//##################################################################################################
+QImage OffscreenMapRenderer::renderToImage()
+{
+  if(!d->map)
+    return QImage();
+
+  render();
+  return d->fbo()->toImage();
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::setBufferCount(size_t bufferCount)
+{
+  bufferCount = std::max(size_t(1), bufferCount);
+  if(bufferCount == d->bufferCount)
+    return;
+
+  d->bufferCount = bufferCount;
+  d->currentBuffer = 0;
+
+  if(!d->map)
+    return;
+
+  d->context->makeCurrent(d->surface);
+  d->createFBOs();
+  d->fbo()->bind();
+}
+
+//##################################################################################################
+size_t OffscreenMapRenderer::bufferCount() const
+{
+  return d->bufferCount;
+}
+
+//##################################################################################################
+void OffscreenMapRenderer::setCurrentBuffer(size_t currentBuffer)
+{
+  d->currentBuffer = std::min(currentBuffer, d->bufferCount-1);
+}
+
+//##################################################################################################
+size_t OffscreenMapRenderer::currentBuffer() const
+{
+  return d->currentBuffer;
+}
+
+//##################################################################################################
+uint32_t OffscreenMapRenderer::texture() const
+{
+  auto f = d->fbo();
+  return f?f->texture():0;
+}
+
+//##################################################################################################
+uint32_t OffscreenMapRenderer::texture(size_t buffer) const
+{
+  return (buffer<d->fbos.size())?d->fbos.at(buffer)->texture():0;
+}
+
+//##################################################################################################
+bool OffscreenMapRenderer::mouseEvent(const tp_maps::MouseEvent& event)
+{
+  return d->map && d->map->mouseEvent(event);
+}
+
+//##################################################################################################
+bool OffscreenMapRenderer::keyEvent(const tp_maps::KeyEvent& event)
+{
+  return d->map && d->map->keyEvent(event);
+}
+
+//##################################################################################################
+bool OffscreenMapRenderer::injectMouseEvent(QMouseEvent* event)
+{
+  tp_maps::MouseEventType type;
+  switch(event->type())
+  {
+  case QEvent::MouseButtonPress:    type = tp_maps::MouseEventType::Press;       break;
+  case QEvent::MouseButtonRelease:  type = tp_maps::MouseEventType::Release;     break;
+  case QEvent::MouseButtonDblClick: type = tp_maps::MouseEventType::DoubleClick; break;
+  case QEvent::MouseMove:           type = tp_maps::MouseEventType::Move;        break;
+  default: return false;
+  }
+
+  return mouseEvent(convertMouseEvent(type, event, 1.0));
+}
+
+//##################################################################################################
+bool OffscreenMapRenderer::injectWheelEvent(QWheelEvent* event)
+{
+  return mouseEvent(convertWheelEvent(event, 1.0));
+}
+
+//##################################################################################################
+bool OffscreenMapRenderer::injectKeyEvent(QKeyEvent* event)
+{
+  switch(event->type())
+  {
+  case QEvent::KeyPress:   return keyEvent(convertKeyEvent(tp_maps::KeyEventType::Press, event));
+  case QEvent::KeyRelease: return keyEvent(convertKeyEvent(tp_maps::KeyEventType::Release, event));
+  default: return false;
+  }
+}
+
+//##################################################################################################
+CallAsyncStats OffscreenMapRenderer::callAsyncStats() const
+{
+  return d->map?d->map->callAsyncQueue.stats():CallAsyncStats();
+}
+
+}
@@ -0,0 +1,681 @@
+#include "tp_qt_maps_widget/ProgressEventsChromeTrace.h"
+
+#include "tp_utils/DebugUtils.h"
+#include "tp_utils/JSONUtils.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <unordered_map>
+
+namespace tp_qt_maps_widget
+{
+
+namespace
+{
+using json_lt = nlohmann::json;
+
+//##################################################################################################
+struct Interval_lt
+{
+  double start{0.0};
+  double end{0.0};
+  size_t name{0};
+};
+
+//##################################################################################################
+struct Lane_lt
+{
+  std::string pid;
+  std::string tid;
+  std::vector<Interval_lt> intervals;
+  std::vector<Interval_lt> open; //!< Begin events waiting for their end, innermost last.
+};
+
+//##################################################################################################
+//! Collects intervals per thread from the stream without keeping the events themselves.
+class ChromeTraceSAX_lt : public nlohmann::json_sax<json_lt>
+{
+  enum class Field_lt
+  {
+    None,
+    TraceEvents,
+    Name,
+    Ph,
+    TS,
+    Dur,
+    PID,
+    TID,
+    Args,
+    ArgName
+  };
+
+  static constexpr size_t none = size_t(-1);
+
+  size_t depth{0};
+  size_t eventsDepth{none}; //!< Depth of the events array.
+  bool inArgs{false};
+  Field_lt field{Field_lt::None};
+
+  // The event being parsed, these are reused to avoid allocating for each event.
+  std::string name;
+  std::string ph;
+  std::string pid;
+  std::string tid;
+  std::string argName;
+  double ts{0.0};
+  double dur{0.0};
+  bool hasTS{false};
+
+public:
+  std::vector<std::string> names;
+  std::unordered_map<std::string, size_t> nameIndexes;
+  std::vector<Lane_lt> lanes;
+  std::unordered_map<std::string, size_t> laneIndexes;
+  std::unordered_map<std::string, std::string> processNames;
+  std::unordered_map<std::string, std::string> threadNames;
+  double minTime{0.0};
+  double maxTime{0.0};
+  bool hasTime{false};
+  std::string error;
+  size_t inputSize{0};      //!< Bytes of JSON, used to spot a trace that stops part way through.
+  bool unterminated{false}; //!< The trace is in array form and the input ended inside the array.
+
+  //################################################################################################
+  static std::string laneKey(const std::string& pid, const std::string& tid)
+  {
+    std::string key;
+    key.reserve(pid.size()+tid.size()+1);
+    key += pid;
+    key += '\x1f';
+    key += tid;
+    return key;
+  }
+
+  //################################################################################################
+  size_t nameIndex(const std::string& n)
+  {
+    auto [i, inserted] = nameIndexes.try_emplace(n, names.size());
+    if(inserted)
+      names.push_back(n);
+    return i->second;
+  }
+
+  //################################################################################################
+  Lane_lt& lane()
+  {
+    auto [i, inserted] = laneIndexes.try_emplace(laneKey(pid, tid), lanes.size());
+    if(inserted)
+    {
+      auto& l = lanes.emplace_back();
+      l.pid = pid;
+      l.tid = tid;
+    }
+    return lanes.at(i->second);
+  }
+
+  //################################################################################################
+  void addTime(double t)
+  {
+    minTime = hasTime?std::min(minTime, t):t;
+    maxTime = hasTime?std::max(maxTime, t):t;
+    hasTime = true;
+  }
+
+  //################################################################################################
+  //! Close begin events that never ended at the end of the trace.
+  void closeOpen()
+  {
+    for(auto& l : lanes)
+    {
+      for(auto& interval : l.open)
+      {
+        interval.end = maxTime;
+        l.intervals.push_back(interval);
+      }
+      l.open.clear();
+    }
+  }
+
+  //################################################################################################
+  void beginEvent()
+  {
+    name.clear();
+    ph.clear();
+    pid.clear();
+    tid.clear();
+    argName.clear();
+    ts = 0.0;
+    dur = 0.0;
+    hasTS = false;
+  }
+
+  //################################################################################################
+  void endEvent()
+  {
+    if(ph.size() != 1)
+      return;
+
+    switch(ph.front())
+    {
+    case 'X':
+    {
+      if(!hasTS)
+        return;
+      dur = std::max(0.0, dur);
+      lane().intervals.push_back({ts, ts+dur, nameIndex(name)});
+      addTime(ts);
+      addTime(ts+dur);
+      break;
+    }
+
+    case 'B':
+    {
+      if(!hasTS)
+        return;
+      lane().open.push_back({ts, ts, nameIndex(name)});
+      addTime(ts);
+      break;
+    }
+
+    case 'E':
+    {
+      if(!hasTS)
+        return;
+      auto& l = lane();
+      if(l.open.empty())
+        return;
+      auto interval = l.open.back();
+      l.open.pop_back();
+      interval.end = std::max(interval.start, ts);
+      l.intervals.push_back(interval);
+      addTime(ts);
+      break;
+    }
+
+    case 'M':
+    {
+      if(name == "process_name")
+        processNames[pid] = argName;
+      else if(name == "thread_name")
+        threadNames[laneKey(pid, tid)] = argName;
+      break;
+    }
+
+    default:
+      break;
+    }
+  }
+
+  //################################################################################################
+  void value(double number, const std::string& text)
+  {
+    if(depth == eventsDepth+1)
+    {
+      switch(field)
+      {
+      case Field_lt::Name: name = text;   break;
+      case Field_lt::Ph:   ph = text;     break;
+      case Field_lt::PID:  pid = text;    break;
+      case Field_lt::TID:  tid = text;    break;
+      case Field_lt::TS:   ts = number; hasTS = true; break;
+      case Field_lt::Dur:  dur = number;  break;
+      default: break;
+      }
+    }
+    else if(inArgs && depth == eventsDepth+2 && field == Field_lt::ArgName)
+      argName = text;
+  }
+
+  //################################################################################################
+  void number(double number, const std::string& text)
+  {
+    // Only ts and dur are used as numbers, ids are kept as text so that numbers and strings match.
+    if(field == Field_lt::TS || field == Field_lt::Dur)
+      value(number, std::string());
+    else
+      value(number, text);
+  }
+
+  //################################################################################################
+  bool null() override
+  {
+    return true;
+  }
+
+  //################################################################################################
+  bool boolean(bool) override
+  {
+    return true;
+  }
+
+  //################################################################################################
+  bool number_integer(number_integer_t val) override
+  {
+    number(double(val), std::to_string(val));
+    return true;
+  }
+
+  //################################################################################################
+  bool number_unsigned(number_unsigned_t val) override
+  {
+    number(double(val), std::to_string(val));
+    return true;
+  }
+
+  //################################################################################################
+  bool number_float(number_float_t val, const string_t& s) override
+  {
+    number(double(val), s);
+    return true;
+  }
+
+  //################################################################################################
+  bool string(string_t& val) override
+  {
+    if(field == Field_lt::TS || field == Field_lt::Dur)
+      value(std::strtod(val.c_str(), nullptr), val);
+    else
+      value(0.0, val);
+    return true;
+  }
+
+  //################################################################################################
+  bool binary(binary_t&) override
+  {
+    return true;
+  }
+
+  //################################################################################################
+  bool start_object(std::size_t) override
+  {
+    depth++;
+    if(depth == eventsDepth+1)
+      beginEvent();
+    else if(depth == eventsDepth+2 && field == Field_lt::Args)
+      inArgs = true;
+    return true;
+  }
+
+  //################################################################################################
+  bool end_object() override
+  {
+    if(depth == eventsDepth+1)
+      endEvent();
+    else if(depth == eventsDepth+2)
+      inArgs = false;
+    depth--;
+    return true;
+  }
+
+  //################################################################################################
+  bool start_array(std::size_t) override
+  {
+    if(eventsDepth == none && (depth == 0 || (depth == 1 && field == Field_lt::TraceEvents)))
+      eventsDepth = depth+1;
+    depth++;
+    return true;
+  }
+
+  //################################################################################################
+  bool end_array() override
+  {
+    if(depth == eventsDepth)
+      eventsDepth = none;
+    depth--;
+    return true;
+  }
+
+  //################################################################################################
+  bool key(string_t& val) override
+  {
+    field = Field_lt::None;
+
+    if(depth == 1 && eventsDepth == none)
+    {
+      if(val == "traceEvents")
+        field = Field_lt::TraceEvents;
+    }
+    else if(depth == eventsDepth+1)
+    {
+      if(val == "name")      field = Field_lt::Name;
+      else if(val == "ph")   field = Field_lt::Ph;
+      else if(val == "ts")   field = Field_lt::TS;
+      else if(val == "dur")  field = Field_lt::Dur;
+      else if(val == "pid")  field = Field_lt::PID;
+      else if(val == "tid")  field = Field_lt::TID;
+      else if(val == "args") field = Field_lt::Args;
+    }
+    else if(inArgs && depth == eventsDepth+2)
+    {
+      if(val == "name")
+        field = Field_lt::ArgName;
+    }
+
+    return true;
+  }
+
+  //################################################################################################
+  bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override
+  {
+    // The array form may stop without the closing ], as it does when written by a session that
+    // crashed or was streamed, so running out of input inside the array keeps what was read.
+    unterminated = eventsDepth == 1 && position >= inputSize;
+
+    error = "Chrome trace parse error at byte " + std::to_string(position) + ": " + ex.what();
+    return false;
+  }
+};
+
+//##################################################################################################
+//! Give each name a stable color from a small palette.
+void setColor_lt(decltype(tp_utils::ProgressEvent::color)& color, const std::string& name)
+{
+  static const uint8_t palette[][3] =
+  {
+    { 78, 121, 167},
+    {242, 142,  43},
+    {225,  87,  89},
+    {118, 183, 178},
+    { 89, 161,  79},
+    {237, 201,  72},
+    {176, 122, 161},
+    {255, 157, 167},
+    {156, 117,  95},
+    {186, 176, 172}
+  };
+
+  const auto& p = palette[std::hash<std::string>()(name) % (sizeof(palette)/sizeof(palette[0]))];
+  color.r = p[0];
+  color.g = p[1];
+  color.b = p[2];
+  color.a = 255;
+}
+
+//##################################################################################################
+void appendNumber_lt(std::string& out, double value)
+{
+  if(double i; std::modf(value, &i) == 0.0 && std::fabs(value)<9.0e15)
+    out += std::to_string(int64_t(value));
+  else
+    out += json_lt(value).dump();
+}
+}
+
+//##################################################################################################
+bool parseChromeTrace(const char* begin,
+                      const char* end,
+                      std::vector<tp_utils::ProgressEvent>& progressEvents,
+                      double microsecondsPerUnit)
+{
+  progressEvents.clear();
+
+  ChromeTraceSAX_lt sax;
+  sax.inputSize = size_t(end-begin);
+  if(!json_lt::sax_parse(begin, end, &sax) && !sax.unterminated)
+  {
+    tpWarning() << sax.error;
+    return false;
+  }
+
+  sax.closeOpen();
+
+  if(sax.lanes.empty())
+    return true;
+
+  auto toUnits = [&](double us)
+  {
+    return int64_t(std::llround((us-sax.minTime) / microsecondsPerUnit));
+  };
+
+  size_t eventCount = 1;
+  for(const auto& lane : sax.lanes)
+    eventCount += lane.intervals.size() + 2;
+  progressEvents.reserve(eventCount);
+
+  auto addEvent = [&](int64_t parentId, const std::string& name, int64_t start, int64_t end) -> tp_utils::ProgressEvent&
+  {
+    auto& event = progressEvents.emplace_back();
+    event.id = int64_t(progressEvents.size());
+    event.parentId = parentId;
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    event.active = false;
+    setColor_lt(event.color, name);
+    return event;
+  };
+
+  int64_t rootId = addEvent(0, "Trace", 0, toUnits(sax.maxTime)).id;
+
+  // Group the threads by process in the order that they first appear.
+  std::vector<std::string> pids;
+  std::unordered_map<std::string, std::vector<size_t>> pidLanes;
+  for(size_t l=0; l<sax.lanes.size(); l++)
+  {
+    auto& lanes = pidLanes[sax.lanes.at(l).pid];
+    if(lanes.empty())
+      pids.push_back(sax.lanes.at(l).pid);
+    lanes.push_back(l);
+  }
+
+  std::vector<std::pair<double, int64_t>> stack;
+  for(const auto& pid : pids)
+  {
+    auto processName = sax.processNames.find(pid);
+    size_t processIndex = progressEvents.size();
+    int64_t processId = addEvent(rootId, (processName!=sax.processNames.end())?processName->second:("Process " + pid), 0, 0).id;
+    double processStart = sax.maxTime;
+    double processEnd = sax.minTime;
+
+    for(auto l : pidLanes[pid])
+    {
+      auto& lane = sax.lanes.at(l);
+      if(lane.intervals.empty())
+        continue;
+
+      auto threadName = sax.threadNames.find(ChromeTraceSAX_lt::laneKey(lane.pid, lane.tid));
+      size_t threadIndex = progressEvents.size();
+      int64_t threadId = addEvent(processId, (threadName!=sax.threadNames.end())?threadName->second:("Thread " + lane.tid), 0, 0).id;
+
+      // Sort outer events first, then nest each event under the innermost one still open.
+      std::sort(lane.intervals.begin(), lane.intervals.end(), [](const auto& a, const auto& b)
+      {
+        return (a.start!=b.start)?(a.start<b.start):(a.end>b.end);
+      });
+
+      double threadStart = lane.intervals.front().start;
+      double threadEnd = threadStart;
+
+      stack.clear();
+      for(const auto& interval : lane.intervals)
+      {
+        while(!stack.empty() && stack.back().first<=interval.start && stack.back().first<interval.end)
+          stack.pop_back();
+
+        int64_t parentId = stack.empty()?threadId:stack.back().second;
+        int64_t id = addEvent(parentId, sax.names.at(interval.name), toUnits(interval.start), toUnits(interval.end)).id;
+        stack.emplace_back(interval.end, id);
+        threadEnd = std::max(threadEnd, interval.end);
+      }
+
+      progressEvents.at(threadIndex).start = toUnits(threadStart);
+      progressEvents.at(threadIndex).end = toUnits(threadEnd);
+      processStart = std::min(processStart, threadStart);
+      processEnd = std::max(processEnd, threadEnd);
+    }
+
+    progressEvents.at(processIndex).start = toUnits(std::min(processStart, processEnd));
+    progressEvents.at(processIndex).end = toUnits(processEnd);
+  }
+
+  return true;
+}
+
+//##################################################################################################
+bool readChromeTrace(const std::string& path,
+                     std::vector<tp_utils::ProgressEvent>& progressEvents,
+                     double microsecondsPerUnit)
+{
+  QFile file(QString::fromStdString(path));
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    tpWarning() << "Failed to open Chrome trace: " << path;
+    return false;
+  }
+
+  if(file.size()<1)
+  {
+    tpWarning() << "Chrome trace is empty: " << path;
+    return false;
+  }
+
+  // Map the file so that large traces are paged in by the OS rather than copied into memory.
+  if(auto data = file.map(0, file.size()); data)
+  {
+    auto begin = reinterpret_cast<const char*>(data);
+    bool ok = parseChromeTrace(begin, begin+file.size(), progressEvents, microsecondsPerUnit);
+    file.unmap(data);
+    return ok;
+  }
+
+  QByteArray data = file.readAll();
+  return parseChromeTrace(data.constData(), data.constData()+data.size(), progressEvents, microsecondsPerUnit);
+}
+
+//##################################################################################################
+bool writeChromeTrace(const std::string& path,
+                      const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                      double microsecondsPerUnit)
+{
+  QFile file(QString::fromStdString(path));
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    tpWarning() << "Failed to open Chrome trace for writing: " << path;
+    return false;
+  }
+
+  constexpr size_t none = size_t(-1);
+  size_t n = progressEvents.size();
+
+  // Children as linked lists through index arrays, sorted by start below.
+  std::vector<size_t> children;
+  std::vector<size_t> childOffsets(n+1, 0);
+  std::vector<size_t> parents(n, none);
+  {
+    using ID = decltype(tp_utils::ProgressEvent::id);
+    std::unordered_map<ID, size_t> indexes;
+    indexes.reserve(n);
+    for(size_t i=0; i<n; i++)
+      indexes.emplace(progressEvents.at(i).id, i);
+
+    for(size_t i=0; i<n; i++)
+      if(auto p=indexes.find(progressEvents.at(i).parentId); p!=indexes.end() && p->second!=i)
+        parents.at(i) = p->second;
+
+    for(size_t i=0; i<n; i++)
+      if(parents.at(i) != none)
+        childOffsets.at(parents.at(i)+1)++;
+    for(size_t i=0; i<n; i++)
+      childOffsets.at(i+1) += childOffsets.at(i);
+
+    children.resize(childOffsets.back());
+    auto next = childOffsets;
+    for(size_t i=0; i<n; i++)
+      if(parents.at(i) != none)
+        children.at(next.at(parents.at(i))++) = i;
+  }
+
+  auto byStart = [&](size_t a, size_t b){return progressEvents.at(a).start<progressEvents.at(b).start;};
+  for(size_t i=0; i<n; i++)
+    std::stable_sort(children.begin()+ptrdiff_t(childOffsets.at(i)), children.begin()+ptrdiff_t(childOffsets.at(i+1)), byStart);
+
+  // Children share their parent's thread until one overlaps an earlier sibling.
+  std::vector<int64_t> tids(n, 0);
+  std::vector<bool> visited(n, false);
+  int64_t nextTid = 1;
+  std::vector<size_t> stack;
+  for(size_t r=0; r<n; r++)
+  {
+    if(parents.at(r) != none && !visited.at(parents.at(r)))
+      continue;
+    if(visited.at(r))
+      continue;
+
+    tids.at(r) = nextTid++;
+    stack.push_back(r);
+    while(!stack.empty())
+    {
+      size_t i = stack.back();
+      stack.pop_back();
+      if(visited.at(i))
+        continue;
+      visited.at(i) = true;
+
+      const auto& parent = progressEvents.at(i);
+      int64_t laneEnd = parent.start;
+      for(size_t c=childOffsets.at(i); c<childOffsets.at(i+1); c++)
+      {
+        size_t child = children.at(c);
+        const auto& event = progressEvents.at(child);
+        if(event.start>=laneEnd)
+        {
+          tids.at(child) = tids.at(i);
+          laneEnd = event.active?std::numeric_limits<int64_t>::max():event.end;
+        }
+        else
+          tids.at(child) = nextTid++;
+        stack.push_back(child);
+      }
+    }
+  }
+
+  std::string buffer;
+  buffer.reserve(1<<20);
+  buffer += "{\"traceEvents\":[\n";
+
+  bool first=true;
+  for(size_t i=0; i<n; i++)
+  {
+    const auto& event = progressEvents.at(i);
+
+    if(!first)
+      buffer += ",\n";
+    first = false;
+
+    buffer += "{\"name\":";
+    buffer += json_lt(event.name).dump(-1, ' ', false, json_lt::error_handler_t::replace);
+    buffer += event.active?",\"ph\":\"B\",\"ts\":":",\"ph\":\"X\",\"ts\":";
+    appendNumber_lt(buffer, double(event.start)*microsecondsPerUnit);
+    if(!event.active)
+    {
+      buffer += ",\"dur\":";
+      appendNumber_lt(buffer, double(event.end-event.start)*microsecondsPerUnit);
+    }
+    buffer += ",\"pid\":1,\"tid\":";
+    buffer += std::to_string(tids.at(i));
+    buffer += '}';
+
+    if(buffer.size()>=(1<<20))
+    {
+      file.write(buffer.data(), qint64(buffer.size()));
+      buffer.clear();
+    }
+  }
+
+  buffer += "\n],\"displayTimeUnit\":\"ms\"}\n";
+  file.write(buffer.data(), qint64(buffer.size()));
+
+  if(file.error() != QFileDevice::NoError)
+  {
+    tpWarning() << "Failed to write Chrome trace: " << path;
+    return false;
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,105 @@
+#include "tp_qt_maps_widget/ProgressEventsCriticalPath.h"
+
+#include <algorithm>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+std::vector<size_t> progressEventsCriticalPath(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                               const ProgressEventsLayout& layout,
+                                               size_t position)
+{
+  std::vector<size_t> path;
+  if(position>=layout.order.size())
+    return path;
+
+  // The subtree is a contiguous run of the depth first order.
+  size_t first = position;
+  size_t last = first+1;
+  size_t rootDepth = layout.depths.at(first);
+  while(last<layout.order.size() && layout.depths.at(last)>rootDepth)
+    last++;
+  size_t n = last-first;
+
+  auto eventAt = [&](size_t i) -> const tp_utils::ProgressEvent& {return progressEvents.at(layout.order.at(first+i));};
+  auto endAt = [&](size_t i){return layout.end(eventAt(i));};
+
+  // Children of each bar, sorted by end.
+  std::vector<size_t> offsets(n+1, 0);
+  std::vector<size_t> children;
+  {
+    // Every bar after the first has its parent inside the subtree.
+    auto parentOf = [&](size_t i){return layout.parents.at(first+i)-first;};
+
+    for(size_t i=1; i<n; i++)
+      offsets.at(parentOf(i)+1)++;
+
+    for(size_t i=0; i<n; i++)
+      offsets.at(i+1) += offsets.at(i);
+
+    children.resize(offsets.back());
+    auto next = offsets;
+    for(size_t i=1; i<n; i++)
+      children.at(next.at(parentOf(i))++) = i;
+
+    for(size_t i=0; i<n; i++)
+      std::sort(children.begin()+ptrdiff_t(offsets.at(i)), children.begin()+ptrdiff_t(offsets.at(i+1)), [&](size_t a, size_t b)
+      {
+        return endAt(a)<endAt(b);
+      });
+  }
+
+  // Walk back from the end of each bar on the path, pushing the chosen children to be walked next.
+  std::vector<size_t> onPath;
+  std::vector<size_t> stack{0};
+  std::vector<size_t> chain;
+  while(!stack.empty())
+  {
+    size_t i = stack.back();
+    stack.pop_back();
+    onPath.push_back(i);
+
+    auto begin = children.begin()+ptrdiff_t(offsets.at(i));
+    auto end   = children.begin()+ptrdiff_t(offsets.at(i+1));
+    if(begin == end)
+      continue;
+
+    int64_t start = eventAt(i).start;
+    int64_t t = endAt(i);
+
+    chain.clear();
+    while(begin != end)
+    {
+      // The child that finished last, no later than t.
+      auto c = std::upper_bound(begin, end, t, [&](int64_t time, size_t child){return time<endAt(child);});
+      if(c == begin)
+        break;
+
+      size_t child = *(c-1);
+      chain.push_back(child);
+      end = c-1;
+
+      int64_t childStart = eventAt(child).start;
+      if(childStart<=start)
+        break;
+      t = childStart;
+    }
+
+    stack.insert(stack.end(), chain.begin(), chain.end());
+  }
+
+  path.reserve(onPath.size());
+  std::sort(onPath.begin(), onPath.end(), [&](size_t a, size_t b)
+  {
+    const auto& ea = eventAt(a);
+    const auto& eb = eventAt(b);
+    return (ea.start!=eb.start)?(ea.start<eb.start):(a<b);
+  });
+  for(auto i : onPath)
+    path.push_back(layout.order.at(first+i));
+
+  return path;
+}
+
+}
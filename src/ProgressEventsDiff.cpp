@@ -0,0 +1,180 @@
+#include "tp_qt_maps_widget/ProgressEventsDiff.h"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+namespace tp_qt_maps_widget
+{
+
+namespace
+{
+//##################################################################################################
+struct Key_lt
+{
+  size_t parent;
+  std::string_view name;
+
+  //################################################################################################
+  bool operator==(const Key_lt& other) const
+  {
+    return parent == other.parent && name == other.name;
+  }
+};
+
+//##################################################################################################
+struct KeyHash_lt
+{
+  size_t operator()(const Key_lt& key) const
+  {
+    return std::hash<std::string_view>()(key.name) ^ (std::hash<size_t>()(key.parent)*0x9e3779b97f4a7c15ull);
+  }
+};
+}
+
+//##################################################################################################
+ProgressEventsDiff diffProgressEvents(const std::vector<tp_utils::ProgressEvent>& baseline,
+                                      const ProgressEventsLayout& baselineLayout,
+                                      const std::vector<tp_utils::ProgressEvent>& candidate,
+                                      const ProgressEventsLayout& candidateLayout)
+{
+  constexpr size_t none = ProgressEventsLayout::none;
+
+  ProgressEventsDiff diff;
+  size_t nb = baselineLayout.order.size();
+  size_t nc = candidateLayout.order.size();
+
+  const auto& baselineParents = baselineLayout.parents;
+  const auto& candidateParents = candidateLayout.parents;
+
+  // Baseline children with the same parent and name are chained in order through nextSame, roots
+  // use none as their parent.
+  std::unordered_map<Key_lt, size_t, KeyHash_lt> heads;
+  heads.reserve(nb);
+  std::vector<size_t> nextSame(nb, none);
+  {
+    std::unordered_map<Key_lt, size_t, KeyHash_lt> tails;
+    tails.reserve(nb);
+    for(size_t p=0; p<nb; p++)
+    {
+      Key_lt key{baselineParents.at(p), baseline.at(baselineLayout.order.at(p)).name};
+      auto [tail, inserted] = tails.try_emplace(key, p);
+      if(inserted)
+        heads.emplace(key, p);
+      else
+      {
+        nextSame.at(tail->second) = p;
+        tail->second = p;
+      }
+    }
+  }
+
+  // Pair candidate bars in order, a child can only be paired once its parent has been.
+  std::vector<size_t> pairedBaseline(nc, none);
+  std::vector<bool> baselineUsed(nb, false);
+  for(size_t p=0; p<nc; p++)
+  {
+    size_t parent = candidateParents.at(p);
+    if(size_t bp=(parent==none)?none:pairedBaseline.at(parent); parent==none || bp!=none)
+    {
+      auto head = heads.find(Key_lt{bp, candidate.at(candidateLayout.order.at(p)).name});
+      if(head != heads.end() && head->second != none)
+      {
+        pairedBaseline.at(p) = head->second;
+        head->second = nextSame.at(head->second);
+      }
+    }
+
+    // The first roots are paired even if they are named differently, so that runs with renamed
+    // roots can still be compared. Nothing has been paired yet so the baseline root heads its chain.
+    if(p==0 && nb>0 && pairedBaseline.at(p)==none)
+    {
+      heads.find(Key_lt{none, baseline.at(baselineLayout.order.at(0)).name})->second = nextSame.at(0);
+      pairedBaseline.at(p) = 0;
+    }
+
+    if(auto bp=pairedBaseline.at(p); bp!=none)
+      baselineUsed.at(bp) = true;
+  }
+
+  diff.matches.reserve(nc+nb);
+  diff.candidateMatches.resize(nc);
+  diff.baselineMatches.assign(nb, none);
+
+  for(size_t p=0; p<nc; p++)
+  {
+    diff.candidateMatches.at(p) = diff.matches.size();
+    auto& match = diff.matches.emplace_back();
+
+    match.candidate = candidateLayout.order.at(p);
+    const auto& c = candidate.at(match.candidate);
+    match.candidateDuration = candidateLayout.end(c)-c.start;
+
+    if(auto bp=pairedBaseline.at(p); bp!=none)
+    {
+      diff.baselineMatches.at(bp) = diff.candidateMatches.at(p);
+      match.baseline = baselineLayout.order.at(bp);
+      const auto& b = baseline.at(match.baseline);
+      match.baselineDuration = baselineLayout.end(b)-b.start;
+    }
+  }
+
+  for(size_t p=0; p<nb; p++)
+  {
+    if(baselineUsed.at(p))
+      continue;
+
+    diff.baselineMatches.at(p) = diff.matches.size();
+    auto& match = diff.matches.emplace_back();
+    match.baseline = baselineLayout.order.at(p);
+    const auto& b = baseline.at(match.baseline);
+    match.baselineDuration = baselineLayout.end(b)-b.start;
+  }
+
+  return diff;
+}
+
+//##################################################################################################
+std::vector<ProgressEventsMatch> largestRegressions(const ProgressEventsDiff& diff, size_t count)
+{
+  std::vector<ProgressEventsMatch> regressions;
+  for(const auto& match : diff.matches)
+    if(match.matched() && match.candidateDuration>match.baselineDuration)
+      regressions.push_back(match);
+
+  auto gain = [](const ProgressEventsMatch& m){return m.candidateDuration-m.baselineDuration;};
+  auto byGain = [&](const auto& a, const auto& b){return gain(a)>gain(b);};
+
+  if(regressions.size()>count)
+  {
+    std::nth_element(regressions.begin(), regressions.begin()+ptrdiff_t(count), regressions.end(), byGain);
+    regressions.resize(count);
+  }
+
+  std::sort(regressions.begin(), regressions.end(), byGain);
+  return regressions;
+}
+
+//##################################################################################################
+std::string progressEventsNamePath(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                   const ProgressEventsLayout& layout,
+                                   size_t position)
+{
+  if(position>=layout.order.size())
+    return std::string();
+
+  std::vector<size_t> ancestors;
+  for(size_t p=position; p!=ProgressEventsLayout::none; p=layout.parents.at(p))
+    ancestors.push_back(p);
+
+  std::string path;
+  for(auto a=ancestors.rbegin(); a!=ancestors.rend(); ++a)
+  {
+    if(!path.empty())
+      path += '/';
+    path += progressEvents.at(layout.order.at(*a)).name;
+  }
+  return path;
+}
+
+}
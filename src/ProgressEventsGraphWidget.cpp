@@ -1,16 +1,30 @@
 #include "tp_qt_maps_widget/ProgressEventsGraphWidget.h"
 #include "tp_qt_maps_widget/MapWidget.h"
+#include "tp_qt_maps_widget/ProgressEventsLayout.h"
+#include "tp_qt_maps_widget/ProgressEventsIndex.h"
+#include "tp_qt_maps_widget/ProgressEventsLOD.h"
+#include "tp_qt_maps_widget/ProgressEventsStats.h"
+#include "tp_qt_maps_widget/ProgressEventsCriticalPath.h"
+#include "tp_qt_maps_widget/ProgressEventsDiff.h"
 
 #include "tp_maps/controllers/GraphController.h"
 #include "tp_maps/layers/LinesLayer.h"
-#include "tp_maps/PickingResult.h"
-#include "tp_maps/picking_results/LinesPickingResult.h"
 
 #include "tp_utils/TimeUtils.h"
 
 #include <QBoxLayout>
 #include <QHelpEvent>
+#include <QMouseEvent>
 #include <QToolTip>
+#include <QTimer>
+#include <QSplitter>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
 
 namespace tp_qt_maps_widget
 {
@@ -18,6 +32,50 @@ namespace tp_qt_maps_widget
 namespace
 {
 
+//! Bars are split across layers in chunks so that no single vertex buffer gets too large.
+constexpr size_t barsPerChunk_lt{16384};
+
+//! Half the height of a bar as a fraction of its row.
+constexpr float barHalfHeight_lt{0.1f};
+
+//! How far the hover outline sits outside the bar, as a fraction of a row.
+constexpr float highlightMargin_lt{0.05f};
+
+//! Columns of the statistics table.
+enum StatsColumn_lt
+{
+  NameColumn_lt,
+  CountColumn_lt,
+  TotalColumn_lt,
+  SelfColumn_lt,
+  MinColumn_lt,
+  MaxColumn_lt,
+  P95Column_lt,
+  ColumnCount_lt
+};
+
+//! Bars narrower than this many pixels can still be hit by the mouse.
+constexpr float hitTolerancePixels_lt{2.0f};
+
+//! Traces with more bars than this are drawn from the LOD pyramid rather than in chunks.
+constexpr size_t lodMinBars_lt{barsPerChunk_lt};
+
+//! When drawing from the LOD pyramid, gaps and rows smaller than this many pixels are merged.
+constexpr float lodPixels_lt{2.0f};
+
+//! Statistics are recalculated at most this often, each run copies the events for the worker.
+constexpr int statsIntervalMS_lt{500};
+
+//##################################################################################################
+//! Round up to a power of 2 so that small changes in zoom don't change the level of detail.
+int64_t roundUpPow2_lt(double value)
+{
+  int64_t result=1;
+  while(double(result)<value && result<(int64_t(1)<<62))
+    result *= 2;
+  return result;
+}
+
 //##################################################################################################
 class MapWidget_lt : public tp_qt_maps_widget::MapWidget
 {
@@ -35,199 +93,1084 @@ public:
   }
 
   //################################################################################################
-  tp_utils::CallbackCollection<void(QHelpEvent*, tp_maps::LinesPickingResult*)> linesLayerToolTipEvent;
+  tp_utils::CallbackCollection<void(QHelpEvent*, bool& handled)> toolTipEvent;
+
+  //################################################################################################
+  //! Called as the mouse moves over the widget, with nullptr when it leaves.
+  tp_utils::CallbackCollection<void(QMouseEvent*)> hoverEvent;
+
+  //################################################################################################
+  //! Called at the start of each frame, before the map is drawn.
+  tp_utils::CallbackCollection<void()> aboutToPaint;
 
 protected:
+  //################################################################################################
+  void paintGL() override
+  {
+    aboutToPaint();
+    tp_qt_maps_widget::MapWidget::paintGL();
+  }
+
   //################################################################################################
   bool event(QEvent* event) override
   {
     if(event->type() == QEvent::ToolTip)
     {
-      QHelpEvent* helpEvent = static_cast<QHelpEvent*>(event);
-
-      std::unique_ptr<tp_maps::PickingResult> pickingResult{map()->performPicking("Tool tip", {helpEvent->x(), helpEvent->y()})};
-      if(!pickingResult)
+      bool handled=false;
+      toolTipEvent(static_cast<QHelpEvent*>(event), handled);
+      if(!handled)
       {
+        QToolTip::hideText();
         event->ignore();
-        return true;
-      }
-
-      {
-        auto linesLayerPickingResult = dynamic_cast<tp_maps::LinesPickingResult*>(pickingResult.get());
-        if(linesLayerPickingResult)
-        {
-          linesLayerToolTipEvent(helpEvent, linesLayerPickingResult);
-          return true;
-        }
       }
-
-      event->ignore();
       return true;
     }
     return QWidget::event(event);
   }
+
+  //################################################################################################
+  void mouseMoveEvent(QMouseEvent* event) override
+  {
+    hoverEvent(event);
+    tp_qt_maps_widget::MapWidget::mouseMoveEvent(event);
+  }
+
+  //################################################################################################
+  void leaveEvent(QEvent* event) override
+  {
+    hoverEvent(nullptr);
+    tp_qt_maps_widget::MapWidget::leaveEvent(event);
+  }
 };
 }
 
 //##################################################################################################
 struct ProgressEventsGraphWidget::Private
 {
+  using ID = decltype(tp_utils::ProgressEvent::id);
+
+  static constexpr size_t none = ProgressEventsLayout::none;
+
+  //! When live data outgrows the displayed range the range is grown by this factor, so that most
+  //! updates only touch the chunks that changed.
+  static constexpr double headroom{1.5};
+
+  //! The part of the trace that the LOD layer currently holds blocks for.
+  struct LODWindow
+  {
+    int64_t width{0};    //!< Gaps narrower than this are merged.
+    size_t rowStride{0}; //!< Rows are merged in groups of this many.
+    int64_t t1{0};
+    int64_t t2{0};
+    size_t firstRow{0};
+    size_t lastRow{0};
+    bool valid{false};
+  };
+
+  Q* q;
+
   MapWidget_lt* mapWidget{nullptr};
   tp_maps::GraphController* graphController{nullptr};
+  QSplitter* splitter{nullptr};
+  QTableWidget* statsTable{nullptr};
 
-  std::vector<tp_maps::Layer*> layers;
+  std::vector<tp_maps::LinesLayer*> layers;
+  tp_maps::LinesLayer* highlightLayer{nullptr};
+  tp_maps::LinesLayer* lodLayer{nullptr};
+  tp_maps::LinesLayer* nameHighlightLayer{nullptr};
+  tp_maps::LinesLayer* criticalPathLayer{nullptr};
   std::vector<tp_utils::ProgressEvent> progressEvents;
+  std::unordered_map<ID, size_t> indexes;
+  ProgressEventsLayoutMode layoutMode{ProgressEventsLayoutMode::Tree};
+  ProgressEventsLayout layout;
+  ProgressEventsIndex eventIndex;
+  ProgressEventsLOD lod;
+  LODWindow lodWindow;
+  bool useLOD{false};
+
+  std::vector<size_t> activeEvents; //!< Indices of events that are still active.
+  size_t highlighted{none};         //!< Index of the event under the mouse, or none.
+
+  // The range that the bars are normalized against, this only changes when it is outgrown.
+  int64_t rangeStart{0};
+  int64_t rangeEnd{0};
+  size_t rowCapacity{0};
+
+  QTimer* liveTimer{nullptr};
+
+  // Statistics are calculated on a single worker thread, changes made while it is busy or within
+  // statsIntervalMS_lt of the last run are picked up by one more run.
+  QThreadPool statsPool;
+  QTimer* statsTimer{nullptr};
+  bool statsRunning{false};
+  bool statsPending{false};
+  std::vector<ProgressEventsNameStats> stats;
+  std::string highlightedName;
+
+  std::vector<size_t> criticalPath;
+  bool criticalPathDirty{true};
+  bool criticalPathVisible{false};
+
+  // While comparing two runs the candidate events are followed by the baseline events, and the
+  // layout pairs their rows so is built once rather than by layoutProgressEvents().
+  bool comparison{false};
+  ProgressEventsDiff diff;
+  ProgressEventsLayout comparisonLayout;
+  ProgressEventsLayout candidateLayout; //!< The candidate on its own, for the statistics and path.
+  size_t candidateCount{0};             //!< The candidate events come first in progressEvents.
+  std::vector<size_t> matchOf; //!< Index into diff.matches of each event, or none.
+
+  //################################################################################################
+  Private(Q* q_):
+    q(q_)
+  {
+    statsPool.setMaxThreadCount(1);
+  }
+
+  //################################################################################################
+  ~Private()
+  {
+    statsPool.waitForDone();
+  }
 
   //################################################################################################
-  Private()
+  float toX(int64_t time) const
   {
+    return (rangeEnd>rangeStart)?(float(time-rangeStart) / float(rangeEnd-rangeStart)):0.0f;
+  }
 
+  //################################################################################################
+  float toY(float row) const
+  {
+    return 1.0f - (row / float(std::max(size_t(1), rowCapacity)));
   }
 
   //################################################################################################
-  void updateDisplay()
+  //! Repeated ids resolve to the first event with that id, as they do in layoutProgressEvents.
+  void indexEvents(size_t first)
   {
-    tpDeleteAll(layers);
-    layers.clear();
+    for(size_t i=first; i<progressEvents.size(); i++)
+      indexes.try_emplace(progressEvents.at(i).id, i);
+  }
 
-    if(progressEvents.empty())
+  //################################################################################################
+  //! Returns true if the normalization range had to change, which means every bar moves.
+  bool updateRange(bool exact)
+  {
+    size_t rows = layout.rowCount;
+    if(exact || layout.minTime<rangeStart || layout.maxTime>rangeEnd || rows>rowCapacity || rangeEnd<=rangeStart)
+    {
+      double scale = exact?1.0:headroom;
+      rangeStart = layout.minTime;
+      rangeEnd = rangeStart + std::max(int64_t(1), int64_t(double(layout.maxTime-rangeStart)*scale));
+      rowCapacity = size_t(double(rows)*scale);
+      return true;
+    }
+    return false;
+  }
+
+  //################################################################################################
+  //! Re-layout everything and rebuild the chunks that changed.
+  void relayout(bool exact)
+  {
+    auto old = std::move(layout);
+    layout = comparison?comparisonLayout:layoutProgressEvents(progressEvents, tp_utils::currentTimeMS(), layoutMode);
+    eventIndex.build(progressEvents, layout);
+    updatePyramid(old);
+
+    activeEvents.clear();
+    for(auto i : layout.order)
+      if(progressEvents.at(i).active)
+        activeEvents.push_back(i);
+
+    size_t firstChanged = 0;
+    if(!updateRange(exact))
+    {
+      size_t n = std::min(old.order.size(), layout.order.size());
+      while(firstChanged<n && old.order.at(firstChanged) == layout.order.at(firstChanged) && old.rows.at(firstChanged) == layout.rows.at(firstChanged))
+        firstChanged++;
+    }
+
+    std::vector<bool> dirty(chunkCount(), false);
+    for(size_t c=firstChanged/barsPerChunk_lt; c<dirty.size(); c++)
+      dirty.at(c) = true;
+    markActiveChunks(dirty);
+    rebuildChunks(dirty);
+    requestStats();
+  }
+
+  //################################################################################################
+  //! Bring the LOD pyramid up to date, only rows that gained or lost events are rebuilt.
+  void updatePyramid(const ProgressEventsLayout& old)
+  {
+    bool wasLOD = useLOD;
+    useLOD = layout.order.size()>lodMinBars_lt;
+
+    if(!useLOD)
+    {
+      lod.clear();
       return;
+    }
 
-    struct TreeItem_lt
+    if(!wasLOD)
     {
-      tp_utils::ProgressEvent item;
-      std::vector<TreeItem_lt> children;
+      lod.build(progressEvents, layout);
+      return;
+    }
 
-      bool tryInsert(const tp_utils::ProgressEvent& i)
-      {
-        if(i.parentId == item.id)
-        {
-          TreeItem_lt& child = children.emplace_back();
-          child.item = i;
-          return true;
-        }
+    // A row can be moved from its old position if every event in it came from the same old row
+    // and nothing else was in that row. In Tree mode an insert shifts every row after it, so this
+    // is what stops an append from rebuilding the whole pyramid.
+    std::vector<bool> dirtyRows(layout.rowCount, false);
+    std::vector<size_t> sourceRows(layout.rowCount, none);
+    std::vector<size_t> counts(layout.rowCount, 0);
+    std::vector<size_t> oldCounts(old.rowCount, 0);
+
+    for(size_t i=0; i<progressEvents.size(); i++)
+    {
+      size_t p = layout.positions.at(i);
+      size_t o = (i<old.positions.size())?old.positions.at(i):none;
+      size_t oldRow = (o!=none)?old.rows.at(o):none;
+
+      if(oldRow!=none)
+        oldCounts.at(oldRow)++;
+
+      if(p==none)
+        continue;
+
+      size_t row = layout.rows.at(p);
+      counts.at(row)++;
+
+      auto& source = sourceRows.at(row);
+      if(oldRow==none || (source!=none && source!=oldRow))
+        dirtyRows.at(row) = true;
+      else
+        source = oldRow;
+    }
+
+    for(size_t r=0; r<layout.rowCount; r++)
+      if(auto source=sourceRows.at(r); source==none || oldCounts.at(source)!=counts.at(r))
+        dirtyRows.at(r) = true;
+
+    lod.update(progressEvents, layout, dirtyRows, sourceRows);
+  }
 
-        for(auto& child : children)
-          if(child.tryInsert(i))
-            return true;
+  //################################################################################################
+  size_t chunkCount() const
+  {
+    return (layout.order.size() + barsPerChunk_lt - 1) / barsPerChunk_lt;
+  }
+
+  //################################################################################################
+  void markActiveChunks(std::vector<bool>& dirty) const
+  {
+    for(auto i : activeEvents)
+      if(auto p=layout.positions.at(i); p!=none)
+        dirty.at(p/barsPerChunk_lt) = true;
+  }
 
+  //################################################################################################
+  //! Advance active events to now, grow the range if needed, and rebuild the affected chunks.
+  void updateActive(std::vector<bool>& dirty)
+  {
+    layout.now = tp_utils::currentTimeMS();
+
+    // Prune events that have finished, their rows in the pyramid still treat them as active.
+    std::vector<bool> finishedRows;
+    activeEvents.erase(std::remove_if(activeEvents.begin(), activeEvents.end(), [&](size_t i)
+    {
+      if(progressEvents.at(i).active)
         return false;
+
+      if(auto p=layout.positions.at(i); useLOD && p!=none)
+      {
+        finishedRows.resize(layout.rowCount, false);
+        finishedRows.at(layout.rows.at(p)) = true;
       }
+      return true;
+    }), activeEvents.end());
 
-      void flatten(std::vector<tp_utils::ProgressEvent>& progressEvents) const
+    if(!finishedRows.empty())
+      lod.update(progressEvents, layout, finishedRows);
+
+    for(auto i : activeEvents)
+      layout.maxTime = std::max(layout.maxTime, layout.end(progressEvents.at(i)));
+
+    if(updateRange(false))
+      dirty.assign(chunkCount(), true);
+    else
+      markActiveChunks(dirty);
+
+    rebuildChunks(dirty);
+
+    if(!activeEvents.empty() || !finishedRows.empty())
+      requestStats();
+  }
+
+  //################################################################################################
+  //! Regenerate the vertex data for the dirty chunks, chunks that did not change are left alone.
+  void rebuildChunks(const std::vector<bool>& dirty)
+  {
+    if(useLOD)
+    {
+      tpDeleteAll(layers);
+      layers.clear();
+      lodWindow.valid = false;
+      criticalPathDirty = true;
+      updateLOD();
+      updateHighlight();
+
+      // updateLOD redraws these when it builds a window, otherwise clear them.
+      if(!lodWindow.valid)
       {
-        progressEvents.push_back(item);
-        for(const auto& child : children)
-          child.flatten(progressEvents);
+        updateNameHighlight();
+        drawCriticalPath();
       }
-    };
+      return;
+    }
 
-    TreeItem_lt root;
-    root.item = progressEvents.front();
+    if(lodWindow.valid)
+    {
+      lodLayer->setLines({});
+      lodWindow.valid = false;
+    }
 
-    for(size_t i=1; i<progressEvents.size(); i++)
-      root.tryInsert(progressEvents.at(i));
+    size_t count = chunkCount();
+    while(layers.size()>count)
+    {
+      delete layers.back();
+      layers.pop_back();
+    }
+
+    for(size_t c=0; c<count; c++)
+    {
+      if(c<layers.size() && !dirty.at(c))
+        continue;
 
-    progressEvents.clear();
-    root.flatten(progressEvents);
+      if(c>=layers.size())
+      {
+        auto layer = new tp_maps::LinesLayer();
+        layer->setDefaultRenderPass(tp_maps::RenderPass::GUI);
+        layer->setExcludeFromPicking(false);
+        mapWidget->map()->addLayer(layer);
+        layers.push_back(layer);
+      }
 
-    int64_t min = progressEvents.front().start;
-    int64_t max = progressEvents.front().end;
+      layers.at(c)->setLines(chunkLines(c));
+    }
 
-    int64_t now = tp_utils::currentTimeMS();
+    updateHighlight();
+    updateNameHighlight();
+    updateCriticalPath();
+  }
 
-    for(auto& progressEvent : progressEvents)
+  //################################################################################################
+  //! Each bar is an outline of 4 segments, bars are batched into one Lines per color.
+  std::vector<tp_maps::Lines> chunkLines(size_t chunk) const
+  {
+    std::vector<tp_maps::Lines> lines;
+    std::unordered_map<uint32_t, size_t> colorIndex;
+
+    size_t pMax = std::min(layout.order.size(), (chunk+1)*barsPerChunk_lt);
+    for(size_t p=chunk*barsPerChunk_lt; p<pMax; p++)
+    {
+      const auto& progressEvent = progressEvents.at(layout.order.at(p));
+      auto& l = linesForColor(lines, colorIndex, progressEvent.color);
+      addBar(l, progressEvent.start, layout.end(progressEvent), float(layout.rows.at(p)), barHalfHeight_lt);
+    }
+
+    return lines;
+  }
+
+  //################################################################################################
+  //! Returns the vertices of the Lines for a color, adding one if this is the first bar that color.
+  static std::vector<glm::vec3>& linesForColor(std::vector<tp_maps::Lines>& lines,
+                                               std::unordered_map<uint32_t, size_t>& colorIndex,
+                                               const decltype(tp_utils::ProgressEvent::color)& c)
+  {
+    uint32_t key = (uint32_t(c.r)<<24) | (uint32_t(c.g)<<16) | (uint32_t(c.b)<<8) | uint32_t(c.a);
+    auto [it, inserted] = colorIndex.try_emplace(key, lines.size());
+    if(inserted)
     {
-      if(progressEvent.active)
-        progressEvent.end = now;
+      auto& line = lines.emplace_back();
+      line.mode = GL_LINES;
+      line.color = c.toFloat4<glm::vec4>();
+    }
+    return lines.at(it->second).lines;
+  }
+
+  //################################################################################################
+  //! Append the 4 segments that outline a bar.
+  void addBar(std::vector<glm::vec3>& l, int64_t start, int64_t end, float row, float halfHeight) const
+  {
+    float x1 = toX(start);
+    float x2 = toX(end);
 
-      if(progressEvent.start<min)
-        min = progressEvent.start;
+    float y1 = toY(row+halfHeight);
+    float y2 = toY(row-halfHeight);
 
-      if(progressEvent.end>max)
-        max = progressEvent.end;
+    l.emplace_back(x1, y1, 0.0f); l.emplace_back(x2, y1, 0.0f);
+    l.emplace_back(x2, y1, 0.0f); l.emplace_back(x2, y2, 0.0f);
+    l.emplace_back(x2, y2, 0.0f); l.emplace_back(x1, y2, 0.0f);
+    l.emplace_back(x1, y2, 0.0f); l.emplace_back(x1, y1, 0.0f);
+  }
+
+  //################################################################################################
+  //! Outline the hovered event, this is a separate small layer so the chunks are left alone.
+  void updateHighlight()
+  {
+    if(!highlightLayer)
+    {
+      highlightLayer = new tp_maps::LinesLayer();
+      highlightLayer->setDefaultRenderPass(tp_maps::RenderPass::GUI);
+      mapWidget->map()->addLayer(highlightLayer);
+    }
+
+    std::vector<tp_maps::Lines> lines;
+    if(highlighted != none)
+    {
+      if(auto p=layout.positions.at(highlighted); p!=none)
+      {
+        auto& line = lines.emplace_back();
+        line.mode = GL_LINES;
+        line.color = {1.0f, 1.0f, 1.0f, 1.0f};
+        const auto& progressEvent = progressEvents.at(highlighted);
+        addBar(line.lines, progressEvent.start, layout.end(progressEvent), float(layout.rows.at(p)), barHalfHeight_lt+highlightMargin_lt);
+      }
     }
 
-    if(max<=min)
+    highlightLayer->setLines(lines);
+  }
+
+  //################################################################################################
+  //! Redraw the LOD layer if the zoom level changed or the view moved outside the blocks it holds.
+  /*!
+  Blocks are generated for the visible part of the trace plus a view either side, so the number of
+  vertices depends on the size of the viewport and not on the number of events.
+  */
+  void updateLOD()
+  {
+    if(!useLOD || layout.order.empty() || rangeEnd<=rangeStart)
       return;
 
-    float range = float(max-min);
-    auto toFt = [&](size_t t)
+    auto map = mapWidget->map();
+    const auto& matrix = map->controller()->matrix(tp_maps::defaultSID());
+    float pixelRatio = float(mapWidget->devicePixelRatio());
+    float w = float(mapWidget->width())*pixelRatio;
+    float h = float(mapWidget->height())*pixelRatio;
+    if(w<1.0f || h<1.0f)
+      return;
+
+    glm::vec3 a;
+    glm::vec3 b;
+    if(!map->unProject({0.0f, 0.0f}, a, matrix) || !map->unProject({w, h}, b, matrix))
+      return;
+
+    // The visible range in time and rows.
+    double span = double(rangeEnd-rangeStart);
+    double ta = double(rangeStart) + double(std::min(a.x, b.x))*span;
+    double tb = double(rangeStart) + double(std::max(a.x, b.x))*span;
+    double ra = (1.0 - double(std::max(a.y, b.y))) * double(rowCapacity);
+    double rb = (1.0 - double(std::min(a.y, b.y))) * double(rowCapacity);
+
+    LODWindow window;
+    window.width = roundUpPow2_lt((tb-ta) / double(w) * double(lodPixels_lt));
+    window.rowStride = size_t(roundUpPow2_lt((rb-ra) / double(h) * double(lodPixels_lt)));
+
+    if(lodWindow.valid &&
+       lodWindow.width == window.width &&
+       lodWindow.rowStride == window.rowStride &&
+       double(lodWindow.t1)<=ta && double(lodWindow.t2)>=tb &&
+       double(lodWindow.firstRow)<=std::max(0.0, ra) && double(lodWindow.lastRow)>=std::min(rb, double(layout.rowCount)))
+      return;
+
+    double tw = tb-ta;
+    double rh = rb-ra;
+    window.t1 = int64_t(std::floor(ta-tw));
+    window.t2 = int64_t(std::ceil(tb+tw));
+    window.firstRow = size_t(std::clamp(std::floor(ra-rh), 0.0, double(layout.rowCount)));
+    window.lastRow = size_t(std::clamp(std::ceil(rb+rh), 0.0, double(layout.rowCount)));
+    window.valid = true;
+    lodWindow = window;
+
+    std::vector<tp_maps::Lines> lines;
+    std::unordered_map<uint32_t, size_t> colorIndex;
+
+    float halfHeight = barHalfHeight_lt + float(window.rowStride-1)*0.5f;
+    float rowOffset = float(window.rowStride-1)*0.5f;
+    lod.blocks(window.firstRow, window.lastRow, window.rowStride, window.t1, window.t2, window.width, layout, [&](size_t row, const ProgressEventsBlock& block)
+    {
+      auto& l = linesForColor(lines, colorIndex, progressEvents.at(block.event).color);
+      addBar(l, block.start, block.endAt(layout.now), float(row)+rowOffset, halfHeight);
+    });
+
+    if(!lodLayer)
+    {
+      lodLayer = new tp_maps::LinesLayer();
+      lodLayer->setDefaultRenderPass(tp_maps::RenderPass::GUI);
+      map->addLayer(lodLayer);
+    }
+
+    lodLayer->setLines(lines);
+
+    updateNameHighlight();
+    drawCriticalPath();
+  }
+
+  //################################################################################################
+  tp_utils::Callback<void()> aboutToPaint = [&]
+  {
+    updateLOD();
+  };
+
+  //################################################################################################
+  //! Calls closure with the events merged the same way as the LOD layer, for the current window.
+  void lodBlocks(const std::vector<size_t>& events, const std::function<void(size_t, const ProgressEventsBlock&)>& closure) const
+  {
+    if(!lodWindow.valid)
+      return;
+
+    const auto& window = lodWindow;
+    std::vector<std::pair<size_t, ProgressEventsBlock>> grouped;
+    for(auto i : events)
+    {
+      auto p = layout.positions.at(i);
+      if(p==none)
+        continue;
+
+      size_t row = layout.rows.at(p);
+      const auto& event = progressEvents.at(i);
+      if(row<window.firstRow || row>=window.lastRow || event.start>window.t2 || layout.end(event)<window.t1)
+        continue;
+
+      auto& [group, block] = grouped.emplace_back();
+      group = row - (row%window.rowStride);
+      block.start = event.start;
+      block.end = event.active?event.start:event.end;
+      block.longest = layout.end(event)-event.start;
+      block.count = 1;
+      block.event = i;
+      block.active = event.active;
+    }
+
+    std::sort(grouped.begin(), grouped.end(), [](const auto& a, const auto& b)
+    {
+      return (a.first!=b.first)?(a.first<b.first):(a.second.start<b.second.start);
+    });
+
+    std::vector<ProgressEventsBlock> blocks;
+    std::vector<ProgressEventsBlock> merged;
+    for(size_t g=0; g<grouped.size();)
+    {
+      size_t group = grouped.at(g).first;
+      blocks.clear();
+      for(; g<grouped.size() && grouped.at(g).first==group; g++)
+        blocks.push_back(grouped.at(g).second);
+
+      mergeProgressEventsBlocks(blocks, window.width, layout.now, merged);
+      for(const auto& block : merged)
+        closure(group, block);
+    }
+  }
+
+  //################################################################################################
+  //! Outline bars in LOD mode the way the LOD layer draws them, so the outline matches the blocks.
+  void addLODBars(std::vector<glm::vec3>& l, const std::vector<size_t>& events, float margin) const
+  {
+    float halfHeight = barHalfHeight_lt + float(lodWindow.rowStride-1)*0.5f + margin;
+    float rowOffset = float(lodWindow.rowStride-1)*0.5f;
+    lodBlocks(events, [&](size_t row, const ProgressEventsBlock& block)
+    {
+      addBar(l, block.start, block.endAt(layout.now), float(row)+rowOffset, halfHeight);
+    });
+  }
+
+  //################################################################################################
+  //! Outline every bar with the highlighted name.
+  void updateNameHighlight()
+  {
+    if(!nameHighlightLayer)
+    {
+      if(highlightedName.empty())
+        return;
+
+      nameHighlightLayer = new tp_maps::LinesLayer();
+      nameHighlightLayer->setDefaultRenderPass(tp_maps::RenderPass::GUI);
+      mapWidget->map()->addLayer(nameHighlightLayer);
+    }
+
+    std::vector<tp_maps::Lines> lines;
+    if(!highlightedName.empty())
+    {
+      auto& line = lines.emplace_back();
+      line.mode = GL_LINES;
+      line.color = {1.0f, 0.85f, 0.0f, 1.0f};
+      if(useLOD)
+      {
+        std::vector<size_t> events;
+        for(auto i : layout.order)
+          if(progressEvents.at(i).name == highlightedName)
+            events.push_back(i);
+        addLODBars(line.lines, events, highlightMargin_lt);
+      }
+      else
+      {
+        for(size_t p=0; p<layout.order.size(); p++)
+        {
+          const auto& progressEvent = progressEvents.at(layout.order.at(p));
+          if(progressEvent.name == highlightedName)
+            addBar(line.lines, progressEvent.start, layout.end(progressEvent), float(layout.rows.at(p)), barHalfHeight_lt+highlightMargin_lt);
+        }
+      }
+    }
+
+    nameHighlightLayer->setLines(lines);
+  }
+
+  //################################################################################################
+  //! Build the combined events and paired layout for comparing two runs.
+  void setComparison(const std::vector<tp_utils::ProgressEvent>& baseline,
+                     const std::vector<tp_utils::ProgressEvent>& candidate)
+  {
+    auto now = tp_utils::currentTimeMS();
+    auto baselineLayout = layoutProgressEvents(baseline, now, layoutMode);
+    candidateLayout = layoutProgressEvents(candidate, now, layoutMode);
+    diff = diffProgressEvents(baseline, baselineLayout, candidate, candidateLayout);
+
+    size_t nc = candidate.size();
+    candidateCount = nc;
+    size_t ncp = candidateLayout.order.size();
+
+    // Shift the baseline so that both roots start together, and its ids so they don't collide.
+    int64_t shift = (candidate.empty() || baseline.empty())?0:(candidate.front().start-baseline.front().start);
+    ID idOffset = 0;
+    if(!candidate.empty() && !baseline.empty())
+    {
+      ID maxID = candidate.front().id;
+      for(const auto& event : candidate)
+        maxID = std::max(maxID, event.id);
+      ID minID = baseline.front().id;
+      for(const auto& event : baseline)
+        minID = std::min(minID, event.id);
+      idOffset = maxID - minID + 1;
+    }
+
+    progressEvents = candidate;
+    progressEvents.reserve(nc+baseline.size());
+    for(const auto& event : baseline)
+    {
+      auto& e = progressEvents.emplace_back(event);
+      e.id += idOffset;
+      e.parentId += idOffset;
+      e.start += shift;
+      e.end += shift;
+    }
+
+    // Keep the baseline roots as roots, their shifted parent ids could land on a candidate event.
+    for(size_t p=0; p<baselineLayout.order.size(); p++)
+      if(baselineLayout.depths.at(p)==0)
+        progressEvents.at(nc+baselineLayout.order.at(p)).parentId = baseline.at(baselineLayout.order.at(p)).parentId;
+
+    // Color the candidate by slowdown, red is slower, green is faster, and blue is new.
+    auto setColor = [](auto& color, uint8_t r, uint8_t g, uint8_t b)
     {
-      return float(t-min) / range;
+      color.r = r;
+      color.g = g;
+      color.b = b;
+      color.a = 255;
     };
 
-    for(size_t i=0; i<progressEvents.size(); i++)
+    matchOf.assign(progressEvents.size(), none);
+    for(size_t p=0; p<ncp; p++)
     {
-      const auto& progressEvent = progressEvents.at(i);
+      size_t m = diff.candidateMatches.at(p);
+      const auto& match = diff.matches.at(m);
+      matchOf.at(match.candidate) = m;
+
+      auto& color = progressEvents.at(match.candidate).color;
+      if(!match.matched())
+      {
+        setColor(color, 60, 120, 230);
+        continue;
+      }
 
-      tp_maps::Lines line;
-      line.mode = GL_LINE_LOOP;
-      line.color = progressEvent.color.toFloat4<glm::vec4>();
-      line.lines.reserve(4);
+      float s = std::clamp(float(match.slowdown()), -1.0f, 1.0f);
+      auto mix = [&](uint8_t from, uint8_t to){return uint8_t(float(from) + (float(to)-float(from))*std::fabs(s));};
+      if(s>=0.0f)
+        setColor(color, mix(160, 230), mix(160, 40), mix(160, 40));
+      else
+        setColor(color, mix(160, 40), mix(160, 190), mix(160, 60));
+    }
+
+    for(size_t p=0; p<baselineLayout.order.size(); p++)
+    {
+      size_t m = diff.baselineMatches.at(p);
+      size_t i = nc + baselineLayout.order.at(p);
+      matchOf.at(i) = m;
 
-      float x1 = toFt(progressEvent.start);
-      float x2 = toFt(progressEvent.end  );
+      if(diff.matches.at(m).matched())
+        setColor(progressEvents.at(i).color, 200, 200, 200);
+      else
+        setColor(progressEvents.at(i).color, 90, 90, 90);
+    }
 
-      float y1 = 1.0f - ((float(i)+0.1f) / float(progressEvents.size()));
-      float y2 = 1.0f - ((float(i)-0.1f) / float(progressEvents.size()));
+    // Each candidate row is followed by a row holding the baseline bars matched to it, removed
+    // baseline bars go at the bottom laid out in the same mode.
+    auto& l = comparisonLayout;
+    l = ProgressEventsLayout();
+    l.now = now;
+    l.order = candidateLayout.order;
+    l.depths = candidateLayout.depths;
+    l.parents = candidateLayout.parents;
+    l.positions.assign(progressEvents.size(), none);
+    for(size_t p=0; p<ncp; p++)
+    {
+      l.positions.at(l.order.at(p)) = p;
+      l.rows.push_back(2*candidateLayout.rows.at(p));
+    }
 
-      line.lines.emplace_back(x1, y1, 0.0f);
-      line.lines.emplace_back(x2, y1, 0.0f);
-      line.lines.emplace_back(x2, y2, 0.0f);
-      line.lines.emplace_back(x1, y2, 0.0f);
+    size_t removedRows=0;
+    for(size_t p=0; p<baselineLayout.order.size(); p++)
+    {
+      size_t i = nc + baselineLayout.order.at(p);
+      l.positions.at(i) = l.order.size();
+      l.order.push_back(i);
+      l.depths.push_back(baselineLayout.depths.at(p));
+      auto parent = baselineLayout.parents.at(p);
+      l.parents.push_back((parent!=none)?(ncp+parent):none);
 
+      const auto& match = diff.matches.at(diff.baselineMatches.at(p));
+      if(match.matched())
+        l.rows.push_back(2*candidateLayout.rows.at(candidateLayout.positions.at(match.candidate))+1);
+      else
       {
-        auto layer = new tp_maps::LinesLayer();
-        layer->setDefaultRenderPass(tp_maps::RenderPass::GUI);
-        layer->setExcludeFromPicking(false);
-        layer->setLines({line});
-        mapWidget->map()->addLayer(layer);
-        layers.push_back(layer);
+        size_t row = (layoutMode==ProgressEventsLayoutMode::Packed)?baselineLayout.rows.at(p):removedRows;
+        removedRows = std::max(removedRows, row+1);
+        l.rows.push_back(2*candidateLayout.rowCount + row);
+      }
+    }
+    l.rowCount = 2*candidateLayout.rowCount + removedRows;
+
+    bool first=true;
+    for(auto i : l.order)
+    {
+      const auto& event = progressEvents.at(i);
+      l.minTime = first?event.start:std::min(l.minTime, event.start);
+      l.maxTime = first?l.end(event):std::max(l.maxTime, l.end(event));
+      first = false;
+    }
+
+    comparison = true;
+  }
+
+  //################################################################################################
+  //! Rebuild the comparison from the events it is showing, for example after the mode changes.
+  /*!
+  The baseline is already shifted, which leaves the pairing unchanged and gives a shift and id
+  offset of zero when it is compared again.
+  */
+  void redoComparison()
+  {
+    auto begin = progressEvents.begin()+ptrdiff_t(candidateCount);
+    std::vector<tp_utils::ProgressEvent> candidate(progressEvents.begin(), begin);
+    std::vector<tp_utils::ProgressEvent> baseline(begin, progressEvents.end());
+    setComparison(baseline, candidate);
+  }
+
+  //################################################################################################
+  //! The path only changes with the events, it is recalculated when it is shown or asked for.
+  void updateCriticalPath()
+  {
+    criticalPathDirty = true;
+    drawCriticalPath();
+  }
+
+  //################################################################################################
+  void drawCriticalPath()
+  {
+    if(!criticalPathLayer)
+    {
+      if(!criticalPathVisible)
+        return;
+
+      criticalPathLayer = new tp_maps::LinesLayer();
+      criticalPathLayer->setDefaultRenderPass(tp_maps::RenderPass::GUI);
+      mapWidget->map()->addLayer(criticalPathLayer);
+    }
+
+    std::vector<tp_maps::Lines> lines;
+    if(criticalPathVisible)
+    {
+      auto& line = lines.emplace_back();
+      line.mode = GL_LINES;
+      line.color = {1.0f, 0.2f, 0.2f, 1.0f};
+      if(useLOD)
+        addLODBars(line.lines, calculateCriticalPath(), 2.0f*highlightMargin_lt);
+      else
+      {
+        for(auto i : calculateCriticalPath())
+        {
+          const auto& progressEvent = progressEvents.at(i);
+          auto p = layout.positions.at(i);
+          addBar(line.lines, progressEvent.start, layout.end(progressEvent), float(layout.rows.at(p)), barHalfHeight_lt+2.0f*highlightMargin_lt);
+        }
       }
     }
+
+    criticalPathLayer->setLines(lines);
   }
 
   //################################################################################################
-  tp_utils::Callback<void(QHelpEvent*, tp_maps::LinesPickingResult*)> linesLayerToolTipEvent = [&](QHelpEvent* helpEvent, tp_maps::LinesPickingResult* result)
+  const std::vector<size_t>& calculateCriticalPath()
   {
-    for(size_t i=0; i<layers.size(); i++)
+    if(criticalPathDirty)
     {
-      auto l = layers.at(i);
-      if(l == result->layer)
+      criticalPath = progressEventsCriticalPath(progressEvents, comparison?candidateLayout:layout);
+      criticalPathDirty = false;
+    }
+    return criticalPath;
+  }
+
+  //################################################################################################
+  //! Recalculate the statistics on the worker thread, if the table is visible.
+  /*!
+  Runs are at least statsIntervalMS_lt apart, requests made in between are picked up by a single
+  run once the interval has passed, so live updates do not copy the events on every tick.
+  */
+  void requestStats()
+  {
+    if(!statsTable->isVisibleTo(q))
+      return;
+
+    if(statsRunning || statsTimer->isActive())
+    {
+      statsPending = true;
+      return;
+    }
+
+    statsRunning = true;
+    statsPending = false;
+    statsTimer->start();
+
+    // The worker gets its own copy so the events can keep changing while it runs. When comparing
+    // only the candidate is counted, it comes first so the copy stops there.
+    auto end = comparison?(progressEvents.begin()+ptrdiff_t(candidateCount)):progressEvents.end();
+    statsPool.start([q=q, progressEvents=std::vector<tp_utils::ProgressEvent>(progressEvents.begin(), end), layout=comparison?candidateLayout:layout]
+    {
+      auto result = progressEventsStats(progressEvents, layout);
+      QMetaObject::invokeMethod(q, [q, result=std::move(result)]() mutable
       {
-        if(i>=progressEvents.size())
-          break;
+        q->d->statsFinished(std::move(result));
+      }, Qt::QueuedConnection);
+    });
+  }
 
-        const auto& item = progressEvents.at(i);
+  //################################################################################################
+  void statsFinished(std::vector<ProgressEventsNameStats>&& result)
+  {
+    statsRunning = false;
+    stats = std::move(result);
+    updateStatsTable();
+    Q_EMIT q->statisticsChanged();
 
-        uint64_t duration = item.end-item.start;
+    if(statsPending && !statsTimer->isActive())
+      requestStats();
+  }
 
-        auto t=QString("%1 (%2)").arg(QString::fromStdString(item.name)).arg(duration);
+  //################################################################################################
+  void updateStatsTable()
+  {
+    QSignalBlocker blocker(statsTable);
+    statsTable->setSortingEnabled(false);
+    statsTable->setRowCount(int(stats.size()));
+
+    auto setNumber = [&](int row, int column, int64_t value)
+    {
+      auto item = statsTable->item(row, column);
+      if(!item)
+      {
+        item = new QTableWidgetItem();
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        statsTable->setItem(row, column, item);
+      }
+      item->setData(Qt::DisplayRole, qlonglong(value));
+    };
 
-        QToolTip::showText(helpEvent->globalPos(), t);
+    for(size_t i=0; i<stats.size(); i++)
+    {
+      const auto& s = stats.at(i);
+      int row = int(i);
 
-        break;
+      auto name = statsTable->item(row, NameColumn_lt);
+      if(!name)
+      {
+        name = new QTableWidgetItem();
+        statsTable->setItem(row, NameColumn_lt, name);
       }
+      name->setText(QString::fromStdString(s.name));
+
+      setNumber(row, CountColumn_lt, int64_t(s.count));
+      setNumber(row, TotalColumn_lt, s.total);
+      setNumber(row, SelfColumn_lt, s.self);
+      setNumber(row, MinColumn_lt, s.min);
+      setNumber(row, MaxColumn_lt, s.max);
+      setNumber(row, P95Column_lt, s.p95);
+
     }
+
+    statsTable->setSortingEnabled(true);
+
+    statsTable->clearSelection();
+    for(int row=0; row<statsTable->rowCount(); row++)
+      if(statsTable->item(row, NameColumn_lt)->text().toStdString() == highlightedName)
+        statsTable->selectRow(row);
+  }
+
+  //################################################################################################
+  void setHighlighted(size_t index)
+  {
+    if(highlighted == index)
+      return;
+    highlighted = index;
+    updateHighlight();
+  }
+
+  //################################################################################################
+  //! Find the event under a point in widget coordinates, this uses the index rather than picking.
+  bool eventAt(const QPoint& pos, size_t& index)
+  {
+    if(layout.order.empty() || rangeEnd<=rangeStart)
+      return false;
+
+    auto map = mapWidget->map();
+    const auto& matrix = map->controller()->matrix(tp_maps::defaultSID());
+    float pixelRatio = float(mapWidget->devicePixelRatio());
+    glm::vec2 screenPoint(float(pos.x())*pixelRatio, float(pos.y())*pixelRatio);
+
+    glm::vec3 scenePoint;
+    glm::vec3 tolerancePoint;
+    if(!map->unProject(screenPoint, scenePoint, matrix) ||
+       !map->unProject(screenPoint+glm::vec2(hitTolerancePixels_lt*pixelRatio, 0.0f), tolerancePoint, matrix))
+      return false;
+
+    float row = (1.0f - scenePoint.y) * float(rowCapacity);
+    float nearest = std::floor(row + 0.5f);
+    if(std::fabs(row-nearest)>barHalfHeight_lt || nearest<0.0f || nearest>=float(layout.rowCount))
+      return false;
+
+    double span = double(rangeEnd-rangeStart);
+    auto time = rangeStart + int64_t(std::floor(double(scenePoint.x)*span));
+    auto tolerance = int64_t(std::ceil(std::fabs(double(tolerancePoint.x-scenePoint.x))*span));
+
+    index = eventIndex.eventAt(size_t(nearest), time, tolerance, progressEvents, layout);
+    return index != none;
+  }
+
+  //################################################################################################
+  tp_utils::Callback<void(QHelpEvent*, bool&)> toolTipEvent = [&](QHelpEvent* helpEvent, bool& handled)
+  {
+    size_t index=0;
+    if(!eventAt(helpEvent->pos(), index))
+      return;
+
+    const auto& item = progressEvents.at(index);
+
+    int64_t duration = layout.end(item)-item.start;
+
+    auto t=QString("%1 (%2)").arg(QString::fromStdString(item.name)).arg(duration);
+
+    if(comparison)
+    {
+      if(auto m=matchOf.at(index); m!=none)
+      {
+        const auto& match = diff.matches.at(m);
+        if(match.matched())
+          t += QString("\nBaseline %1, candidate %2, %3%4%").
+              arg(match.baselineDuration).
+              arg(match.candidateDuration).
+              arg(match.slowdown()>=0.0?"+":"").
+              arg(match.slowdown()*100.0, 0, 'f', 1);
+        else
+          t += (match.candidate!=none)?"\nOnly in candidate":"\nOnly in baseline";
+      }
+    }
+
+    QToolTip::showText(helpEvent->globalPos(), t);
+    handled = true;
   };
 
+  //################################################################################################
+  tp_utils::Callback<void(QMouseEvent*)> hoverEvent = [&](QMouseEvent* mouseEvent)
+  {
+    size_t index=none;
+    if(mouseEvent)
+      eventAt(mouseEvent->pos(), index);
+    setHighlighted(index);
+  };
 };
 
 //##################################################################################################
 ProgressEventsGraphWidget::ProgressEventsGraphWidget(QWidget* parent):
   QWidget(parent),
-  d(new Private())
+  d(new Private(this))
 
 {
   auto l = new QVBoxLayout(this);
   l->setContentsMargins(0,0,0,0);
 
+  d->splitter = new QSplitter();
+  l->addWidget(d->splitter);
+
   d->mapWidget = new MapWidget_lt();
-  l->addWidget(d->mapWidget);
-  d->linesLayerToolTipEvent.connect(d->mapWidget->linesLayerToolTipEvent);
+  d->splitter->addWidget(d->mapWidget);
+  d->splitter->setStretchFactor(0, 1);
+
+  d->statsTable = new QTableWidget(0, ColumnCount_lt);
+  d->statsTable->setHorizontalHeaderLabels({"Name", "Count", "Total", "Self", "Min", "Max", "P95"});
+  d->statsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+  d->statsTable->setSelectionMode(QAbstractItemView::SingleSelection);
+  d->statsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  d->statsTable->verticalHeader()->setVisible(false);
+  d->statsTable->horizontalHeader()->setSectionResizeMode(NameColumn_lt, QHeaderView::Stretch);
+  d->statsTable->setSortingEnabled(true);
+  d->statsTable->sortByColumn(TotalColumn_lt, Qt::DescendingOrder);
+  d->statsTable->setVisible(false);
+  d->splitter->addWidget(d->statsTable);
+  d->splitter->setStretchFactor(1, 0);
+
+  connect(d->statsTable, &QTableWidget::itemSelectionChanged, this, [&]
+  {
+    auto items = d->statsTable->selectedItems();
+    std::string name;
+    for(auto item : items)
+      if(item->column() == NameColumn_lt)
+        name = item->text().toStdString();
+    setHighlightedName(name);
+  });
+  d->toolTipEvent.connect(d->mapWidget->toolTipEvent);
+  d->hoverEvent.connect(d->mapWidget->hoverEvent);
+  d->aboutToPaint.connect(d->mapWidget->aboutToPaint);
+  d->mapWidget->setMouseTracking(true);
 
   d->graphController = new tp_maps::GraphController(d->mapWidget->map());
+
+  d->statsTimer = new QTimer(this);
+  d->statsTimer->setSingleShot(true);
+  d->statsTimer->setInterval(statsIntervalMS_lt);
+  connect(d->statsTimer, &QTimer::timeout, this, [&]
+  {
+    if(d->statsPending && !d->statsRunning)
+      d->requestStats();
+  });
+
+  d->liveTimer = new QTimer(this);
+  connect(d->liveTimer, &QTimer::timeout, this, [&]
+  {
+    Q_EMIT liveUpdate();
+
+    std::vector<bool> dirty(d->chunkCount(), false);
+    d->updateActive(dirty);
+  });
 }
 
 //##################################################################################################
@@ -239,8 +1182,214 @@ ProgressEventsGraphWidget::~ProgressEventsGraphWidget()
 //##################################################################################################
 void ProgressEventsGraphWidget::setProgressEvents(const std::vector<tp_utils::ProgressEvent>& progressEvents)
 {
+  d->comparison = false;
+  d->diff = ProgressEventsDiff();
+  d->comparisonLayout = ProgressEventsLayout();
+  d->candidateLayout = ProgressEventsLayout();
+  d->candidateCount = 0;
+  d->matchOf.clear();
+
   d->progressEvents = progressEvents;
-  d->updateDisplay();
+  d->indexes.clear();
+  d->indexEvents(0);
+
+  tpDeleteAll(d->layers);
+  d->layers.clear();
+  d->layout = ProgressEventsLayout();
+  d->highlighted = Private::none;
+  d->relayout(true);
+}
+
+//##################################################################################################
+void ProgressEventsGraphWidget::setComparison(const std::vector<tp_utils::ProgressEvent>& baseline,
+                                              const std::vector<tp_utils::ProgressEvent>& candidate)
+{
+  d->setComparison(baseline, candidate);
+  d->indexes.clear();
+  d->indexEvents(0);
+
+  tpDeleteAll(d->layers);
+  d->layers.clear();
+  d->layout = ProgressEventsLayout();
+  d->highlighted = Private::none;
+  d->relayout(true);
+}
+
+//##################################################################################################
+bool ProgressEventsGraphWidget::isComparison() const
+{
+  return d->comparison;
+}
+
+//##################################################################################################
+const ProgressEventsDiff& ProgressEventsGraphWidget::comparison() const
+{
+  return d->diff;
+}
+
+//##################################################################################################
+std::string ProgressEventsGraphWidget::comparisonSummary(size_t count) const
+{
+  std::string summary;
+  for(const auto& match : largestRegressions(d->diff, count))
+  {
+    auto path = progressEventsNamePath(d->progressEvents, d->layout, d->layout.positions.at(match.candidate));
+    summary += QString("%1: %2 -> %3 (+%4, +%5%)\n").
+        arg(QString::fromStdString(path)).
+        arg(match.baselineDuration).
+        arg(match.candidateDuration).
+        arg(match.candidateDuration-match.baselineDuration).
+        arg(match.slowdown()*100.0, 0, 'f', 1).toStdString();
+  }
+  return summary;
+}
+
+//##################################################################################################
+const std::vector<tp_utils::ProgressEvent>& ProgressEventsGraphWidget::progressEvents() const
+{
+  return d->progressEvents;
+}
+
+//##################################################################################################
+void ProgressEventsGraphWidget::appendProgressEvents(const std::vector<tp_utils::ProgressEvent>& progressEvents)
+{
+  if(progressEvents.empty() || d->comparison)
+    return;
+
+  size_t first = d->progressEvents.size();
+  d->progressEvents.insert(d->progressEvents.end(), progressEvents.begin(), progressEvents.end());
+  d->indexEvents(first);
+  d->relayout(false);
+}
+
+//##################################################################################################
+void ProgressEventsGraphWidget::updateActiveEvents(const std::vector<tp_utils::ProgressEvent>& progressEvents)
+{
+  if(d->comparison)
+    return;
+
+  std::vector<bool> dirty(d->chunkCount(), false);
+
+  for(const auto& progressEvent : progressEvents)
+  {
+    auto i = d->indexes.find(progressEvent.id);
+    if(i == d->indexes.end())
+      continue;
+
+    auto& existing = d->progressEvents.at(i->second);
+    if(!existing.active)
+      continue;
+
+    existing.end = progressEvent.end;
+    existing.active = progressEvent.active;
+
+    if(auto p=d->layout.positions.at(i->second); p!=Private::none)
+    {
+      dirty.at(p/barsPerChunk_lt) = true;
+      d->layout.maxTime = std::max(d->layout.maxTime, d->layout.end(existing));
+    }
+  }
+
+  d->updateActive(dirty);
+}
+
+//##################################################################################################
+void ProgressEventsGraphWidget::setLayoutMode(ProgressEventsLayoutMode layoutMode)
+{
+  if(d->layoutMode == layoutMode)
+    return;
+
+  d->layoutMode = layoutMode;
+
+  if(d->comparison)
+  {
+    d->redoComparison();
+    tpDeleteAll(d->layers);
+    d->layers.clear();
+    d->layout = ProgressEventsLayout();
+    d->highlighted = Private::none;
+  }
+
+  d->relayout(true);
+}
+
+//##################################################################################################
+ProgressEventsLayoutMode ProgressEventsGraphWidget::layoutMode() const
+{
+  return d->layoutMode;
+}
+
+//##################################################################################################
+void ProgressEventsGraphWidget::setStatisticsVisible(bool statisticsVisible)
+{
+  d->statsTable->setVisible(statisticsVisible);
+  if(statisticsVisible)
+    d->requestStats();
+}
+
+//##################################################################################################
+bool ProgressEventsGraphWidget::statisticsVisible() const
+{
+  return d->statsTable->isVisibleTo(this);
+}
+
+//##################################################################################################
+const std::vector<ProgressEventsNameStats>& ProgressEventsGraphWidget::statistics() const
+{
+  return d->stats;
+}
+
+//##################################################################################################
+void ProgressEventsGraphWidget::setHighlightedName(const std::string& highlightedName)
+{
+  if(d->highlightedName == highlightedName)
+    return;
+
+  d->highlightedName = highlightedName;
+  d->updateNameHighlight();
+}
+
+//##################################################################################################
+const std::string& ProgressEventsGraphWidget::highlightedName() const
+{
+  return d->highlightedName;
+}
+
+//##################################################################################################
+void ProgressEventsGraphWidget::setCriticalPathVisible(bool criticalPathVisible)
+{
+  if(d->criticalPathVisible == criticalPathVisible)
+    return;
+
+  d->criticalPathVisible = criticalPathVisible;
+  d->updateCriticalPath();
+}
+
+//##################################################################################################
+bool ProgressEventsGraphWidget::criticalPathVisible() const
+{
+  return d->criticalPathVisible;
+}
+
+//##################################################################################################
+const std::vector<size_t>& ProgressEventsGraphWidget::criticalPath() const
+{
+  return d->calculateCriticalPath();
+}
+
+//##################################################################################################
+void ProgressEventsGraphWidget::setLiveUpdateInterval(int interval)
+{
+  if(interval>0)
+    d->liveTimer->start(interval);
+  else
+    d->liveTimer->stop();
+}
+
+//##################################################################################################
+int ProgressEventsGraphWidget::liveUpdateInterval() const
+{
+  return d->liveTimer->isActive()?d->liveTimer->interval():0;
 }
 
 }
@@ -0,0 +1,156 @@
+#include "tp_qt_maps_widget/ProgressEventsIndex.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+struct ProgressEventsIndex::Private
+{
+  struct Entry
+  {
+    int64_t start;
+    size_t event;
+    bool active; //!< The event was active at build and is also in rowActive.
+  };
+
+  std::vector<size_t> rowOffsets; //!< Entries for row r are [rowOffsets[r], rowOffsets[r+1]).
+  std::vector<Entry> entries;
+
+  //! The longest finished bar in each row, this bounds how far back a search has to look.
+  std::vector<int64_t> rowMaxLength;
+
+  //! Events that were active when the index was built, these grow so are always checked.
+  std::vector<std::vector<size_t>> rowActive;
+
+  //################################################################################################
+  //! Returns the range of entries for a row.
+  std::pair<const Entry*, const Entry*> row(size_t r) const
+  {
+    if(r+1>=rowOffsets.size())
+      return {nullptr, nullptr};
+    return {entries.data()+rowOffsets.at(r), entries.data()+rowOffsets.at(r+1)};
+  }
+};
+
+//##################################################################################################
+ProgressEventsIndex::ProgressEventsIndex():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+ProgressEventsIndex::~ProgressEventsIndex()
+{
+  delete d;
+}
+
+//##################################################################################################
+void ProgressEventsIndex::build(const std::vector<tp_utils::ProgressEvent>& progressEvents, const ProgressEventsLayout& layout)
+{
+  // Counting sort by row, then sort each row by start.
+  d->rowOffsets.assign(layout.rowCount+1, 0);
+  for(auto r : layout.rows)
+    d->rowOffsets.at(r+1)++;
+  for(size_t r=0; r<layout.rowCount; r++)
+    d->rowOffsets.at(r+1) += d->rowOffsets.at(r);
+
+  d->entries.resize(layout.order.size());
+  auto next = d->rowOffsets;
+  for(size_t p=0; p<layout.order.size(); p++)
+  {
+    size_t i = layout.order.at(p);
+    const auto& event = progressEvents.at(i);
+    d->entries.at(next.at(layout.rows.at(p))++) = {event.start, i, event.active};
+  }
+
+  d->rowMaxLength.assign(layout.rowCount, 0);
+  d->rowActive.assign(layout.rowCount, {});
+  for(size_t r=0; r<layout.rowCount; r++)
+  {
+    auto begin = d->entries.begin()+ptrdiff_t(d->rowOffsets.at(r));
+    auto end   = d->entries.begin()+ptrdiff_t(d->rowOffsets.at(r+1));
+    std::sort(begin, end, [](const auto& a, const auto& b){return a.start<b.start;});
+
+    for(auto e=begin; e!=end; ++e)
+    {
+      const auto& event = progressEvents.at(e->event);
+      if(e->active)
+        d->rowActive.at(r).push_back(e->event);
+      else
+        d->rowMaxLength.at(r) = std::max(d->rowMaxLength.at(r), event.end-event.start);
+    }
+  }
+}
+
+//##################################################################################################
+void ProgressEventsIndex::clear()
+{
+  d->rowOffsets.clear();
+  d->entries.clear();
+  d->rowMaxLength.clear();
+  d->rowActive.clear();
+}
+
+//##################################################################################################
+size_t ProgressEventsIndex::eventAt(size_t row,
+                                    int64_t time,
+                                    int64_t tolerance,
+                                    const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                    const ProgressEventsLayout& layout) const
+{
+  size_t best = ProgressEventsLayout::none;
+  int64_t bestDistance = tolerance+1;
+
+  eventsInRange(row, time-tolerance, time+tolerance, progressEvents, layout, [&](size_t i)
+  {
+    const auto& event = progressEvents.at(i);
+    int64_t end = layout.end(event);
+    int64_t distance = (time<event.start)?(event.start-time):((time>end)?(time-end):0);
+    if(distance<bestDistance)
+    {
+      bestDistance = distance;
+      best = i;
+    }
+  });
+
+  return best;
+}
+
+//##################################################################################################
+void ProgressEventsIndex::eventsInRange(size_t row,
+                                        int64_t t1,
+                                        int64_t t2,
+                                        const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                        const ProgressEventsLayout& layout,
+                                        const std::function<void(size_t)>& closure) const
+{
+  auto [begin, end] = d->row(row);
+  if(begin == end)
+    return;
+
+  int64_t maxLength = d->rowMaxLength.at(row);
+  int64_t earliest = (t1>std::numeric_limits<int64_t>::min()+maxLength)?(t1-maxLength):std::numeric_limits<int64_t>::min();
+
+  auto e = std::lower_bound(begin, end, earliest, [](const Private::Entry& a, int64_t t){return a.start<t;});
+  for(; e!=end && e->start<=t2; ++e)
+  {
+    // Events that were active at build, even if they have finished since, are checked below.
+    if(e->active || layout.end(progressEvents.at(e->event))<t1)
+      continue;
+
+    closure(e->event);
+  }
+
+  for(auto i : d->rowActive.at(row))
+  {
+    const auto& event = progressEvents.at(i);
+    if(event.start<=t2 && layout.end(event)>=t1)
+      closure(i);
+  }
+}
+
+}
@@ -0,0 +1,267 @@
+#include "tp_qt_maps_widget/ProgressEventsLOD.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace tp_qt_maps_widget
+{
+
+namespace
+{
+//! Each level merges gaps this many times wider than the level below.
+constexpr int64_t levelFactor_lt{4};
+}
+
+//##################################################################################################
+void mergeProgressEventsBlocks(const std::vector<ProgressEventsBlock>& blocks,
+                               int64_t width,
+                               int64_t now,
+                               std::vector<ProgressEventsBlock>& merged)
+{
+  merged.clear();
+  int64_t end=0;
+  for(const auto& block : blocks)
+  {
+    if(!merged.empty() && block.start-end<width)
+    {
+      auto& back = merged.back();
+      back.end = std::max(back.end, block.end);
+      back.count += block.count;
+      back.active = back.active || block.active;
+      if(block.longest>back.longest)
+      {
+        back.longest = block.longest;
+        back.event = block.event;
+      }
+    }
+    else
+    {
+      merged.push_back(block);
+      end = std::numeric_limits<int64_t>::min();
+    }
+
+    end = std::max(end, block.endAt(now));
+  }
+}
+
+//##################################################################################################
+struct ProgressEventsLOD::Private
+{
+  struct Level
+  {
+    int64_t width{0};                       //!< Gaps narrower than this have been merged.
+    int64_t maxLength{0};                   //!< Longest finished block, bounds how far back to search.
+    std::vector<ProgressEventsBlock> blocks; //!< Sorted by start.
+    std::vector<size_t> active;             //!< Blocks that contain active events.
+  };
+
+  std::vector<std::vector<Level>> rows;
+
+  //################################################################################################
+  static void addLevel(std::vector<Level>& levels, int64_t width, std::vector<ProgressEventsBlock>&& blocks)
+  {
+    auto& level = levels.emplace_back();
+    level.width = width;
+    level.blocks = std::move(blocks);
+    for(size_t b=0; b<level.blocks.size(); b++)
+    {
+      const auto& block = level.blocks.at(b);
+      if(block.active)
+        level.active.push_back(b);
+      else
+        level.maxLength = std::max(level.maxLength, block.end-block.start);
+    }
+  }
+
+  //################################################################################################
+  //! Build the pyramid for a row from its events, which must be sorted by start.
+  static void buildRow(std::vector<Level>& levels, std::vector<ProgressEventsBlock>&& events, int64_t now)
+  {
+    levels.clear();
+
+    int64_t span=0;
+    if(!events.empty())
+    {
+      int64_t end = events.front().start;
+      for(const auto& event : events)
+        end = std::max(end, event.endAt(now));
+      span = end - events.front().start;
+    }
+
+    std::vector<ProgressEventsBlock> previous = events;
+    addLevel(levels, 0, std::move(events));
+
+    std::vector<ProgressEventsBlock> next;
+    for(int64_t width=1; previous.size()>1 && width<=span; width*=levelFactor_lt)
+    {
+      mergeProgressEventsBlocks(previous, width, now, next);
+      std::swap(previous, next);
+
+      if(previous.size()*2 <= levels.back().blocks.size())
+        addLevel(levels, width, std::vector<ProgressEventsBlock>(previous));
+
+      if(width>std::numeric_limits<int64_t>::max()/levelFactor_lt)
+        break;
+    }
+  }
+
+  //################################################################################################
+  //! The coarsest level that has not merged gaps of width or wider.
+  static const Level& levelFor(const std::vector<Level>& levels, int64_t width)
+  {
+    size_t l=0;
+    while(l+1<levels.size() && levels.at(l+1).width<=width)
+      l++;
+    return levels.at(l);
+  }
+};
+
+//##################################################################################################
+ProgressEventsLOD::ProgressEventsLOD():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+ProgressEventsLOD::~ProgressEventsLOD()
+{
+  delete d;
+}
+
+//##################################################################################################
+void ProgressEventsLOD::build(const std::vector<tp_utils::ProgressEvent>& progressEvents, const ProgressEventsLayout& layout)
+{
+  d->rows.clear();
+  update(progressEvents, layout, {});
+}
+
+//##################################################################################################
+void ProgressEventsLOD::update(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                               const ProgressEventsLayout& layout,
+                               const std::vector<bool>& dirtyRows,
+                               const std::vector<size_t>& sourceRows)
+{
+  auto dirty = [&](size_t r){return r>=dirtyRows.size() || dirtyRows.at(r);};
+
+  if(sourceRows.empty())
+    d->rows.resize(layout.rowCount);
+  else
+  {
+    std::vector<std::vector<Private::Level>> rows(layout.rowCount);
+    for(size_t r=0; r<layout.rowCount; r++)
+      if(!dirty(r) && r<sourceRows.size() && sourceRows.at(r)<d->rows.size())
+        rows.at(r) = std::move(d->rows.at(sourceRows.at(r)));
+    d->rows.swap(rows);
+  }
+
+  // Bucket the events of the dirty rows by row, then sort each row by start.
+  std::vector<size_t> offsets(layout.rowCount+1, 0);
+  for(auto r : layout.rows)
+    if(dirty(r))
+      offsets.at(r+1)++;
+  for(size_t r=0; r<layout.rowCount; r++)
+    offsets.at(r+1) += offsets.at(r);
+
+  std::vector<size_t> events(offsets.back());
+  {
+    auto next = offsets;
+    for(size_t p=0; p<layout.order.size(); p++)
+      if(auto r=layout.rows.at(p); dirty(r))
+        events.at(next.at(r)++) = layout.order.at(p);
+  }
+
+  for(size_t r=0; r<layout.rowCount; r++)
+  {
+    if(!dirty(r))
+      continue;
+
+    std::vector<ProgressEventsBlock> blocks;
+    blocks.reserve(offsets.at(r+1)-offsets.at(r));
+    for(size_t e=offsets.at(r); e<offsets.at(r+1); e++)
+    {
+      size_t i = events.at(e);
+      const auto& event = progressEvents.at(i);
+
+      auto& block = blocks.emplace_back();
+      block.start = event.start;
+      block.end = event.active?event.start:event.end;
+      block.longest = layout.end(event)-event.start;
+      block.count = 1;
+      block.event = i;
+      block.active = event.active;
+    }
+
+    std::sort(blocks.begin(), blocks.end(), [](const auto& a, const auto& b){return a.start<b.start;});
+    Private::buildRow(d->rows.at(r), std::move(blocks), layout.now);
+  }
+}
+
+//##################################################################################################
+void ProgressEventsLOD::clear()
+{
+  d->rows.clear();
+}
+
+//##################################################################################################
+size_t ProgressEventsLOD::blockCount() const
+{
+  size_t count=0;
+  for(const auto& levels : d->rows)
+    for(const auto& level : levels)
+      count += level.blocks.size();
+  return count;
+}
+
+//##################################################################################################
+void ProgressEventsLOD::blocks(size_t firstRow,
+                               size_t lastRow,
+                               size_t rowStride,
+                               int64_t t1,
+                               int64_t t2,
+                               int64_t width,
+                               const ProgressEventsLayout& layout,
+                               const std::function<void(size_t, const ProgressEventsBlock&)>& closure) const
+{
+  rowStride = std::max(size_t(1), rowStride);
+  lastRow = std::min(lastRow, d->rows.size());
+
+  std::vector<ProgressEventsBlock> group;
+  std::vector<ProgressEventsBlock> merged;
+
+  for(size_t g=firstRow-(firstRow%rowStride); g<lastRow; g+=rowStride)
+  {
+    group.clear();
+
+    for(size_t r=g; r<std::min(g+rowStride, lastRow); r++)
+    {
+      const auto& levels = d->rows.at(r);
+      if(levels.empty())
+        continue;
+
+      const auto& level = Private::levelFor(levels, width);
+      const auto& blocks = level.blocks;
+
+      int64_t earliest = (t1>std::numeric_limits<int64_t>::min()+level.maxLength)?(t1-level.maxLength):std::numeric_limits<int64_t>::min();
+      auto b = std::lower_bound(blocks.begin(), blocks.end(), earliest, [](const auto& a, int64_t t){return a.start<t;});
+      for(; b!=blocks.end() && b->start<=t2; ++b)
+        if(!b->active && b->end>=t1)
+          group.push_back(*b);
+
+      // Active blocks grow, so they are checked separately.
+      for(auto a : level.active)
+        if(const auto& block=blocks.at(a); block.start<=t2 && block.endAt(layout.now)>=t1)
+          group.push_back(block);
+    }
+
+    if(group.empty())
+      continue;
+
+    std::sort(group.begin(), group.end(), [](const auto& a, const auto& b){return a.start<b.start;});
+    mergeProgressEventsBlocks(group, width, layout.now, merged);
+    for(const auto& block : merged)
+      closure(g, block);
+  }
+}
+
+}
@@ -0,0 +1,105 @@
+#include "tp_qt_maps_widget/ProgressEventsLayout.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <tuple>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+ProgressEventsLayout layoutProgressEvents(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                          int64_t now,
+                                          ProgressEventsLayoutMode mode)
+{
+  ProgressEventsLayout layout;
+  layout.now = now;
+
+  if(progressEvents.empty())
+    return layout;
+
+  size_t n = progressEvents.size();
+
+  // Children are stored as linked lists through two index arrays, this avoids a vector per parent.
+  constexpr size_t none = ProgressEventsLayout::none;
+  std::vector<size_t> firstChild(n, none);
+  std::vector<size_t> nextSibling(n, none);
+  std::vector<size_t> lastChild(n, none);
+
+  {
+    using ID = decltype(tp_utils::ProgressEvent::id);
+    std::unordered_map<ID, size_t> indexes;
+    indexes.reserve(n);
+    for(size_t i=0; i<n; i++)
+      indexes.emplace(progressEvents.at(i).id, i);
+
+    for(size_t i=1; i<n; i++)
+    {
+      auto p = indexes.find(progressEvents.at(i).parentId);
+      if(p == indexes.end() || p->second == i)
+        continue;
+
+      size_t parent = p->second;
+      if(lastChild.at(parent) == none)
+        firstChild.at(parent) = i;
+      else
+        nextSibling.at(lastChild.at(parent)) = i;
+      lastChild.at(parent) = i;
+    }
+  }
+
+  layout.order.reserve(n);
+  layout.depths.reserve(n);
+  layout.parents.reserve(n);
+  layout.positions.assign(n, ProgressEventsLayout::none);
+
+  const auto& root = progressEvents.front();
+  layout.minTime = root.start;
+  layout.maxTime = layout.end(root);
+
+  // Iterative depth first walk, checking positions guards against cycles in malformed input.
+  std::vector<std::tuple<size_t, size_t, size_t>> stack{{0, 0, none}};
+  while(!stack.empty())
+  {
+    auto [i, depth, parent] = stack.back();
+    stack.pop_back();
+
+    if(layout.positions.at(i) != none)
+      continue;
+
+    const auto& event = progressEvents.at(i);
+    layout.positions.at(i) = layout.order.size();
+    layout.order.push_back(i);
+    layout.depths.push_back(depth);
+    layout.parents.push_back(parent);
+    layout.minTime = std::min(layout.minTime, event.start);
+    layout.maxTime = std::max(layout.maxTime, layout.end(event));
+
+    // Push in reverse so that siblings come out in their original order.
+    size_t first = stack.size();
+    size_t position = layout.positions.at(i);
+    for(size_t c=firstChild.at(i); c!=none; c=nextSibling.at(c))
+      stack.emplace_back(c, depth+1, position);
+    std::reverse(stack.begin()+ptrdiff_t(first), stack.end());
+  }
+
+  switch(mode)
+  {
+  case ProgressEventsLayoutMode::Tree:
+    layout.rowCount = layout.order.size();
+    layout.rows.resize(layout.rowCount);
+    for(size_t p=0; p<layout.rowCount; p++)
+      layout.rows.at(p) = p;
+    break;
+
+  case ProgressEventsLayoutMode::Packed:
+    layout.rows = layout.depths;
+    for(auto depth : layout.depths)
+      layout.rowCount = std::max(layout.rowCount, depth+1);
+    break;
+  }
+
+  return layout;
+}
+
+}
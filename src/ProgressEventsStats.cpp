@@ -0,0 +1,143 @@
+#include "tp_qt_maps_widget/ProgressEventsStats.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+std::vector<ProgressEventsNameStats> progressEventsStats(const std::vector<tp_utils::ProgressEvent>& progressEvents,
+                                                        const ProgressEventsLayout& layout)
+{
+  constexpr size_t none = ProgressEventsLayout::none;
+  size_t n = layout.order.size();
+
+  std::vector<ProgressEventsNameStats> stats;
+  std::vector<std::vector<int64_t>> durations;
+  std::vector<size_t> nameOf(n);
+  {
+    std::unordered_map<std::string, size_t> nameIndexes;
+    for(size_t p=0; p<n; p++)
+    {
+      const auto& name = progressEvents.at(layout.order.at(p)).name;
+      auto [i, inserted] = nameIndexes.try_emplace(name, stats.size());
+      if(inserted)
+      {
+        stats.emplace_back().name = name;
+        durations.emplace_back();
+      }
+      nameOf.at(p) = i->second;
+    }
+  }
+
+  const auto& parentOf = layout.parents;
+
+  // Time covered by each bar's children, clipped to the bar and with overlaps merged.
+  std::vector<int64_t> covered(n, 0);
+  {
+    std::vector<size_t> offsets(n+1, 0);
+    for(size_t p=0; p<n; p++)
+      if(parentOf.at(p) != none)
+        offsets.at(parentOf.at(p)+1)++;
+    for(size_t p=0; p<n; p++)
+      offsets.at(p+1) += offsets.at(p);
+
+    std::vector<std::pair<int64_t, int64_t>> intervals(offsets.back());
+    auto next = offsets;
+    for(size_t p=0; p<n; p++)
+    {
+      if(auto parent=parentOf.at(p); parent!=none)
+      {
+        const auto& event = progressEvents.at(layout.order.at(p));
+        intervals.at(next.at(parent)++) = {event.start, layout.end(event)};
+      }
+    }
+
+    for(size_t p=0; p<n; p++)
+    {
+      if(offsets.at(p) == offsets.at(p+1))
+        continue;
+
+      const auto& event = progressEvents.at(layout.order.at(p));
+      int64_t start = event.start;
+      int64_t end = layout.end(event);
+
+      auto begin = intervals.begin()+ptrdiff_t(offsets.at(p));
+      auto last  = intervals.begin()+ptrdiff_t(offsets.at(p+1));
+      std::sort(begin, last);
+
+      int64_t total=0;
+      int64_t runStart=0;
+      int64_t runEnd=0;
+      bool inRun=false;
+      for(auto i=begin; i!=last; ++i)
+      {
+        int64_t s = std::max(start, i->first);
+        int64_t e = std::min(end, i->second);
+        if(e<=s)
+          continue;
+
+        if(inRun && s<=runEnd)
+          runEnd = std::max(runEnd, e);
+        else
+        {
+          if(inRun)
+            total += runEnd-runStart;
+          runStart = s;
+          runEnd = e;
+          inRun = true;
+        }
+      }
+      if(inRun)
+        total += runEnd-runStart;
+
+      covered.at(p) = total;
+    }
+  }
+
+  // Walk depth first keeping a count of each name on the path, so recursion is only counted once.
+  std::vector<size_t> onPath(stats.size(), 0);
+  std::vector<size_t> path;
+  for(size_t p=0; p<n; p++)
+  {
+    size_t depth = layout.depths.at(p);
+    while(path.size()>depth)
+    {
+      onPath.at(nameOf.at(path.back()))--;
+      path.pop_back();
+    }
+
+    const auto& event = progressEvents.at(layout.order.at(p));
+    int64_t duration = layout.end(event)-event.start;
+    size_t name = nameOf.at(p);
+    auto& s = stats.at(name);
+
+    if(onPath.at(name) == 0)
+      s.total += duration;
+    s.self += std::max(int64_t(0), duration-covered.at(p));
+    s.count++;
+    durations.at(name).push_back(duration);
+
+    onPath.at(name)++;
+    path.push_back(p);
+  }
+
+  for(size_t i=0; i<stats.size(); i++)
+  {
+    auto& d = durations.at(i);
+    auto& s = stats.at(i);
+    auto [min, max] = std::minmax_element(d.begin(), d.end());
+    s.min = *min;
+    s.max = *max;
+
+    size_t k = size_t(0.95*double(d.size()-1) + 0.5);
+    std::nth_element(d.begin(), d.begin()+ptrdiff_t(k), d.end());
+    s.p95 = d.at(k);
+  }
+
+  std::sort(stats.begin(), stats.end(), [](const auto& a, const auto& b){return a.total>b.total;});
+  return stats;
+}
+
+}
@@ -0,0 +1,515 @@
+#include "tp_qt_maps_widget/ProgressEventsTraceFile.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace tp_qt_maps_widget
+{
+
+namespace
+{
+constexpr uint32_t fileMagic_lt{0x45505054}; //!< "TPPE"
+constexpr uint32_t blockMagic_lt{0x4b434c42}; //!< "BLCK"
+constexpr uint32_t version_lt{1};
+
+//##################################################################################################
+struct FileHeader_lt
+{
+  uint32_t magic{fileMagic_lt};
+  uint32_t version{version_lt};
+  uint64_t reserved{0};
+};
+
+//##################################################################################################
+//! Followed by nameCount lengths, nameBytes of names, then the columns, each padded to 8 bytes.
+struct BlockHeader_lt
+{
+  uint32_t magic{blockMagic_lt};
+  uint32_t count{0};
+  uint32_t nameCount{0};
+  uint32_t nameBytes{0};
+  uint64_t blockBytes{0}; //!< Including this header.
+};
+
+//##################################################################################################
+size_t pad8_lt(size_t size)
+{
+  return (size+7) & ~size_t(7);
+}
+
+//##################################################################################################
+size_t blockBytes_lt(size_t count, size_t nameCount, size_t nameBytes)
+{
+  return sizeof(BlockHeader_lt) +
+      pad8_lt(nameCount*sizeof(uint32_t) + nameBytes) +
+      4*count*sizeof(int64_t) +
+      2*pad8_lt(count*sizeof(uint32_t)) +
+      pad8_lt(count);
+}
+
+//##################################################################################################
+uint32_t packColor_lt(const decltype(tp_utils::ProgressEvent::color)& c)
+{
+  return uint32_t(c.r) | (uint32_t(c.g)<<8) | (uint32_t(c.b)<<16) | (uint32_t(c.a)<<24);
+}
+
+//##################################################################################################
+void unpackColor_lt(uint32_t packed, decltype(tp_utils::ProgressEvent::color)& c)
+{
+  c.r = uint8_t(packed);
+  c.g = uint8_t(packed>>8);
+  c.b = uint8_t(packed>>16);
+  c.a = uint8_t(packed>>24);
+}
+
+//##################################################################################################
+template<typename T>
+void append_lt(std::vector<char>& buffer, const T* data, size_t count)
+{
+  auto bytes = reinterpret_cast<const char*>(data);
+  buffer.insert(buffer.end(), bytes, bytes+count*sizeof(T));
+  buffer.resize(pad8_lt(buffer.size()), 0);
+}
+}
+
+//##################################################################################################
+struct ProgressEventsTraceWriter::Private
+{
+  size_t blockSize;
+  QFile file;
+  bool failed{false};
+
+  std::vector<int64_t> ids;
+  std::vector<int64_t> parentIds;
+  std::vector<int64_t> starts;
+  std::vector<int64_t> ends;
+  std::vector<uint32_t> colors;
+  std::vector<uint32_t> names;
+  std::vector<uint8_t> active;
+
+  std::unordered_map<std::string, uint32_t> nameIndexes;
+  std::vector<const std::string*> newNames; //!< Names first used in the current block.
+
+  std::vector<char> buffer;
+
+  //################################################################################################
+  Private(size_t blockSize_):
+    blockSize(std::max(size_t(1), blockSize_))
+  {
+
+  }
+
+  //################################################################################################
+  uint32_t intern(const std::string& name)
+  {
+    auto [i, inserted] = nameIndexes.try_emplace(name, uint32_t(nameIndexes.size()));
+    if(inserted)
+      newNames.push_back(&i->first);
+    return i->second;
+  }
+
+  //################################################################################################
+  void clearBlock()
+  {
+    ids.clear();
+    parentIds.clear();
+    starts.clear();
+    ends.clear();
+    colors.clear();
+    names.clear();
+    active.clear();
+    newNames.clear();
+  }
+
+  //################################################################################################
+  bool writeBlock()
+  {
+    if(ids.empty() || failed)
+    {
+      clearBlock();
+      return !failed;
+    }
+
+    std::vector<uint32_t> nameLengths;
+    nameLengths.reserve(newNames.size());
+    size_t nameBytes=0;
+    for(auto name : newNames)
+    {
+      nameLengths.push_back(uint32_t(name->size()));
+      nameBytes += name->size();
+    }
+
+    BlockHeader_lt header;
+    header.count = uint32_t(ids.size());
+    header.nameCount = uint32_t(newNames.size());
+    header.nameBytes = uint32_t(nameBytes);
+    header.blockBytes = blockBytes_lt(ids.size(), newNames.size(), nameBytes);
+
+    // Assemble the whole block so that it goes to the file in a single write.
+    buffer.clear();
+    buffer.reserve(header.blockBytes);
+    auto headerBytes = reinterpret_cast<const char*>(&header);
+    buffer.insert(buffer.end(), headerBytes, headerBytes+sizeof(header));
+
+    auto lengthBytes = reinterpret_cast<const char*>(nameLengths.data());
+    buffer.insert(buffer.end(), lengthBytes, lengthBytes+nameLengths.size()*sizeof(uint32_t));
+    for(auto name : newNames)
+      buffer.insert(buffer.end(), name->begin(), name->end());
+    buffer.resize(pad8_lt(buffer.size()), 0);
+
+    append_lt(buffer, ids.data(), ids.size());
+    append_lt(buffer, parentIds.data(), parentIds.size());
+    append_lt(buffer, starts.data(), starts.size());
+    append_lt(buffer, ends.data(), ends.size());
+    append_lt(buffer, colors.data(), colors.size());
+    append_lt(buffer, names.data(), names.size());
+    append_lt(buffer, active.data(), active.size());
+
+    clearBlock();
+
+    if(file.write(buffer.data(), qint64(buffer.size())) != qint64(buffer.size()))
+    {
+      tpWarning() << "Failed to write progress events trace block.";
+      failed = true;
+      return false;
+    }
+
+    if(!file.flush())
+    {
+      tpWarning() << "Failed to flush progress events trace block.";
+      failed = true;
+      return false;
+    }
+
+    return true;
+  }
+};
+
+//##################################################################################################
+ProgressEventsTraceWriter::ProgressEventsTraceWriter(size_t blockSize):
+  d(new Private(blockSize))
+{
+
+}
+
+//##################################################################################################
+ProgressEventsTraceWriter::~ProgressEventsTraceWriter()
+{
+  close();
+  delete d;
+}
+
+//##################################################################################################
+bool ProgressEventsTraceWriter::open(const std::string& path)
+{
+  close();
+
+  d->file.setFileName(QString::fromStdString(path));
+  if(!d->file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    tpWarning() << "Failed to open progress events trace for writing: " << path;
+    return false;
+  }
+
+  d->failed = false;
+  d->nameIndexes.clear();
+  d->clearBlock();
+
+  FileHeader_lt header;
+  if(d->file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header)))
+  {
+    tpWarning() << "Failed to write progress events trace header: " << path;
+    d->file.close();
+    return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+bool ProgressEventsTraceWriter::isOpen() const
+{
+  return d->file.isOpen();
+}
+
+//##################################################################################################
+bool ProgressEventsTraceWriter::write(const std::vector<tp_utils::ProgressEvent>& progressEvents)
+{
+  if(!d->file.isOpen() || d->failed)
+    return false;
+
+  for(const auto& progressEvent : progressEvents)
+  {
+    d->ids.push_back(int64_t(progressEvent.id));
+    d->parentIds.push_back(int64_t(progressEvent.parentId));
+    d->starts.push_back(progressEvent.start);
+    d->ends.push_back(progressEvent.end);
+    d->colors.push_back(packColor_lt(progressEvent.color));
+    d->names.push_back(d->intern(progressEvent.name));
+    d->active.push_back(progressEvent.active?1:0);
+
+    if(d->ids.size()>=d->blockSize && !d->writeBlock())
+      return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+bool ProgressEventsTraceWriter::flush()
+{
+  if(!d->file.isOpen())
+    return false;
+
+  return d->writeBlock();
+}
+
+//##################################################################################################
+bool ProgressEventsTraceWriter::close()
+{
+  if(!d->file.isOpen())
+    return false;
+
+  bool ok = d->writeBlock();
+  d->file.close();
+  d->nameIndexes.clear();
+  return ok;
+}
+
+//##################################################################################################
+struct ProgressEventsTraceFile::Private
+{
+  QFile file;
+  uchar* mapped{nullptr};
+  QByteArray buffer; //!< Used if the file could not be mapped.
+
+  std::vector<ProgressEventsTraceBlock> blocks;
+  std::vector<std::string_view> names;
+  size_t recordCount{0};
+
+  //################################################################################################
+  //! Index the blocks in size bytes of data, stopping at the first incomplete block.
+  bool index(const char* data, size_t size, const std::string& path)
+  {
+    FileHeader_lt fileHeader;
+    if(size<sizeof(fileHeader))
+    {
+      tpWarning() << "Progress events trace is too small: " << path;
+      return false;
+    }
+
+    std::memcpy(&fileHeader, data, sizeof(fileHeader));
+    if(fileHeader.magic != fileMagic_lt || fileHeader.version != version_lt)
+    {
+      tpWarning() << "Not a progress events trace, or an unsupported version: " << path;
+      return false;
+    }
+
+    size_t offset = sizeof(fileHeader);
+    while(offset<size)
+    {
+      BlockHeader_lt header;
+      if(size-offset<sizeof(header))
+      {
+        tpWarning() << "Progress events trace ends with a partial block header: " << path;
+        break;
+      }
+
+      std::memcpy(&header, data+offset, sizeof(header));
+      if(header.magic != blockMagic_lt ||
+         header.blockBytes != blockBytes_lt(header.count, header.nameCount, header.nameBytes))
+      {
+        tpWarning() << "Progress events trace has a corrupt block: " << path;
+        break;
+      }
+
+      if(header.blockBytes>size-offset)
+      {
+        tpWarning() << "Progress events trace ends with a partial block: " << path;
+        break;
+      }
+
+      const char* p = data + offset + sizeof(header);
+      offset += header.blockBytes;
+
+      auto lengths = reinterpret_cast<const uint32_t*>(p);
+      const char* name = p + header.nameCount*sizeof(uint32_t);
+      const char* namesEnd = name + header.nameBytes;
+      for(size_t i=0; i<header.nameCount; i++)
+      {
+        if(size_t(namesEnd-name)<lengths[i])
+        {
+          tpWarning() << "Progress events trace has a corrupt name table: " << path;
+          return !blocks.empty();
+        }
+
+        names.emplace_back(name, lengths[i]);
+        name += lengths[i];
+      }
+      p += pad8_lt(header.nameCount*sizeof(uint32_t) + header.nameBytes);
+
+      size_t count = header.count;
+      auto& block = blocks.emplace_back();
+      block.count = count;
+      block.ids       = reinterpret_cast<const int64_t*>(p); p += count*sizeof(int64_t);
+      block.parentIds = reinterpret_cast<const int64_t*>(p); p += count*sizeof(int64_t);
+      block.starts    = reinterpret_cast<const int64_t*>(p); p += count*sizeof(int64_t);
+      block.ends      = reinterpret_cast<const int64_t*>(p); p += count*sizeof(int64_t);
+      block.colors    = reinterpret_cast<const uint32_t*>(p); p += pad8_lt(count*sizeof(uint32_t));
+      block.names     = reinterpret_cast<const uint32_t*>(p); p += pad8_lt(count*sizeof(uint32_t));
+      block.active    = reinterpret_cast<const uint8_t*>(p);
+
+      recordCount += count;
+    }
+
+    return true;
+  }
+};
+
+//##################################################################################################
+ProgressEventsTraceFile::ProgressEventsTraceFile():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+ProgressEventsTraceFile::~ProgressEventsTraceFile()
+{
+  close();
+  delete d;
+}
+
+//##################################################################################################
+bool ProgressEventsTraceFile::open(const std::string& path)
+{
+  close();
+
+  d->file.setFileName(QString::fromStdString(path));
+  if(!d->file.open(QIODevice::ReadOnly))
+  {
+    tpWarning() << "Failed to open progress events trace: " << path;
+    return false;
+  }
+
+  // Map the file so that opening doesn't copy it, the OS pages in the columns as they are read.
+  const char* data=nullptr;
+  size_t size = size_t(d->file.size());
+  if(size>0)
+    d->mapped = d->file.map(0, d->file.size());
+
+  if(d->mapped)
+    data = reinterpret_cast<const char*>(d->mapped);
+  else
+  {
+    d->buffer = d->file.readAll();
+    data = d->buffer.constData();
+    size = size_t(d->buffer.size());
+  }
+
+  if(!d->index(data, size, path))
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+void ProgressEventsTraceFile::close()
+{
+  d->blocks.clear();
+  d->names.clear();
+  d->recordCount = 0;
+
+  if(d->mapped)
+  {
+    d->file.unmap(d->mapped);
+    d->mapped = nullptr;
+  }
+
+  d->buffer.clear();
+  d->file.close();
+}
+
+//##################################################################################################
+const std::vector<ProgressEventsTraceBlock>& ProgressEventsTraceFile::blocks() const
+{
+  return d->blocks;
+}
+
+//##################################################################################################
+const std::vector<std::string_view>& ProgressEventsTraceFile::names() const
+{
+  return d->names;
+}
+
+//##################################################################################################
+size_t ProgressEventsTraceFile::recordCount() const
+{
+  return d->recordCount;
+}
+
+//##################################################################################################
+void ProgressEventsTraceFile::progressEvents(std::vector<tp_utils::ProgressEvent>& progressEvents) const
+{
+  using ID = decltype(tp_utils::ProgressEvent::id);
+  std::unordered_map<ID, size_t> indexes;
+  indexes.reserve(d->recordCount);
+
+  progressEvents.clear();
+  progressEvents.reserve(d->recordCount);
+
+  for(const auto& block : d->blocks)
+  {
+    for(size_t r=0; r<block.count; r++)
+    {
+      auto [i, inserted] = indexes.try_emplace(ID(block.ids[r]), progressEvents.size());
+      auto& progressEvent = inserted?progressEvents.emplace_back():progressEvents.at(i->second);
+
+      progressEvent.id = ID(block.ids[r]);
+      progressEvent.parentId = ID(block.parentIds[r]);
+      progressEvent.start = block.starts[r];
+      progressEvent.end = block.ends[r];
+      progressEvent.active = block.active[r];
+      unpackColor_lt(block.colors[r], progressEvent.color);
+
+      if(auto n=block.names[r]; n<d->names.size())
+        progressEvent.name = d->names.at(n);
+      else
+        progressEvent.name.clear();
+    }
+  }
+}
+
+//##################################################################################################
+bool writeProgressEventsTrace(const std::string& path,
+                              const std::vector<tp_utils::ProgressEvent>& progressEvents)
+{
+  ProgressEventsTraceWriter writer;
+  if(!writer.open(path))
+    return false;
+
+  bool ok = writer.write(progressEvents);
+  return writer.close() && ok;
+}
+
+//##################################################################################################
+bool readProgressEventsTrace(const std::string& path,
+                             std::vector<tp_utils::ProgressEvent>& progressEvents)
+{
+  ProgressEventsTraceFile file;
+  if(!file.open(path))
+    return false;
+
+  file.progressEvents(progressEvents);
+  return true;
+}
+
+}
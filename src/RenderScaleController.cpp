@@ -0,0 +1,183 @@
+#include "tp_qt_maps_widget/RenderScaleController.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+struct RenderScaleController::Private
+{
+  //! Scales are rounded to multiples of this to limit the number of distinct buffer sizes.
+  static constexpr float step{0.05f};
+
+  //! The number of frames to wait after a change before making another.
+  static constexpr size_t settleFrames{5};
+
+  //! Frames over target by more than this factor reduce the scale.
+  static constexpr double overBudget{1.15};
+
+  //! Frames under target by more than this factor increase the scale.
+  static constexpr double underBudget{0.6};
+
+  double targetFrameTimeMS{16.6};
+  float minScale{0.5f};
+  double idleDelayMS{250.0};
+
+  double lastInteractionMS{-1.0};
+  double frameCostMS{-1.0};
+  size_t framesSinceChange{0};
+
+  RenderScaleStats stats;
+
+  //################################################################################################
+  float quantize(float scale) const
+  {
+    return std::clamp(std::floor(scale/step + 0.5f) * step, minScale, 1.0f);
+  }
+
+  //################################################################################################
+  void setScale(float scale, RenderScaleReason reason)
+  {
+    stats.scale = scale;
+    stats.lastReason = reason;
+    frameCostMS = -1.0;
+    framesSinceChange = 0;
+  }
+};
+
+//##################################################################################################
+RenderScaleController::RenderScaleController():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+RenderScaleController::~RenderScaleController()
+{
+  delete d;
+}
+
+//##################################################################################################
+void RenderScaleController::setTargetFrameTimeMS(double targetFrameTimeMS)
+{
+  d->targetFrameTimeMS = std::max(1.0, targetFrameTimeMS);
+}
+
+//##################################################################################################
+double RenderScaleController::targetFrameTimeMS() const
+{
+  return d->targetFrameTimeMS;
+}
+
+//##################################################################################################
+void RenderScaleController::setMinScale(float minScale)
+{
+  d->minScale = std::clamp(minScale, Private::step, 1.0f);
+}
+
+//##################################################################################################
+float RenderScaleController::minScale() const
+{
+  return d->minScale;
+}
+
+//##################################################################################################
+void RenderScaleController::setIdleDelayMS(double idleDelayMS)
+{
+  d->idleDelayMS = std::max(0.0, idleDelayMS);
+}
+
+//##################################################################################################
+double RenderScaleController::idleDelayMS() const
+{
+  return d->idleDelayMS;
+}
+
+//##################################################################################################
+void RenderScaleController::interaction(double nowMS)
+{
+  d->lastInteractionMS = nowMS;
+}
+
+//##################################################################################################
+bool RenderScaleController::interacting(double nowMS) const
+{
+  return d->lastInteractionMS>=0.0 && (nowMS-d->lastInteractionMS)<d->idleDelayMS;
+}
+
+//##################################################################################################
+double RenderScaleController::idleRemainingMS(double nowMS) const
+{
+  if(!interacting(nowMS))
+    return 0.0;
+
+  return d->idleDelayMS - (nowMS-d->lastInteractionMS);
+}
+
+//##################################################################################################
+bool RenderScaleController::addFrameCost(double frameCostMS, double nowMS)
+{
+  // Smooth out single slow frames, a hitch should not halve the resolution.
+  d->frameCostMS = (d->frameCostMS<0.0)?frameCostMS:(d->frameCostMS*0.7 + frameCostMS*0.3);
+  d->stats.frameCostMS = d->frameCostMS;
+  d->framesSinceChange++;
+
+  if(!interacting(nowMS) || d->framesSinceChange<Private::settleFrames)
+    return false;
+
+  float scale = d->stats.scale;
+  if(d->frameCostMS > d->targetFrameTimeMS*Private::overBudget)
+  {
+    float target = scale * float(std::sqrt(d->targetFrameTimeMS / d->frameCostMS));
+    float newScale = d->quantize(std::min(target, scale-Private::step));
+    if(newScale<scale)
+    {
+      d->stats.decreases++;
+      d->setScale(newScale, RenderScaleReason::OverBudget);
+      return true;
+    }
+  }
+  else if(d->frameCostMS < d->targetFrameTimeMS*Private::underBudget && scale<1.0f)
+  {
+    d->stats.increases++;
+    d->setScale(d->quantize(scale+Private::step), RenderScaleReason::UnderBudget);
+    return true;
+  }
+
+  return false;
+}
+
+//##################################################################################################
+bool RenderScaleController::checkIdle(double nowMS)
+{
+  if(d->stats.scale>=1.0f || interacting(nowMS))
+    return false;
+
+  d->stats.restores++;
+  d->setScale(1.0f, RenderScaleReason::Idle);
+  return true;
+}
+
+//##################################################################################################
+void RenderScaleController::reset()
+{
+  d->setScale(1.0f, RenderScaleReason::Reset);
+  d->lastInteractionMS = -1.0;
+}
+
+//##################################################################################################
+float RenderScaleController::scale() const
+{
+  return d->stats.scale;
+}
+
+//##################################################################################################
+RenderScaleStats RenderScaleController::stats() const
+{
+  return d->stats;
+}
+
+}
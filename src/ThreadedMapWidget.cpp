@@ -0,0 +1,523 @@
+#include "tp_qt_maps_widget/ThreadedMapWidget.h"
+#include "tp_qt_maps_widget/OffscreenMapRenderer.h"
+#include "tp_qt_maps_widget/ConvertEvents.h"
+#include "tp_qt_maps_widget/IdleTicks.h"
+
+#include "tp_maps/subsystems/open_gl/OpenGL.h"
+
+#include "tp_utils/DebugUtils.h"
+#include "tp_utils/TimeUtils.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLTextureBlitter>
+#include <QThread>
+#include <QTimer>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QKeyEvent>
+
+#include <algorithm>
+#include <mutex>
+
+namespace tp_qt_maps_widget
+{
+
+//##################################################################################################
+struct ThreadedMapWidget::Private
+{
+  TP_REF_COUNT_OBJECTS("tp_qt_maps_widget::ThreadedMapWidget::Private");
+  TP_NONCOPYABLE(Private);
+
+  //! One buffer being rendered, one waiting to be displayed, and one being displayed.
+  static constexpr int bufferCount{3};
+
+  Q* q;
+
+  QThread thread;
+
+  // These live on the render thread.
+  QObject* worker{nullptr};
+  OffscreenMapRenderer* renderer{nullptr};
+  QTimer* animationTimer{nullptr};
+  int64_t animationInterval{16};
+  IdleTicks idleTicks;
+  std::vector<std::function<void(tp_maps::Map*)>> pendingCallbacks;
+
+  // Guarded by mutex, shared between the render thread and the GUI thread.
+  mutable std::mutex mutex;
+  int ready{-1};
+  int displayed{-1};
+  GLuint readyTexture{0};
+  GLsync readyFence{nullptr};
+  GLsync readFences[bufferCount]{}; //!< Signalled when the GUI has finished reading each buffer.
+  bool buffersRecreated{false};
+  ThreadedRenderStats stats;
+
+  // These live on the GUI thread.
+  std::unique_ptr<QOpenGLTextureBlitter> blitter;
+  GLuint displayedTexture{0};
+  bool stopAnimationWhenIdle{true};
+
+  //################################################################################################
+  Private(Q* q_):
+    q(q_)
+  {
+
+  }
+
+  //################################################################################################
+  //! Queue work for the render thread, callbacks are called in the order that they were posted.
+  void post(const std::function<void()>& callback)
+  {
+    QMetaObject::invokeMethod(worker, callback, Qt::QueuedConnection);
+  }
+
+  //################################################################################################
+  //! Called on the render thread.
+  void initializeRenderThread()
+  {
+    renderer->setBufferCount(bufferCount);
+    if(!renderer->initialize())
+      return;
+
+    animationTimer = new QTimer();
+    animationTimer->setInterval(int(animationInterval));
+    QObject::connect(animationTimer, &QTimer::timeout, worker, [&]{tick();});
+    QObject::connect(renderer, &OffscreenMapRenderer::updateRequested, worker, [&]{startTicking();});
+
+    renderer->setTime(double(tp_utils::currentTimeMS()));
+
+    for(const auto& callback : pendingCallbacks)
+      callback(renderer->map());
+    pendingCallbacks.clear();
+
+    startTicking();
+  }
+
+  //################################################################################################
+  //! Called on the render thread.
+  void releaseRenderThread()
+  {
+    delete animationTimer;
+    animationTimer = nullptr;
+
+    // The fences must be deleted while the context that they are shared with is still current.
+    renderer->makeCurrent();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      deleteFences();
+    }
+
+    renderer->release();
+    renderer->moveToThread(q->thread());
+  }
+
+  //################################################################################################
+  //! Delete the ready fence and the read fences, called with mutex held and a context current.
+  void deleteFences()
+  {
+    if(readyFence)
+      glDeleteSync(readyFence);
+    readyFence = nullptr;
+
+    for(auto& fence : readFences)
+    {
+      if(fence)
+        glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  //################################################################################################
+  //! Called on the render thread.
+  void startTicking()
+  {
+    idleTicks.reset();
+    if(animationTimer && !animationTimer->isActive())
+      animationTimer->start();
+  }
+
+  //################################################################################################
+  //! Called on the render thread.
+  void tick()
+  {
+    renderer->stepFrame(double(tp_utils::currentTimeMS()) - renderer->time());
+
+    bool needsRender = renderer->needsRender();
+    if(idleTicks.tick(needsRender))
+      animationTimer->stop();
+
+    if(needsRender)
+      renderFrame();
+  }
+
+  //################################################################################################
+  //! Called on the render thread.
+  void renderFrame()
+  {
+    int buffer=0;
+    GLsync readFence=nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      while(buffer == ready || buffer == displayed)
+        buffer++;
+
+      readFence = readFences[buffer];
+      readFences[buffer] = nullptr;
+    }
+
+    // The GUI may still be reading this buffer on the GPU, make our context wait for it to finish.
+    renderer->makeCurrent();
+    if(readFence)
+    {
+      glWaitSync(readFence, 0, GL_TIMEOUT_IGNORED);
+      glDeleteSync(readFence);
+    }
+
+    renderer->setCurrentBuffer(size_t(buffer));
+    renderer->render();
+
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(readyFence)
+      {
+        glDeleteSync(readyFence);
+        stats.skipped++;
+      }
+
+      ready = buffer;
+      readyTexture = renderer->texture(size_t(buffer));
+      readyFence = fence;
+      stats.rendered++;
+    }
+
+    QMetaObject::invokeMethod(q, [q=q]{q->update();}, Qt::QueuedConnection);
+  }
+
+  //################################################################################################
+  //! Called on the render thread, the GUI thread is blocked waiting for this.
+  void resize(int width, int height)
+  {
+    if(!renderer->isValid() || (renderer->width()==width && renderer->height()==height))
+      return;
+
+    renderer->resize(width, height);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    deleteFences();
+    ready = -1;
+    displayed = -1;
+    buffersRecreated = true;
+
+    renderer->map()->update();
+  }
+
+  //################################################################################################
+  //! Record that the GUI has queued its reads of the displayed buffer, called on the GUI thread.
+  void displayedRead()
+  {
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // The fence must be flushed before another context can wait on it.
+    glFlush();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(displayed<0)
+    {
+      glDeleteSync(fence);
+      return;
+    }
+
+    if(readFences[displayed])
+      glDeleteSync(readFences[displayed]);
+    readFences[displayed] = fence;
+  }
+
+  //################################################################################################
+  //! Take the newest finished frame if there is one, called on the GUI thread.
+  void takeReadyFrame()
+  {
+    GLsync fence=nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(buffersRecreated)
+      {
+        displayedTexture = 0;
+        buffersRecreated = false;
+      }
+
+      if(ready<0)
+        return;
+
+      displayed = ready;
+      displayedTexture = readyTexture;
+      fence = readyFence;
+      ready = -1;
+      readyFence = nullptr;
+      stats.displayed++;
+    }
+
+    // Make our context wait on the GPU for the render thread, without blocking the CPU.
+    if(fence)
+    {
+      glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+      glDeleteSync(fence);
+    }
+  }
+};
+
+//##################################################################################################
+ThreadedMapWidget::ThreadedMapWidget(QWidget* parent):
+  QOpenGLWidget(parent),
+  d(new Private(this))
+{
+  setFocusPolicy(Qt::StrongFocus);
+
+  // The renderer is created here because its offscreen surface must be created on the GUI thread.
+  d->renderer = new OffscreenMapRenderer(1, 1);
+  d->renderer->moveToThread(&d->thread);
+
+  d->worker = new QObject();
+  d->worker->moveToThread(&d->thread);
+
+  d->thread.start();
+}
+
+//##################################################################################################
+ThreadedMapWidget::~ThreadedMapWidget()
+{
+  QMetaObject::invokeMethod(d->worker, [&]{d->releaseRenderThread();}, Qt::BlockingQueuedConnection);
+  d->thread.quit();
+  d->thread.wait();
+
+  delete d->worker;
+  delete d->renderer;
+
+  if(d->blitter)
+  {
+    makeCurrent();
+    d->blitter.reset();
+    doneCurrent();
+  }
+
+  delete d;
+}
+
+//##################################################################################################
+void ThreadedMapWidget::callInRenderThread(const std::function<void(tp_maps::Map*)>& callback)
+{
+  d->post([&, callback]
+  {
+    if(!d->renderer->isValid())
+    {
+      d->pendingCallbacks.push_back(callback);
+      return;
+    }
+
+    callback(d->renderer->map());
+    d->startTicking();
+  });
+}
+
+//##################################################################################################
+tp_maps::Map* ThreadedMapWidget::map()
+{
+  return d->renderer->map();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::setAnimationInterval(int64_t interval)
+{
+  d->post([&, interval]
+  {
+    d->animationInterval = interval;
+    if(d->animationTimer)
+      d->animationTimer->setInterval(int(interval));
+  });
+}
+
+//##################################################################################################
+void ThreadedMapWidget::setStopAnimationWhenIdle(bool stopAnimationWhenIdle)
+{
+  d->stopAnimationWhenIdle = stopAnimationWhenIdle;
+  d->post([&, stopAnimationWhenIdle]
+  {
+    d->idleTicks.stopWhenIdle = stopAnimationWhenIdle;
+    d->startTicking();
+  });
+}
+
+//##################################################################################################
+bool ThreadedMapWidget::stopAnimationWhenIdle() const
+{
+  return d->stopAnimationWhenIdle;
+}
+
+//##################################################################################################
+ThreadedRenderStats ThreadedMapWidget::renderStats() const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return d->stats;
+}
+
+//##################################################################################################
+QSize ThreadedMapWidget::minimumSizeHint() const
+{
+  return QSize(50, 50);
+}
+
+//##################################################################################################
+QSize ThreadedMapWidget::sizeHint() const
+{
+  return QSize(200, 200);
+}
+
+//##################################################################################################
+void ThreadedMapWidget::initializeGL()
+{
+  d->blitter = std::make_unique<QOpenGLTextureBlitter>();
+  d->blitter->create();
+
+  // This gets called again if the widget is moved to another window, the render thread survives.
+  if(d->renderer->isValid())
+    return;
+
+  QOpenGLContext* shareContext = QOpenGLContext::globalShareContext();
+  if(!shareContext)
+    shareContext = context();
+
+  // Some platforms can't share with a context that is current on another thread.
+  doneCurrent();
+  QMetaObject::invokeMethod(d->worker, [&]
+  {
+    d->renderer->setShareContext(shareContext);
+    d->initializeRenderThread();
+  }, Qt::BlockingQueuedConnection);
+  makeCurrent();
+
+  if(!d->renderer->isValid())
+  {
+    tpWarning() << "ThreadedMapWidget failed to start the render thread.";
+    return;
+  }
+
+  Q_EMIT initialized();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::resizeGL(int width, int height)
+{
+  int w = std::max(1, int(width*devicePixelRatio()));
+  int h = std::max(1, int(height*devicePixelRatio()));
+
+  // The render thread may delete the textures that we are still drawing from.
+  glFinish();
+
+  QMetaObject::invokeMethod(d->worker, [&]{d->resize(w, h);}, Qt::BlockingQueuedConnection);
+}
+
+//##################################################################################################
+void ThreadedMapWidget::paintGL()
+{
+  d->takeReadyFrame();
+
+  glDisable(GL_BLEND);
+  glDisable(GL_DEPTH_TEST);
+
+  if(!d->displayedTexture)
+  {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    return;
+  }
+
+  d->blitter->bind();
+  d->blitter->blit(d->displayedTexture, QMatrix4x4(), QOpenGLTextureBlitter::OriginBottomLeft);
+  d->blitter->release();
+
+  d->displayedRead();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::mousePressEvent(QMouseEvent* event)
+{
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Press, event, devicePixelRatio());
+  d->post([&, e]{d->renderer->mouseEvent(e);});
+  event->accept();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::mouseMoveEvent(QMouseEvent* event)
+{
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Move, event, devicePixelRatio());
+  d->post([&, e]{d->renderer->mouseEvent(e);});
+  event->accept();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::mouseReleaseEvent(QMouseEvent* event)
+{
+  auto e = convertMouseEvent(tp_maps::MouseEventType::Release, event, devicePixelRatio());
+  d->post([&, e]{d->renderer->mouseEvent(e);});
+  event->accept();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::wheelEvent(QWheelEvent* event)
+{
+  auto e = convertWheelEvent(event, devicePixelRatio());
+  d->post([&, e]{d->renderer->mouseEvent(e);});
+  event->accept();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::mouseDoubleClickEvent(QMouseEvent* event)
+{
+  auto e = convertMouseEvent(tp_maps::MouseEventType::DoubleClick, event, devicePixelRatio());
+  d->post([&, e]{d->renderer->mouseEvent(e);});
+  event->accept();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::keyPressEvent(QKeyEvent* event)
+{
+  auto e = convertKeyEvent(tp_maps::KeyEventType::Press, event);
+  d->post([&, e]{d->renderer->keyEvent(e);});
+  event->accept();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::keyReleaseEvent(QKeyEvent* event)
+{
+  auto e = convertKeyEvent(tp_maps::KeyEventType::Release, event);
+  d->post([&, e]{d->renderer->keyEvent(e);});
+  event->accept();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::hideEvent(QHideEvent* event)
+{
+  d->post([&]
+  {
+    d->renderer->setVisible(false);
+    if(d->animationTimer)
+      d->animationTimer->stop();
+  });
+  event->accept();
+}
+
+//##################################################################################################
+void ThreadedMapWidget::showEvent(QShowEvent* event)
+{
+  d->post([&]
+  {
+    d->renderer->setVisible(true);
+    d->startTicking();
+  });
+  event->accept();
+}
+
+}
@@ -0,0 +1,245 @@
+#include "tp_qt_maps_widget/MaterialDelta.h"
+
+#include <cmath>
+#include <iostream>
+
+// Round trips material edits through diffMaterials, MaterialDelta::apply, and MaterialDelta::merge,
+// and checks the slider mapping of every field. Returns the number of failed checks.
+
+namespace
+{
+size_t failures_lt{0};
+
+//##################################################################################################
+void check_lt(bool ok, const std::string& what)
+{
+  if(!ok)
+  {
+    std::cerr << "FAIL: " << what << '\n';
+    failures_lt++;
+  }
+}
+
+//##################################################################################################
+//! A value for field that differs from its current value in material.
+tp_qt_maps_widget::MaterialFieldValue changedValue_lt(const tp_math_utils::Material& material, size_t field)
+{
+  using namespace tp_qt_maps_widget;
+  const auto& f = materialFields().at(field);
+  auto value = materialFieldValue(material, field);
+
+  auto changeFloat = [&](float v)
+  {
+    return (v == f.fromSlider(0.37f))?f.fromSlider(0.71f):f.fromSlider(0.37f);
+  };
+
+  switch(f.type)
+  {
+    case MaterialFieldType::Float:
+    value.f = changeFloat(value.f);
+    break;
+
+    case MaterialFieldType::Color:
+    value.f = changeFloat(value.f);
+    value.v = (value.v == glm::vec3(0.1f, 0.2f, 0.3f))?glm::vec3(0.3f, 0.2f, 0.1f):glm::vec3(0.1f, 0.2f, 0.3f);
+    break;
+
+    case MaterialFieldType::Bool:
+    value.b = !value.b;
+    break;
+
+    case MaterialFieldType::Vec3:
+    value.v = glm::vec3(changeFloat(value.v.x), changeFloat(value.v.y), changeFloat(value.v.z));
+    break;
+
+    case MaterialFieldType::Choice:
+    for(auto choice : f.choices)
+    {
+      if(choice && value.s != choice)
+      {
+        value.s = choice;
+        break;
+      }
+    }
+    break;
+  }
+
+  return value;
+}
+
+//##################################################################################################
+//! The name of a field for messages.
+std::string fieldName_lt(size_t field)
+{
+  const auto& f = tp_qt_maps_widget::materialFields().at(field);
+  return std::string(f.section) + "/" + f.name;
+}
+
+//##################################################################################################
+void testEmpty_lt()
+{
+  tp_math_utils::Material a;
+  tp_math_utils::Material b;
+  auto delta = tp_qt_maps_widget::diffMaterials(a, b);
+  check_lt(delta.empty(), "empty: identical materials should give an empty delta");
+}
+
+//##################################################################################################
+void testEachField_lt()
+{
+  using namespace tp_qt_maps_widget;
+
+  for(size_t i=0; i<materialFields().size(); i++)
+  {
+    auto test = "field " + fieldName_lt(i);
+
+    tp_math_utils::Material from;
+    tp_math_utils::Material to;
+    auto value = changedValue_lt(from, i);
+    setMaterialFieldValue(to, i, value);
+
+    auto delta = diffMaterials(from, to);
+    check_lt(delta.fields.size() == 1, test + ": delta should change one field, it changes " + std::to_string(delta.fields.size()));
+    if(delta.fields.size() == 1)
+      check_lt(delta.fields.front().field == i, test + ": delta changes " + fieldName_lt(delta.fields.front().field));
+    check_lt(delta.textures.empty() && !delta.nameChanged && !delta.blendFileChanged, test + ": delta should only change fields");
+
+    delta.apply(from);
+    check_lt(materialFieldValue(from, i) == value, test + ": apply should set the value");
+    check_lt(diffMaterials(from, to).empty(), test + ": apply should make the materials equal");
+  }
+}
+
+//##################################################################################################
+void testAllFields_lt()
+{
+  using namespace tp_qt_maps_widget;
+  std::string test = "all fields";
+
+  tp_math_utils::Material from;
+  tp_math_utils::Material to;
+  for(size_t i=0; i<materialFields().size(); i++)
+    setMaterialFieldValue(to, i, changedValue_lt(from, i));
+
+  to.name = "Changed";
+  setMaterialBlendFile(to, "scenes/changed.blend");
+
+  std::string textureType;
+  viewMaterialTextureTypes(to, [&](const std::string& type, const std::string&)
+  {
+    if(textureType.empty())
+      textureType = type;
+  });
+  if(!textureType.empty())
+    setMaterialTexture(to, textureType, "changed.png");
+
+  auto delta = diffMaterials(from, to);
+  check_lt(delta.fields.size() == materialFields().size(), test + ": every field should change");
+  check_lt(delta.nameChanged && delta.name == "Changed", test + ": name");
+  check_lt(delta.blendFileChanged && delta.blendFile == "scenes/changed.blend", test + ": blend file");
+  check_lt(textureType.empty() || (delta.textures.size() == 1 && delta.textures.front().name == "changed.png"), test + ": texture");
+
+  delta.apply(from);
+  check_lt(diffMaterials(from, to).empty(), test + ": apply should make the materials equal");
+
+  // Changes are written into the material as it is, so the delta applies over other edits too.
+  tp_math_utils::Material other;
+  other.name = "Other";
+  delta.apply(other);
+  check_lt(diffMaterials(other, to).empty(), test + ": apply onto another material");
+
+  // Removing the blend file.
+  MaterialDelta remove;
+  remove.setBlendFile("");
+  remove.apply(other);
+  check_lt(materialBlendFile(other).empty(), test + ": an empty blend file removes it");
+}
+
+//##################################################################################################
+void testMerge_lt()
+{
+  using namespace tp_qt_maps_widget;
+  std::string test = "merge";
+
+  tp_math_utils::Material material;
+  auto first = changedValue_lt(material, 0);
+  MaterialDelta a;
+  a.setField(0, first);
+  a.setField(1, changedValue_lt(material, 1));
+  a.setName("First");
+
+  tp_math_utils::Material changed;
+  setMaterialFieldValue(changed, 0, first);
+  auto second = changedValue_lt(changed, 0);
+
+  MaterialDelta b;
+  b.setField(0, second);
+  b.setField(2, changedValue_lt(material, 2));
+  b.setBlendFile("b.blend");
+
+  a.merge(b);
+  check_lt(a.fields.size() == 3, test + ": each field should appear once, found " + std::to_string(a.fields.size()));
+  for(const auto& change : a.fields)
+    if(change.field == 0)
+      check_lt(change.value == second, test + ": the value from the merged delta should win");
+  check_lt(a.nameChanged && a.name == "First", test + ": name kept");
+  check_lt(a.blendFileChanged && a.blendFile == "b.blend", test + ": blend file merged");
+
+  MaterialDelta empty;
+  a.merge(empty);
+  check_lt(a.fields.size() == 3 && a.nameChanged && a.blendFileChanged, test + ": merging an empty delta changes nothing");
+  check_lt(!a.empty() && empty.empty(), test + ": empty");
+}
+
+//##################################################################################################
+void testSliderMapping_lt()
+{
+  using namespace tp_qt_maps_widget;
+
+  for(size_t i=0; i<materialFields().size(); i++)
+  {
+    const auto& f = materialFields().at(i);
+    if(f.type != MaterialFieldType::Float && f.type != MaterialFieldType::Color)
+      continue;
+
+    auto test = "slider " + fieldName_lt(i);
+    float tolerance = 1.0e-4f;
+
+    check_lt(std::fabs(f.fromSlider(0.0f) - f.min) <= tolerance*std::fabs(f.max-f.min), test + ": 0 should map to min");
+    check_lt(std::fabs(f.fromSlider(1.0f) - f.max) <= tolerance*std::fabs(f.max-f.min), test + ": 1 should map to max");
+
+    for(int s=0; s<=100; s++)
+    {
+      float slider = float(s)/100.0f;
+      float back = f.toSlider(f.fromSlider(slider));
+      if(std::fabs(back-slider) > 1.0e-3f)
+      {
+        check_lt(false, test + ": round trip of " + std::to_string(slider) + " gave " + std::to_string(back));
+        break;
+      }
+    }
+
+    check_lt(f.toSlider(f.min - (f.max-f.min)) == 0.0f, test + ": below min should clamp to 0");
+    check_lt(f.toSlider(f.max + (f.max-f.min)) == 1.0f, test + ": above max should clamp to 1");
+  }
+}
+}
+
+//##################################################################################################
+int main()
+{
+  testEmpty_lt();
+  testEachField_lt();
+  testAllFields_lt();
+  testMerge_lt();
+  testSliderMapping_lt();
+
+  if(failures_lt)
+  {
+    std::cerr << failures_lt << " checks failed\n";
+    return 1;
+  }
+
+  std::cout << "All material delta tests passed\n";
+  return 0;
+}
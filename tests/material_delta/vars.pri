@@ -0,0 +1,4 @@
+TARGET = tp_qt_maps_widget_test_material_delta
+TEMPLATE = app
+
+SOURCES += src/main.cpp
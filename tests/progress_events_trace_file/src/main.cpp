@@ -0,0 +1,220 @@
+#include "tp_qt_maps_widget/ProgressEventsTraceFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+// Round trips progress events through ProgressEventsTraceWriter and the memory mapped
+// ProgressEventsTraceFile and checks every field. Returns the number of failed checks.
+
+namespace
+{
+size_t failures_lt{0};
+
+//##################################################################################################
+void check_lt(bool ok, const std::string& what)
+{
+  if(!ok)
+  {
+    std::cerr << "FAIL: " << what << '\n';
+    failures_lt++;
+  }
+}
+
+//##################################################################################################
+tp_utils::ProgressEvent event_lt(int64_t id, int64_t parentId, const std::string& name, int64_t start, int64_t end, bool active)
+{
+  tp_utils::ProgressEvent event;
+  event.id = id;
+  event.parentId = parentId;
+  event.name = name;
+  event.start = start;
+  event.end = end;
+  event.active = active;
+  event.color.r = uint8_t(id*7);
+  event.color.g = uint8_t(id*13);
+  event.color.b = uint8_t(id*29);
+  event.color.a = uint8_t(255-id);
+  return event;
+}
+
+//##################################################################################################
+//! What reading should give, each id in order of its first record with the fields of its last.
+std::vector<tp_utils::ProgressEvent> expected_lt(const std::vector<tp_utils::ProgressEvent>& records)
+{
+  std::vector<tp_utils::ProgressEvent> events;
+  std::unordered_map<int64_t, size_t> indexes;
+  for(const auto& record : records)
+  {
+    auto [i, inserted] = indexes.try_emplace(record.id, events.size());
+    if(inserted)
+      events.push_back(record);
+    else
+      events.at(i->second) = record;
+  }
+  return events;
+}
+
+//##################################################################################################
+void compare_lt(const std::vector<tp_utils::ProgressEvent>& expected,
+                const std::vector<tp_utils::ProgressEvent>& actual,
+                const std::string& test)
+{
+  check_lt(expected.size() == actual.size(), test + ": event count " + std::to_string(actual.size()) + " expected " + std::to_string(expected.size()));
+
+  for(size_t i=0; i<std::min(expected.size(), actual.size()); i++)
+  {
+    const auto& e = expected.at(i);
+    const auto& a = actual.at(i);
+    auto where = test + ": event " + std::to_string(i) + " ";
+    check_lt(e.id       == a.id      , where + "id");
+    check_lt(e.parentId == a.parentId, where + "parentId");
+    check_lt(e.name     == a.name    , where + "name");
+    check_lt(e.start    == a.start   , where + "start");
+    check_lt(e.end      == a.end     , where + "end");
+    check_lt(e.active   == a.active  , where + "active");
+    check_lt(e.color.r == a.color.r && e.color.g == a.color.g && e.color.b == a.color.b && e.color.a == a.color.a, where + "color");
+  }
+}
+
+//##################################################################################################
+//! Records written in several calls and blocks, with active events written again when they end.
+std::vector<tp_utils::ProgressEvent> records_lt()
+{
+  std::vector<tp_utils::ProgressEvent> records;
+  records.push_back(event_lt(1, 0, "root", 0, 0, true));
+  for(int64_t i=2; i<200; i++)
+    records.push_back(event_lt(i, 1+(i%7==0?0:(i/3)), "task " + std::to_string(i%17), i*10, i*10+i, i%5==0));
+
+  // Names that are empty, long, and not ASCII, and an id that also appears in a later block.
+  records.push_back(event_lt(500, 1, "", 5, 6, false));
+  records.push_back(event_lt(501, 1, std::string(1000, 'x'), 7, 8, false));
+  records.push_back(event_lt(502, 1, "\xc3\xa9v\xc3\xa9nement", 9, 10, true));
+
+  // Active events finishing, the last record for each id should win.
+  for(int64_t i=5; i<200; i+=5)
+    records.push_back(event_lt(i, 1+(i%7==0?0:(i/3)), "task " + std::to_string(i%17), i*10, i*10+i*2, false));
+  records.push_back(event_lt(502, 1, "renamed", 9, 99, false));
+  records.push_back(event_lt(1, 0, "root", 0, 5000, false));
+
+  return records;
+}
+
+//##################################################################################################
+void testRoundTrip_lt(const std::filesystem::path& path, size_t blockSize, size_t batch)
+{
+  auto test = "round trip, block size " + std::to_string(blockSize) + ", batch " + std::to_string(batch);
+  auto records = records_lt();
+
+  {
+    tp_qt_maps_widget::ProgressEventsTraceWriter writer(blockSize);
+    check_lt(writer.open(path.string()), test + ": open for writing");
+    for(size_t r=0; r<records.size(); r+=batch)
+    {
+      std::vector<tp_utils::ProgressEvent> part(records.begin()+ptrdiff_t(r), records.begin()+ptrdiff_t(std::min(r+batch, records.size())));
+      check_lt(writer.write(part), test + ": write");
+    }
+    check_lt(writer.close(), test + ": close");
+  }
+
+  tp_qt_maps_widget::ProgressEventsTraceFile file;
+  check_lt(file.open(path.string()), test + ": open for reading");
+  check_lt(file.recordCount() == records.size(), test + ": record count");
+  check_lt(file.blocks().size() >= (records.size()+blockSize-1)/blockSize, test + ": block count");
+
+  // The raw columns hold every record in the order written.
+  size_t r=0;
+  for(const auto& block : file.blocks())
+  {
+    for(size_t i=0; i<block.count && r<records.size(); i++, r++)
+    {
+      const auto& record = records.at(r);
+      check_lt(block.ids[i] == record.id && block.starts[i] == record.start && block.ends[i] == record.end, test + ": record " + std::to_string(r));
+      check_lt(block.names[i]<file.names().size() && file.names().at(block.names[i]) == record.name, test + ": record name " + std::to_string(r));
+    }
+  }
+
+  std::vector<tp_utils::ProgressEvent> events;
+  file.progressEvents(events);
+  compare_lt(expected_lt(records), events, test);
+}
+
+//##################################################################################################
+void testTruncated_lt(const std::filesystem::path& path)
+{
+  std::string test = "truncated";
+  auto records = records_lt();
+
+  {
+    tp_qt_maps_widget::ProgressEventsTraceWriter writer(64);
+    check_lt(writer.open(path.string()), test + ": open for writing");
+    check_lt(writer.write(records), test + ": write");
+    check_lt(writer.close(), test + ": close");
+  }
+
+  // Cut the last block short, the complete blocks before it should still be read.
+  auto size = std::filesystem::file_size(path);
+  std::filesystem::resize_file(path, size-16);
+
+  tp_qt_maps_widget::ProgressEventsTraceFile file;
+  check_lt(file.open(path.string()), test + ": open for reading");
+
+  size_t complete = (records.size()/64)*64;
+  check_lt(file.recordCount() == complete, test + ": record count " + std::to_string(file.recordCount()));
+
+  std::vector<tp_utils::ProgressEvent> events;
+  file.progressEvents(events);
+  compare_lt(expected_lt({records.begin(), records.begin()+ptrdiff_t(complete)}), events, test);
+}
+
+//##################################################################################################
+void testNotATrace_lt(const std::filesystem::path& path)
+{
+  std::ofstream(path) << "[{\"name\": \"not a trace\"}]";
+  tp_qt_maps_widget::ProgressEventsTraceFile file;
+  check_lt(!file.open(path.string()), "not a trace: open should fail");
+}
+
+//##################################################################################################
+void testWriteFailure_lt()
+{
+  // Writes to /dev/full fail with no space left, the failure should reach the caller.
+  if(!std::filesystem::exists("/dev/full"))
+    return;
+
+  std::string test = "write failure";
+  tp_qt_maps_widget::ProgressEventsTraceWriter writer(16);
+  if(!writer.open("/dev/full"))
+    return;
+
+  check_lt(!writer.write(records_lt()), test + ": write should fail");
+  check_lt(!writer.write(records_lt()), test + ": writes after a failure should fail");
+  check_lt(!writer.close(), test + ": close should fail");
+}
+}
+
+//##################################################################################################
+int main()
+{
+  auto path = std::filesystem::temp_directory_path() / "tp_qt_maps_widget_test_progress_events_trace_file.tpe";
+
+  testRoundTrip_lt(path, 65536, 1000);
+  testRoundTrip_lt(path, 64, 1000);
+  testRoundTrip_lt(path, 7, 3);
+  testRoundTrip_lt(path, 1, 1);
+  testTruncated_lt(path);
+  testNotATrace_lt(path);
+  testWriteFailure_lt();
+
+  std::filesystem::remove(path);
+
+  if(failures_lt)
+  {
+    std::cerr << failures_lt << " checks failed\n";
+    return 1;
+  }
+
+  std::cout << "All progress events trace file tests passed\n";
+  return 0;
+}
@@ -0,0 +1,4 @@
+TARGET = tp_qt_maps_widget_test_progress_events_trace_file
+TEMPLATE = app
+
+SOURCES += src/main.cpp
@@ -9,12 +9,51 @@ HEADERS += inc/tp_qt_maps_widget/Globals.h
 SOURCES += src/MapWidget.cpp
 HEADERS += inc/tp_qt_maps_widget/MapWidget.h
 
+SOURCES += src/MapWindow.cpp
+HEADERS += inc/tp_qt_maps_widget/MapWindow.h
+
+SOURCES += src/CallAsyncQueue.cpp
+HEADERS += inc/tp_qt_maps_widget/CallAsyncQueue.h
+
+SOURCES += src/FrameTimings.cpp
+HEADERS += inc/tp_qt_maps_widget/FrameTimings.h
+
+SOURCES += src/FrameCapture.cpp
+HEADERS += inc/tp_qt_maps_widget/FrameCapture.h
+
+SOURCES += src/RenderScaleController.cpp
+HEADERS += inc/tp_qt_maps_widget/RenderScaleController.h
+
+SOURCES += src/IdleTicks.cpp
+HEADERS += inc/tp_qt_maps_widget/IdleTicks.h
+
+SOURCES += src/HostedMap.cpp
+HEADERS += inc/tp_qt_maps_widget/HostedMap.h
+
+SOURCES += src/ConvertEvents.cpp
+HEADERS += inc/tp_qt_maps_widget/ConvertEvents.h
+
+SOURCES += src/OffscreenMapRenderer.cpp
+HEADERS += inc/tp_qt_maps_widget/OffscreenMapRenderer.h
+
+SOURCES += src/ThreadedMapWidget.cpp
+HEADERS += inc/tp_qt_maps_widget/ThreadedMapWidget.h
+
 SOURCES += src/EditLightWidget.cpp
 HEADERS += inc/tp_qt_maps_widget/EditLightWidget.h
 
 SOURCES += src/EditMaterialWidget.cpp
 HEADERS += inc/tp_qt_maps_widget/EditMaterialWidget.h
 
+SOURCES += src/MaterialFields.cpp
+HEADERS += inc/tp_qt_maps_widget/MaterialFields.h
+
+SOURCES += src/MaterialDelta.cpp
+HEADERS += inc/tp_qt_maps_widget/MaterialDelta.h
+
+SOURCES += src/EditCoalescer.cpp
+HEADERS += inc/tp_qt_maps_widget/EditCoalescer.h
+
 SOURCES += src/EditSwapParametersWidget.cpp
 HEADERS += inc/tp_qt_maps_widget/EditSwapParametersWidget.h
 
@@ -50,3 +89,27 @@ HEADERS += inc/tp_qt_maps_widget/ConfigureFBOLayerWidget.h
 
 SOURCES += src/ProgressEventsGraphWidget.cpp
 HEADERS += inc/tp_qt_maps_widget/ProgressEventsGraphWidget.h
+
+SOURCES += src/ProgressEventsLayout.cpp
+HEADERS += inc/tp_qt_maps_widget/ProgressEventsLayout.h
+
+SOURCES += src/ProgressEventsIndex.cpp
+HEADERS += inc/tp_qt_maps_widget/ProgressEventsIndex.h
+
+SOURCES += src/ProgressEventsLOD.cpp
+HEADERS += inc/tp_qt_maps_widget/ProgressEventsLOD.h
+
+SOURCES += src/ProgressEventsChromeTrace.cpp
+HEADERS += inc/tp_qt_maps_widget/ProgressEventsChromeTrace.h
+
+SOURCES += src/ProgressEventsStats.cpp
+HEADERS += inc/tp_qt_maps_widget/ProgressEventsStats.h
+
+SOURCES += src/ProgressEventsCriticalPath.cpp
+HEADERS += inc/tp_qt_maps_widget/ProgressEventsCriticalPath.h
+
+SOURCES += src/ProgressEventsDiff.cpp
+HEADERS += inc/tp_qt_maps_widget/ProgressEventsDiff.h
+
+SOURCES += src/ProgressEventsTraceFile.cpp
+HEADERS += inc/tp_qt_maps_widget/ProgressEventsTraceFile.h